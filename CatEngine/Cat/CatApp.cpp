@@ -71,6 +71,7 @@ CatApp::CatApp()
 	m_pGlobalDescriptorPool = CatDescriptorPool::Builder( *m_PDevice )
 								  .setMaxSets( CatSwapChain::MAX_FRAMES_IN_FLIGHT )
 								  .addPoolSize( vk::DescriptorType::eUniformBuffer, CatSwapChain::MAX_FRAMES_IN_FLIGHT )
+								  .addPoolSize( vk::DescriptorType::eStorageBuffer, 3 * CatSwapChain::MAX_FRAMES_IN_FLIGHT )
 								  .build();
 
 	m_aUboBuffers = std::vector< std::unique_ptr< CatBuffer > >( CatSwapChain::MAX_FRAMES_IN_FLIGHT );
@@ -84,8 +85,15 @@ CatApp::CatApp()
 	m_pGlobalDescriptorSetLayout =
 		CatDescriptorSetLayout::Builder( *m_PDevice )
 			.addBinding( 0, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eAllGraphics )
+			// Point lights, light clusters and light indices.
+			.addBinding( 1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment )
+			.addBinding( 2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment )
+			.addBinding( 3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment )
 			.build();
 
+	m_pLightClusters = std::make_unique< CatLightClusters >( m_PDevice );
+	m_pGpuTimer = std::make_unique< CatGpuTimer >( m_PDevice, eGpuTimestampCount );
+
 	m_aGlobalDescriptorSets = std::vector< vk::DescriptorSet >( CatSwapChain::MAX_FRAMES_IN_FLIGHT );
 	for ( size_t i = 0; i < m_aGlobalDescriptorSets.size(); i++ )
 	{
@@ -93,6 +101,8 @@ CatApp::CatApp()
 		CatDescriptorWriter( *m_pGlobalDescriptorSetLayout, *m_pGlobalDescriptorPool )
 			.writeBuffer( 0, &bufferInfo )
 			.build( m_aGlobalDescriptorSets[i] );
+		m_pLightClusters->writeDescriptorSet(
+			static_cast< int >( i ), *m_pGlobalDescriptorSetLayout, *m_pGlobalDescriptorPool, m_aGlobalDescriptorSets[i] );
 	}
 }
 
@@ -118,6 +128,7 @@ void CatApp::run()
 	auto yes = CatTexture2D( m_PDevice, "assets/textures/yes.png" );
 	auto tex = CatTexture2D( m_PDevice, "assets/textures/terrain.tga", vk::Format::eR8Srgb, STBI_grey );
 
+	const auto tPipelinesStart = std::chrono::steady_clock::now();
 	CatSimpleRenderSystem simpleRenderSystem{
 		m_PDevice, m_pRenderer->getSwapChainRenderPass(), m_pGlobalDescriptorSetLayout->getDescriptorSetLayout() };
 	CatPointLightRenderSystem pointLightRenderSystem{
@@ -128,6 +139,20 @@ void CatApp::run()
 		m_PDevice, m_pRenderer->getSwapChainRenderPass(), m_pGlobalDescriptorSetLayout->getDescriptorSetLayout() };
 	CatTerrainRenderSystem terrainRenderSystem{ m_PDevice, m_pRenderer->getSwapChainRenderPass(),
 		m_pCurrentLevel->m_PTerrain->m_PDescriptorSetLayout->getDescriptorSetLayout() };
+	if ( m_pDevice->supportsGpuDriven() )
+	{
+		m_pGpuDrivenRenderSystem = std::make_unique< CatGpuDrivenRenderSystem >(
+			m_PDevice, m_pRenderer->getSwapChainRenderPass(), m_pGlobalDescriptorSetLayout->getDescriptorSetLayout() );
+	}
+	else
+	{
+		LOG_F( WARNING, "drawIndexedIndirectCount is not supported, the GPU driven path is disabled" );
+	}
+	LOG_F( INFO, "Created render system pipelines in %.2f ms (%s pipeline cache)",
+		std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - tPipelinesStart ).count(),
+		m_pDevice->getPipelineCache().wasLoaded() ? "warm" : "cold" );
+	// Saved right away as well, so a crash doesn't lose the compiled pipelines.
+	m_pDevice->getPipelineCache().save();
 	CatFrustum frustum;
 
 
@@ -135,7 +160,7 @@ void CatApp::run()
 
 	auto currentTime = std::chrono::high_resolution_clock::now();
 
-	std::shared_ptr< cat::CatObject > pSelectedItem;
+	CatObject* pSelectedItem = nullptr;
 
 	// Main loop
 	while ( !m_PWindow->shouldClose() )
@@ -157,7 +182,10 @@ void CatApp::run()
 			// m_dFrameRate = 1000.0 / ( m_dFrameRate == 0.0 ? 0.001 : m_dFrameRate );
 		}
 
+		m_pCurrentLevel->update();
 		m_pCurrentLevel->loadChunk( m_pCameraObject->m_transform.translation, m_bRenderEverything ? 1000 : 1 );
+		m_pCurrentLevel->prefetchChunks( m_pCameraObject->m_transform.translation, m_dFrameTime );
+		m_assetLoader.setFocus( m_pCameraObject->m_transform.translation );
 
 		if ( m_pCurrentLevel->isLoadingFinished() )
 		{
@@ -184,12 +212,24 @@ void CatApp::run()
 		{
 			short frameIndex = m_pRenderer->getFrameIndex();
 
+			// The fence of this frame index was waited on, resources released by older frames can go now.
+			m_pDevice->releaseDeferred( m_pRenderer->getFrameNumber() );
+
 			m_pFrameInfo->update(
 				commandBuffer, m_aGlobalDescriptorSets[frameIndex], m_dFrameTime, frameIndex, m_pRenderer->getFrameNumber() );
 
 			m_ubo.projection = m_camera.getProjection();
 			m_ubo.view = m_camera.getView();
 			m_ubo.inverseView = m_camera.getInverseView();
+
+			// The lights have to be binned before the UBO is written, it holds the cluster parameters.
+			pointLightRenderSystem.update( getFrameInfo(), m_aPointLights, true );
+			if ( m_pLightClusters->update( frameIndex, m_aPointLights, m_camera.getView(), m_camera.getProjection(), 0.10f,
+					 1000.f, m_pRenderer->getExtent(), m_ubo ) )
+			{
+				m_pLightClusters->writeDescriptorSet(
+					frameIndex, *m_pGlobalDescriptorSetLayout, *m_pGlobalDescriptorPool, m_aGlobalDescriptorSets[frameIndex] );
+			}
 			m_aUboBuffers[getFrameInfo().m_nFrameIndex]->writeToBuffer( &m_ubo );
 			m_aUboBuffers[getFrameInfo().m_nFrameIndex]->flush();
 
@@ -204,6 +244,19 @@ void CatApp::run()
 			}
 			memcpy( m_pCurrentLevel->m_PTerrain->m_Ubo.frustumPlanes, frustum.m_APlanes.data(), sizeof( glm::vec4 ) * 6 );
 
+			// After the lights moved and before the first matrices are read for culling.
+			m_pCurrentLevel->getTransforms().update( &m_tFrameJobs );
+			m_culling.cull( frustum, m_pCurrentLevel->getWorld() );
+
+			// The compute pass can't be recorded inside the render pass.
+			const bool bGpuDriven = m_bGpuDriven && m_pGpuDrivenRenderSystem;
+			if ( bGpuDriven )
+			{
+				m_pGpuDrivenRenderSystem->cull( getFrameInfo(), frustum, m_pCurrentLevel->getWorld() );
+			}
+			// Query resets can't be recorded inside the render pass either.
+			m_pGpuTimer->reset( commandBuffer, frameIndex );
+
 			m_pCurrentLevel->m_PTerrain->m_AUboBuffers[getFrameInfo().m_nFrameIndex]->writeToBuffer(
 				&m_pCurrentLevel->m_PTerrain->m_Ubo );
 			m_pCurrentLevel->m_PTerrain->m_AUboBuffers[getFrameInfo().m_nFrameIndex]->flush();
@@ -215,8 +268,6 @@ void CatApp::run()
 			// start new frame
 			m_pRenderer->beginSwapChainRenderPass( commandBuffer );
 
-			pointLightRenderSystem.update( getFrameInfo(), m_ubo, true );
-
 			cat::CatImgui::createDockSpace();
 
 			ImGuizmo::SetDrawlist( ImGui::GetBackgroundDrawList() );
@@ -233,9 +284,24 @@ void CatApp::run()
 			{
 				terrainRenderSystem.render( getFrameInfo() );
 			}
-			simpleRenderSystem.renderObjects( getFrameInfo() );
-			wireframeRenderSystem.renderObjects( getFrameInfo() );
-			gridRenderSystem.renderObjects( getFrameInfo() );
+			if ( bGpuDriven )
+			{
+				m_pGpuDrivenRenderSystem->renderObjects( getFrameInfo() );
+			}
+
+			m_renderQueue.begin();
+			simpleRenderSystem.submitObjects( getFrameInfo(), m_renderQueue,
+				bGpuDriven ? m_pGpuDrivenRenderSystem.get() : nullptr, m_bDepthPrepass );
+			wireframeRenderSystem.submitObjects( getFrameInfo(), m_renderQueue );
+			gridRenderSystem.submitObjects( getFrameInfo(), m_renderQueue );
+			m_renderQueue.sort();
+			m_pGpuTimer->writeTimestamp( commandBuffer, frameIndex, eGpuPrepassBegin );
+			m_renderQueue.record( commandBuffer, CatRenderQueue::Pass::eDepthPrepass );
+			m_pGpuTimer->writeTimestamp( commandBuffer, frameIndex, eGpuOpaqueBegin );
+			m_renderQueue.record( commandBuffer, CatRenderQueue::Pass::eOpaque );
+			m_pGpuTimer->writeTimestamp( commandBuffer, frameIndex, eGpuOpaqueEnd );
+			m_renderQueue.record( commandBuffer, CatRenderQueue::Pass::eTransparent );
+			m_renderQueue.record( commandBuffer, CatRenderQueue::Pass::eOverlay );
 			pointLightRenderSystem.render( getFrameInfo() );
 
 			ImGuizmo::Enable( true );
@@ -253,10 +319,13 @@ void CatApp::run()
 			if ( ImGui::IsKeyPressed( ImGuiKey_9 ) ) m_eGizmoMode = ImGuizmo::WORLD;
 
 			// glm::vec3 flush{ 1.f, 1.f, 1.f };
+			pSelectedItem = nullptr;
 			if ( getFrameInfo().m_selectedItemId != 0 )
 			{
-				pSelectedItem = m_pCurrentLevel->getAllObjects().at( getFrameInfo().m_selectedItemId );
-
+				pSelectedItem = m_pCurrentLevel->getObject( getFrameInfo().m_selectedItemId );
+			}
+			if ( pSelectedItem )
+			{
 				float mxManipulate[16];
 				ImGuizmo::RecomposeMatrixFromComponents( glm::value_ptr( pSelectedItem->m_transform.translation ),
 					glm::value_ptr( pSelectedItem->m_transform.rotation ), glm::value_ptr( pSelectedItem->m_transform.scale ),
@@ -264,11 +333,14 @@ void CatApp::run()
 				auto isManipulated = ImGuizmo::Manipulate( glm::value_ptr( imguizmoCamera.getView() ),
 					glm::value_ptr( imguizmoCamera.getProjection() ), m_eGizmoOperation, m_eGizmoMode, mxManipulate, nullptr,
 					nullptr );
-				ImGuizmo::DecomposeMatrixToComponents( mxManipulate, glm::value_ptr( pSelectedItem->m_transform.translation ),
-					glm::value_ptr( pSelectedItem->m_transform.rotation ), glm::value_ptr( pSelectedItem->m_transform.scale ) );
-
 				if ( isManipulated )
 				{
+					// Only written back when moved, so the cached matrices of the selected object stay valid otherwise.
+					ImGuizmo::DecomposeMatrixToComponents( mxManipulate,
+						glm::value_ptr( pSelectedItem->m_transform.translation ),
+						glm::value_ptr( pSelectedItem->m_transform.rotation ),
+						glm::value_ptr( pSelectedItem->m_transform.scale ) );
+					pSelectedItem->m_transform.markDirty();
 					// m_mObjects.at( frameInfo.m_selectedItemId ).m_transform.rotation *= ( glm::pi< float >() * 180.f );
 					m_pCurrentLevel->updateObjectLocation( getFrameInfo().m_selectedItemId );
 				}
@@ -295,6 +367,7 @@ void CatApp::run()
 	}
 
 	( **m_PDevice ).waitIdle();
+	m_pGpuDrivenRenderSystem.reset();
 }
 
 void CatApp::saveLevel( const std::string& sFileName ) const
@@ -307,7 +380,11 @@ void CatApp::loadLevel( const std::string& sFileName, const bool bClearPrevious
 	m_RFrameInfo.m_selectedItemId = 0;
 	m_bTerrain = false;
 	// std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	// Free the asset loader threads for the new level before parsing it.
+	m_pCurrentLevel->cancelLoading();
 	m_pCurrentLevel = CatLevel::load( sFileName );
+	// The objects of the previous level are gone, their slabs can go too.
+	CatObjectPool::TrimAll();
 }
 
 
@@ -5,6 +5,7 @@
 
 #include "Cat/VulkanRHI/CatDescriptors.hpp"
 #include "Cat/VulkanRHI/CatDevice.hpp"
+#include "Cat/VulkanRHI/CatGpuTimer.hpp"
 #include "Cat/Objects/CatObject.hpp"
 #include "Cat/VulkanRHI/CatRenderer.hpp"
 #include "Cat/CatWindow.hpp"
@@ -13,11 +14,14 @@
 #include "Cat/Objects/CatAssetLoader.hpp"
 #include "Cat/CatImgui.hpp"
 #include "Cat/Controller/CatInput.hpp"
+#include "Cat/Rendering/CatCulling.hpp"
+#include "Cat/Rendering/CatLightClusters.hpp"
+#include "Cat/Rendering/CatRenderQueue.hpp"
+#include "Cat/RenderSystems/CatGpuDrivenRenderSystem.hpp"
 
 #include <memory>
 #include <vector>
 
-#include <concurrentqueue.h>
 #include <BS_thread_pool.hpp>
 #include <ImGuizmo.h>
 
@@ -31,6 +35,15 @@ public:
 	static constexpr int WIDTH = 1200;
 	static constexpr int HEIGHT = 800;
 
+	// Timestamps around the depth prepass and the opaque pass.
+	enum GpuTimestamp : uint32_t
+	{
+		eGpuPrepassBegin = 0,
+		eGpuOpaqueBegin,
+		eGpuOpaqueEnd,
+		eGpuTimestampCount,
+	};
+
 	CatApp();
 	~CatApp();
 
@@ -44,6 +57,9 @@ public:
 	[[nodiscard]] auto const& getObjects() const { return m_mObjects; }
 	[[nodiscard]] CatFrameInfo const& getFrameInfo() const { return *m_pFrameInfo; }
 	[[nodiscard]] CatFrameInfo& getFrameInfo() { return *m_pFrameInfo; }
+	[[nodiscard]] CatGpuDrivenRenderSystem* getGpuDrivenRenderSystem() const { return m_pGpuDrivenRenderSystem.get(); }
+	[[nodiscard]] const CatLightClusters& getLightClusters() const { return *m_pLightClusters; }
+	[[nodiscard]] const CatGpuTimer& getGpuTimer() const { return *m_pGpuTimer; }
 
 	void saveLevel( const std::string& sFileName ) const;
 	void loadLevel( const std::string& sFileName, bool bClearPrevious = true );
@@ -53,6 +69,12 @@ public:
 
 	bool m_bTerrain = false;
 	bool m_bUpdateFrustum = true;
+	CatCulling m_culling;
+	CatRenderQueue m_renderQueue;
+	// Lays down the depth of the opaque objects first, so the lighting is only computed for the visible fragments.
+	bool m_bDepthPrepass = false;
+	// Cull and draw the game objects on the GPU, only if the device supports indirect count draws.
+	bool m_bGpuDriven = false;
 
 	bool m_bRenderEverything = false;
 
@@ -66,6 +88,7 @@ private:
 	CatObject::Map m_mObjects;
 
 	std::unique_ptr< CatFrameInfo > m_pFrameInfo = nullptr;
+	std::unique_ptr< CatGpuDrivenRenderSystem > m_pGpuDrivenRenderSystem;
 
 	double m_dFrameTime = 0.0;
 	double m_dDeltaTime = 0.0;
@@ -74,7 +97,8 @@ private:
 	BS::thread_pool m_tAssetLoader{ 4 };
 	BS::thread_pool m_tObjectLoader{ 4 };
 	BS::thread_pool m_tLevelLoader{ 1 };
-	moodycamel::ConcurrentQueue< const char* > m_qLoadAssets{ 1 << 16 };
+	// Per frame work split across threads, waited on within the frame.
+	BS::thread_pool m_tFrameJobs{ 4 };
 	CatAssetLoader m_assetLoader{};
 	float m_fCameraSpeed = 12.33f;
 
@@ -85,10 +109,13 @@ private:
 	CatImgui* m_pImgui = nullptr;
 
 	CatCamera m_camera;
-	std::unique_ptr< CatObject > m_pCameraObject;
+	std::shared_ptr< CatObject > m_pCameraObject;
 	CatInput m_cameraController;
 
 	GlobalUbo m_ubo;
+	std::unique_ptr< CatLightClusters > m_pLightClusters;
+	std::unique_ptr< CatGpuTimer > m_pGpuTimer;
+	std::vector< PointLight > m_aPointLights;
 
 	ImGuizmo::OPERATION m_eGizmoOperation = ImGuizmo::UNIVERSAL;
 	ImGuizmo::MODE m_eGizmoMode = ImGuizmo::WORLD;
@@ -105,10 +132,10 @@ public:
 	CAT_READONLY_PROPERTY( m_dFrameTime, getFrameTime, m_DFrameTime );
 	CAT_READONLY_PROPERTY( m_dDeltaTime, getDeltaTime, m_DDeltaTime );
 	CAT_READONLY_PROPERTY( m_pWindow, getWindow, m_PWindow );
-	CAT_READONLY_PROPERTY( m_qLoadAssets, getLoadAssetsQueue, m_QLoadAssets );
 	CAT_READONLY_PROPERTY( m_tAssetLoader, getAssetLoaderThreadPool, m_TAssetLoader );
 	CAT_READONLY_PROPERTY( m_tObjectLoader, getObjectLoaderThreadPool, m_TObjectLoader );
 	CAT_READONLY_PROPERTY( m_tLevelLoader, getLevelLoaderThreadPool, m_TLevelLoader );
+	CAT_READONLY_PROPERTY( m_tFrameJobs, getFrameJobsThreadPool, m_TFrameJobs );
 	CAT_READONLY_PROPERTY( m_assetLoader, getAssetLoader, m_AssetLoader );
 	CAT_READONLY_PROPERTY( m_fCameraSpeed, getCameraSpeed, m_FCameraSpeed );
 	CAT_READONLY_PROPERTY( m_pCurrentLevel, getCurrentLevel, m_PCurrentLevel );
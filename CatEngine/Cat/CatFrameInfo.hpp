@@ -10,11 +10,9 @@
 
 namespace cat
 {
-static constexpr auto MAX_LIGHTS = 16;
-
 struct PointLight
 {
-	glm::vec4 position{}; // ignore w
+	glm::vec4 position{}; // w is the range
 	glm::vec4 color{};	  // w is intensity
 };
 
@@ -24,8 +22,10 @@ struct GlobalUbo
 	glm::mat4 view{ 1.f };
 	glm::mat4 inverseView{ 1.f };
 	glm::vec4 ambientLightColor{ .8f, .8f, 1.f, .286f }; // w is intensity
-	PointLight pointLights[MAX_LIGHTS];
-	int numLights;
+	// The lights themselves are in storage buffers, see CatLightClusters.
+	glm::uvec4 clusterGrid{};  // xyz is the number of clusters, w the number of lights
+	glm::vec4 clusterDepth{};  // near, far, depth slice log scale and bias
+	glm::vec2 viewportSize{};
 };
 
 using CatFrameInfo = struct CatFrameInfo_t
@@ -59,8 +59,7 @@ CatImgui::CatImgui( CatWindow* pWindow, CatDevice* pDevice, vk::RenderPass rende
 		.Device = m_pDevice->getDevice(),
 		.QueueFamily = m_pDevice->getGraphicsQueueFamily(),
 		.Queue = m_pDevice->getGraphicsQueue(),
-		// pipeline cache is a potential future optimization, ignoring for now
-		.PipelineCache = nullptr,
+		.PipelineCache = *m_pDevice->getPipelineCache(),
 		.DescriptorPool = m_pDescriptorPool->getDescriptorPool(),
 		.Subpass = 0,
 		.MinImageCount = 2,
@@ -164,13 +163,53 @@ void CatImgui::drawWindows()
 
 		ImGui::Checkbox( "Terrain", &GEI()->m_bTerrain );
 		ImGui::Checkbox( "Frustum", &GEI()->m_bUpdateFrustum );
+		ImGui::SameLine();
+		ImGui::Checkbox( "Culling", &GEI()->m_culling.m_bEnabled );
+		const auto& cullingStats = GEI()->m_culling.getStats();
+		ImGui::Text( "culled %u / %u objects (%u by sphere)", cullingStats.nCulled, cullingStats.nTested,
+			cullingStats.nCulledBySphere );
+		if ( auto* pGpuDriven = GEI()->getGpuDrivenRenderSystem() )
+		{
+			ImGui::Checkbox( "GPU Driven", &GEI()->m_bGpuDriven );
+			const auto& gpuStats = pGpuDriven->getStats();
+			ImGui::SameLine();
+			ImGui::Text( "drawn %u / %u objects", gpuStats.nDrawn, gpuStats.nObjects );
+		}
+		const auto& queueStats = GEI()->m_renderQueue.getStats();
+		ImGui::Text( "%u draws, binds: %u pipeline, %u set, %u buffer, %u skipped", queueStats.nDraws,
+			queueStats.nPipelineBinds, queueStats.nDescriptorSetBinds, queueStats.nBufferBinds, queueStats.nSkippedBinds );
+		ImGui::Checkbox( "Depth Prepass", &GEI()->m_bDepthPrepass );
+		if ( const auto& gpuTimer = GEI()->getGpuTimer(); gpuTimer.isSupported() )
+		{
+			ImGui::SameLine();
+			ImGui::Text( "prepass %.3f ms, opaque %.3f ms",
+				gpuTimer.getMilliseconds( CatApp::eGpuPrepassBegin, CatApp::eGpuOpaqueBegin ),
+				gpuTimer.getMilliseconds( CatApp::eGpuOpaqueBegin, CatApp::eGpuOpaqueEnd ) );
+		}
+		const auto& transformStats = GEI()->m_PCurrentLevel->getTransforms().getStats();
+		ImGui::Text( "transforms %u in %u blocks, %u rebuilt", transformStats.nTransforms, transformStats.nBlocks,
+			transformStats.nRebuilt );
+		const auto worldStats = GEI()->m_PCurrentLevel->getWorld().getStats();
+		ImGui::Text( "entities %u in %u archetypes, %u chunks", worldStats.nEntities, worldStats.nArchetypes,
+			worldStats.nChunks );
+		for ( const auto& poolStats : CatObjectPool::GetAllStats() )
+		{
+			ImGui::Text( "%s: %u live, %u peak, %u slabs, %llu allocations", poolStats.sName, poolStats.nLive, poolStats.nPeak,
+				poolStats.nSlabs, static_cast< unsigned long long >( poolStats.nAllocations ) );
+		}
+		const auto& lightStats = GEI()->getLightClusters().getStats();
+		ImGui::Text( "lights %u / %u visible, %u per cluster at most", lightStats.nVisibleLights, lightStats.nLights,
+			lightStats.nMaxClusterLights );
 
 		ImGui::Checkbox( "Render Everything", &GEI()->m_bRenderEverything );
 
-		ImGui::DragFloat3( "cam pos",
-			reinterpret_cast< float* >( &GetEditorInstance()->m_RFrameInfo.m_rCameraObject.m_transform.translation ), 0.1f );
-		ImGui::DragFloat3( "cam rot",
-			reinterpret_cast< float* >( &GetEditorInstance()->m_RFrameInfo.m_rCameraObject.m_transform.rotation ), 0.1f );
+		auto& cameraTransform = GetEditorInstance()->m_RFrameInfo.m_rCameraObject.m_transform;
+		bool bCameraChanged = ImGui::DragFloat3( "cam pos", reinterpret_cast< float* >( &cameraTransform.translation ), 0.1f );
+		bCameraChanged |= ImGui::DragFloat3( "cam rot", reinterpret_cast< float* >( &cameraTransform.rotation ), 0.1f );
+		if ( bCameraChanged )
+		{
+			cameraTransform.markDirty();
+		}
 
 		ImGui::DragFloat( "displacement", &GEI()->m_PCurrentLevel->m_PTerrain->m_Ubo.displacementFactor, 1.0f, 0.0f, 64.0f );
 		ImGui::DragFloat( "tessellation", &GEI()->m_PCurrentLevel->m_PTerrain->m_Ubo.tessellationFactor, 0.01f, 0.0f, 1.0f );
@@ -182,11 +221,8 @@ void CatImgui::drawWindows()
 		ImGui::InputTextWithHint( "##Lavel Name", "Filename", buf, 128, ImGuiInputTextFlags_CharsNoBlank );
 		if ( ImGui::Button( "Load Level" ) )
 		{
+			// Without an extension the level loader picks the binary level if there is one.
 			std::string name( buf );
-			if ( !name.ends_with( ".json" ) )
-			{
-				name += ".json";
-			}
 			LOG_F( INFO, "Frame: %llu", GetEditorInstance()->m_RFrameInfo.m_nFrameNumber );
 
 			std::thread t( [=] { GEI()->loadLevel( name ); } );
@@ -198,6 +234,48 @@ void CatImgui::drawWindows()
 			std::string name( buf );
 			GetEditorInstance()->saveLevel( name );
 		}
+		ImGui::SameLine();
+		if ( ImGui::Button( "Convert Level" ) )
+		{
+			std::string name( buf );
+			if ( name.ends_with( ".json" ) )
+			{
+				name.resize( name.size() - 5 );
+			}
+			CatLevelFile::convert( LEVELS_BASE_PATH + name + ".json", LEVELS_BASE_PATH + name + CatLevelFile::EXTENSION );
+		}
+
+		{
+			auto& assetLoader = GetEditorInstance()->m_AssetLoader;
+			int nBudget = static_cast< int >( assetLoader.getMemoryBudget() >> 20 );
+			if ( ImGui::DragInt( "memory budget (MB)", &nBudget, 1.0f, 0, 16384 ) )
+			{
+				assetLoader.setMemoryBudget( vk::DeviceSize( nBudget ) << 20 );
+			}
+
+			const auto stats = GetEditorInstance()->m_PCurrentLevel->getStreamingStats();
+			ImGui::Text( "models: %.1f MB, pending releases: %zu", double( assetLoader.getResidentMemory() ) / ( 1024.0 * 1024.0 ),
+				GetEditorInstance()->m_PDevice->getDeferredReleaseCount() );
+			ImGui::Text( "chunks resident: %u, streaming: %u, dirty: %u, evicted: %u", stats.nResidentChunks,
+				stats.nStreamingChunks, stats.nDirtyChunks, stats.nEvictedChunks );
+
+			auto& level = GetEditorInstance()->m_PCurrentLevel;
+			ImGui::Checkbox( "prefetch", &level->m_BPrefetch );
+			ImGui::SameLine();
+			ImGui::DragFloat( "lookahead (s)", &level->m_FPrefetchTime, 0.01f, 0.0f, 5.0f );
+			ImGui::Text( "prefetched: %u, hits: %u, late: %u, wasted: %u, misses: %u, queued: %u", stats.nPrefetchRequests,
+				stats.nPrefetchHits, stats.nPrefetchLate, stats.nPrefetchWasted, stats.nMisses, stats.nQueuedChunks );
+			ImGui::Text( "model requests queued: %zu, cancelled: %u (%u objects, %u chunks)", assetLoader.getQueuedRequestCount(),
+				assetLoader.getCancelledRequestCount(), assetLoader.getCancelledObjectCount(), stats.nCancelledChunks );
+			ImGui::Text( "ready after: %.1f ms", stats.dReadyTime );
+			ImGui::Text( "objects waiting: %u", stats.nPendingObjects );
+			ImGui::SameLine();
+			int nObjectsPerFrame = static_cast< int >( level->getObjectsPerFrame() );
+			if ( ImGui::SliderInt( "per frame", &nObjectsPerFrame, 1, 4096 ) )
+			{
+				level->setObjectsPerFrame( static_cast< uint32_t >( nObjectsPerFrame ) );
+			}
+		}
 
 		
 		if ( ImPlot::BeginPlot( "##FramePacing", ImVec2( -1, 150 ) ) )
@@ -230,6 +308,45 @@ void CatImgui::drawWindows()
 
 		ImGui::End();
 	}
+	{
+		ImGui::Begin( "Memory" );
+
+		auto& allocator = m_pDevice->getAllocator();
+		ImGui::Text( "device allocations: %u / %u", allocator.getDeviceAllocationCount(), allocator.getMaxDeviceAllocationCount() );
+
+		constexpr double MB = 1024.0 * 1024.0;
+		const auto aHeapStats = allocator.getHeapStats();
+		for ( size_t i = 0; i < aHeapStats.size(); ++i )
+		{
+			const auto& stats = aHeapStats[i];
+			const bool bDeviceLocal = bool( stats.flags & vk::MemoryHeapFlagBits::eDeviceLocal );
+			ImGui::Text( "heap %zu (%s): %.1f / %.1f MB used, %.1f MB heap", i, bDeviceLocal ? "device" : "host",
+				double( stats.nUsed ) / MB, double( stats.nReserved ) / MB, double( stats.nHeapSize ) / MB );
+			ImGui::ProgressBar( stats.nReserved ? float( double( stats.nUsed ) / double( stats.nReserved ) ) : 0.0f );
+			ImGui::Text( "  blocks: %u, dedicated: %u, allocations: %u, free ranges: %u, fragmentation: %.2f", stats.nBlocks,
+				stats.nDedicated, stats.nAllocations, stats.nFreeRanges, stats.getFragmentation() );
+		}
+
+		const auto geometry = m_pDevice->getGeometryPool().getStats();
+		const double dVertexSize = double( m_pDevice->getGeometryPool().getVertexSize() );
+		ImGui::Separator();
+		ImGui::Text( "geometry pages: %u / %u, models: %u, free ranges: %u", geometry.nPages, CatGeometryPool::MAX_PAGES,
+			geometry.nAllocations, geometry.nFreeRanges );
+		ImGui::Text( "vertices: %.1f / %.1f MB, indices: %.1f / %.1f MB, largest free: %u vertices",
+			double( geometry.nVertices ) * dVertexSize / MB,
+			double( geometry.nPages ) * CatGeometryPool::VERTEX_CAPACITY * dVertexSize / MB,
+			double( geometry.nIndices ) * sizeof( uint32_t ) / MB,
+			double( geometry.nPages ) * CatGeometryPool::INDEX_CAPACITY * sizeof( uint32_t ) / MB, geometry.nLargestFreeVertices );
+
+		const auto uploads = m_pDevice->getUploader().getStats();
+		ImGui::Separator();
+		ImGui::Text( "uploads: %llu in %llu batches, %.1f MB", static_cast< unsigned long long >( uploads.nUploads ),
+			static_cast< unsigned long long >( uploads.nBatches ), double( uploads.nBytes ) / MB );
+		ImGui::Text( "staging ring: %.1f / %.1f MB, pending: %zu, in flight: %zu", double( uploads.nRingUsed ) / MB,
+			double( CatUploader::RING_SIZE ) / MB, uploads.nPending, uploads.nInFlight );
+
+		ImGui::End();
+	}
 	{
 		ImGui::Begin( "Objects" );
 
@@ -241,8 +358,9 @@ void CatImgui::drawWindows()
 		{
 			// static CatObject::id_t currentItemIdx = 0;
 			int i = 0;
-			for ( auto& [key, object] : GetEditorInstance()->m_RFrameInfo.m_pLevel->getAllObjects() )
+			for ( auto* object : GetEditorInstance()->m_RFrameInfo.m_pLevel->getRenderView() )
 			{
+				const auto key = object->getId();
 				if ( !bShowHidden && object->getName().find( "Chunk" ) != std::string::npos )
 				{
 					continue;
@@ -266,18 +384,26 @@ void CatImgui::drawWindows()
 		ImGui::End();
 	}
 	{
-		if ( GetEditorInstance()->m_RFrameInfo.m_selectedItemId != 0 )
+		auto pObject =
+			GetEditorInstance()->m_RFrameInfo.m_pLevel->getObject( GetEditorInstance()->m_RFrameInfo.m_selectedItemId );
+		if ( pObject )
 		{
 			ImGui::Begin( "SelectedObject" );
 
-			auto pObject = GetEditorInstance()->m_RFrameInfo.m_pLevel->getAllObjects().at(
-				GetEditorInstance()->m_RFrameInfo.m_selectedItemId );
-
 			auto bIsGlobal = false;
 
-			ImGui::DragFloat3( "Position", reinterpret_cast< float* >( &pObject->m_transform.translation ), 0.1f );
-			ImGui::DragFloat3( "Rotation", reinterpret_cast< float* >( &pObject->m_transform.rotation ), 0.1f );
-			ImGui::DragFloat3( "Scale", reinterpret_cast< float* >( &pObject->m_transform.scale ), 0.1f );
+			bool bChanged = ImGui::DragFloat3( "Position", reinterpret_cast< float* >( &pObject->m_transform.translation ), 0.1f );
+			bChanged |= ImGui::DragFloat3( "Rotation", reinterpret_cast< float* >( &pObject->m_transform.rotation ), 0.1f );
+			bChanged |= ImGui::DragFloat3( "Scale", reinterpret_cast< float* >( &pObject->m_transform.scale ), 0.1f );
+			if ( bChanged )
+			{
+				pObject->m_transform.markDirty();
+				GetEditorInstance()->m_RFrameInfo.m_pLevel->updateObjectLocation( pObject->getId() );
+			}
+			if ( ImGui::SliderFloat( "Opacity", &pObject->m_fOpacity, 0.f, 1.f ) )
+			{
+				GetEditorInstance()->m_RFrameInfo.m_pLevel->updateEntity( pObject->getId() );
+			}
 
 			ImGui::Checkbox( "Is Global", &bIsGlobal );
 
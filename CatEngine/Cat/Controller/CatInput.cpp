@@ -79,6 +79,8 @@ bool CatInput::moveInPlaneXZ( GLFWwindow* window, float dt, CatObject& gameObjec
 		gameObject.m_transform.translation += m_fMovementSpeed * dt * glm::normalize( moveDir );
 		bWasMatrixupdated = true;
 	}
+	// After both mutations, the transform system only rebuilds the matrices of dirty transforms.
+	gameObject.m_transform.markDirty();
 
 	return bWasMatrixupdated;
 }
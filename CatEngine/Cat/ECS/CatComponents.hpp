@@ -0,0 +1,61 @@
+#ifndef CATENGINE_CATCOMPONENTS_HPP
+#define CATENGINE_CATCOMPONENTS_HPP
+
+#include "Cat/Objects/CatTransform.hpp"
+
+#include <glm/glm.hpp>
+
+namespace cat
+{
+class CatModel;
+class CatObject;
+
+// The components of the entities a level keeps for its render view. The objects stay the editable and saved state, the
+// level copies their render data into the components when they enter the view and after they are edited.
+
+// Back to the object, for the editor and the systems that still need the rest of it.
+struct ObjectComponent
+{
+	CatObject* pObject = nullptr;
+};
+
+// Game objects with a model.
+struct MeshComponent
+{
+	const CatModel* pModel = nullptr;
+	// Owned by the object, the matrices are rebuilt by the level's CatTransformSystem.
+	const TransformComponent* pTransform = nullptr;
+	glm::vec3 vColor{};
+	float fOpacity = 1.f;
+	// Outside of the frustum, written by CatCulling every frame.
+	bool bCulled = false;
+
+	[[nodiscard]] bool isTransparent() const { return fOpacity < 1.f; }
+};
+
+struct LightComponent
+{
+	// Not const, the light systems move the lights around.
+	TransformComponent* pTransform = nullptr;
+	glm::vec3 vColor{ 1.f };
+	float fIntensity = 10.f;
+	float fRadius = .1f;
+};
+
+// Debug volumes, drawn as wireframes over the scene.
+struct VolumeComponent
+{
+	const CatModel* pModel = nullptr;
+	const TransformComponent* pTransform = nullptr;
+	glm::vec3 vColor{};
+	bool bCulled = false;
+};
+
+// Not culled, the grid spans the view.
+struct GridComponent
+{
+	const TransformComponent* pTransform = nullptr;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATCOMPONENTS_HPP
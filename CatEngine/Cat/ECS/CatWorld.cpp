@@ -0,0 +1,224 @@
+#include "CatWorld.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <mutex>
+
+namespace cat
+{
+namespace
+{
+// Chunks are aligned for SIMD loads of the component arrays.
+constexpr size_t CHUNK_ALIGNMENT = 64;
+
+size_t AlignUp( const size_t nValue, const size_t nAlignment )
+{
+	return ( nValue + nAlignment - 1 ) / nAlignment * nAlignment;
+}
+} // namespace
+
+std::array< CatWorld::ComponentInfo, CatWorld::MAX_COMPONENTS >& CatWorld::GetComponentInfos()
+{
+	// Fixed size, so the registry never reallocates while the worlds read it.
+	static std::array< ComponentInfo, MAX_COMPONENTS > aComponentInfos;
+	return aComponentInfos;
+}
+
+uint32_t CatWorld::RegisterComponent( const ComponentInfo& info )
+{
+	// The ids are assigned on the first use of a type, which can be on any thread.
+	static std::mutex mutexComponents;
+	static uint32_t nComponentCount = 0;
+	std::lock_guard lock( mutexComponents );
+	CHECK_F( nComponentCount < MAX_COMPONENTS, "too many component types" );
+	CHECK_F( info.nAlignment <= CHUNK_ALIGNMENT, "component alignment is larger than the chunk alignment" );
+	GetComponentInfos()[nComponentCount] = info;
+	return nComponentCount++;
+}
+
+const CatWorld::ComponentInfo& CatWorld::GetComponentInfo( const uint32_t nComponent )
+{
+	return GetComponentInfos()[nComponent];
+}
+
+void CatWorld::ChunkDeleter::operator()( std::byte* pData ) const
+{
+	::operator delete[]( pData, std::align_val_t( CHUNK_ALIGNMENT ) );
+}
+
+CatWorld::~CatWorld()
+{
+	for ( const auto* pArchetype : m_aArchetypes )
+	{
+		for ( const auto& chunk : pArchetype->aChunks )
+		{
+			for ( const auto nComponent : pArchetype->aComponents )
+			{
+				for ( uint32_t nRow = 0; nRow < chunk.nCount; ++nRow )
+				{
+					GetComponentInfo( nComponent ).fnDestroy( getComponent( *pArchetype, chunk, nComponent, nRow ) );
+				}
+			}
+		}
+	}
+}
+
+void* CatWorld::getComponent( const Archetype& archetype, const Chunk& chunk, const uint32_t nComponent, const uint32_t nRow )
+{
+	return chunk.pData.get() + archetype.aOffsets[nComponent] + nRow * GetComponentInfo( nComponent ).nSize;
+}
+
+CatWorld::Archetype& CatWorld::getArchetype( const ComponentMask mask )
+{
+	auto& pArchetype = m_mArchetypes[mask];
+	if ( pArchetype ) return *pArchetype;
+
+	pArchetype = std::make_unique< Archetype >();
+	pArchetype->mask = mask;
+	size_t nRowSize = sizeof( Entity );
+	size_t nPadding = 0;
+	for ( uint32_t i = 0; i < MAX_COMPONENTS; ++i )
+	{
+		if ( ( mask & ( ComponentMask( 1 ) << i ) ) == 0 ) continue;
+
+		pArchetype->aComponents.push_back( i );
+		nRowSize += GetComponentInfo( i ).nSize;
+		nPadding += GetComponentInfo( i ).nAlignment;
+	}
+	pArchetype->nCapacity = static_cast< uint32_t >( std::max< size_t >( ( CHUNK_SIZE - nPadding ) / nRowSize, 1 ) );
+
+	// The arrays follow each other, every one aligned for its component.
+	size_t nOffset = sizeof( Entity ) * pArchetype->nCapacity;
+	for ( const auto nComponent : pArchetype->aComponents )
+	{
+		const auto& info = GetComponentInfo( nComponent );
+		nOffset = AlignUp( nOffset, info.nAlignment );
+		pArchetype->aOffsets[nComponent] = static_cast< uint32_t >( nOffset );
+		nOffset += info.nSize * pArchetype->nCapacity;
+	}
+	// Archetypes of components larger than a chunk get larger chunks with a single row.
+	pArchetype->nChunkSize = std::max( CHUNK_SIZE, nOffset );
+
+	m_aArchetypes.push_back( pArchetype.get() );
+	return *pArchetype;
+}
+
+Entity CatWorld::allocateEntity()
+{
+	++m_nEntities;
+	if ( !m_aFreeIndices.empty() )
+	{
+		const auto nIndex = m_aFreeIndices.back();
+		m_aFreeIndices.pop_back();
+		return { nIndex, m_aRecords[nIndex].nGeneration };
+	}
+	m_aRecords.emplace_back();
+	return { static_cast< uint32_t >( m_aRecords.size() - 1 ), 0 };
+}
+
+void CatWorld::allocateRow( Archetype& archetype, const Entity entity )
+{
+	if ( archetype.aChunks.empty() || archetype.aChunks.back().nCount == archetype.nCapacity )
+	{
+		archetype.aChunks.push_back( { .pData = std::unique_ptr< std::byte[], ChunkDeleter >( static_cast< std::byte* >(
+										   ::operator new[]( archetype.nChunkSize, std::align_val_t( CHUNK_ALIGNMENT ) ) ) ) } );
+	}
+
+	auto& chunk = archetype.aChunks.back();
+	reinterpret_cast< Entity* >( chunk.pData.get() )[chunk.nCount] = entity;
+
+	auto& record = m_aRecords[entity.nIndex];
+	record.pArchetype = &archetype;
+	record.nChunk = static_cast< uint32_t >( archetype.aChunks.size() - 1 );
+	record.nRow = chunk.nCount++;
+}
+
+void CatWorld::freeRow( Archetype& archetype, const uint32_t nChunk, const uint32_t nRow )
+{
+	auto& last = archetype.aChunks.back();
+	const auto nLastChunk = static_cast< uint32_t >( archetype.aChunks.size() - 1 );
+	const auto nLastRow = last.nCount - 1;
+
+	// Swap with the last row so the arrays stay contiguous.
+	if ( nChunk != nLastChunk || nRow != nLastRow )
+	{
+		auto& chunk = archetype.aChunks[nChunk];
+		for ( const auto nComponent : archetype.aComponents )
+		{
+			GetComponentInfo( nComponent )
+				.fnMove( getComponent( archetype, chunk, nComponent, nRow ),
+					getComponent( archetype, last, nComponent, nLastRow ) );
+		}
+		const auto movedEntity = reinterpret_cast< Entity* >( last.pData.get() )[nLastRow];
+		reinterpret_cast< Entity* >( chunk.pData.get() )[nRow] = movedEntity;
+		m_aRecords[movedEntity.nIndex].nChunk = nChunk;
+		m_aRecords[movedEntity.nIndex].nRow = nRow;
+	}
+
+	if ( --last.nCount == 0 )
+	{
+		archetype.aChunks.pop_back();
+	}
+}
+
+void CatWorld::moveEntity( const Entity entity, const ComponentMask mask )
+{
+	const auto oldRecord = m_aRecords[entity.nIndex];
+	auto& source = *oldRecord.pArchetype;
+	auto& target = getArchetype( mask );
+	allocateRow( target, entity );
+
+	const auto& record = m_aRecords[entity.nIndex];
+	const auto& sourceChunk = source.aChunks[oldRecord.nChunk];
+	const auto& targetChunk = target.aChunks[record.nChunk];
+	for ( const auto nComponent : source.aComponents )
+	{
+		auto* pComponent = getComponent( source, sourceChunk, nComponent, oldRecord.nRow );
+		if ( ( mask & ( ComponentMask( 1 ) << nComponent ) ) != 0 )
+		{
+			GetComponentInfo( nComponent ).fnMove( getComponent( target, targetChunk, nComponent, record.nRow ), pComponent );
+		}
+		else
+		{
+			GetComponentInfo( nComponent ).fnDestroy( pComponent );
+		}
+	}
+	freeRow( source, oldRecord.nChunk, oldRecord.nRow );
+}
+
+void CatWorld::destroy( const Entity entity )
+{
+	if ( !isAlive( entity ) ) return;
+
+	auto& record = m_aRecords[entity.nIndex];
+	auto& archetype = *record.pArchetype;
+	const auto& chunk = archetype.aChunks[record.nChunk];
+	for ( const auto nComponent : archetype.aComponents )
+	{
+		GetComponentInfo( nComponent ).fnDestroy( getComponent( archetype, chunk, nComponent, record.nRow ) );
+	}
+	freeRow( archetype, record.nChunk, record.nRow );
+
+	record.pArchetype = nullptr;
+	++record.nGeneration;
+	m_aFreeIndices.push_back( entity.nIndex );
+	--m_nEntities;
+}
+
+bool CatWorld::isAlive( const Entity entity ) const
+{
+	return entity.nIndex < m_aRecords.size() && m_aRecords[entity.nIndex].pArchetype
+		   && m_aRecords[entity.nIndex].nGeneration == entity.nGeneration;
+}
+
+CatWorld::Stats CatWorld::getStats() const
+{
+	Stats stats{ .nEntities = m_nEntities, .nArchetypes = static_cast< uint32_t >( m_aArchetypes.size() ) };
+	for ( const auto* pArchetype : m_aArchetypes )
+	{
+		stats.nChunks += static_cast< uint32_t >( pArchetype->aChunks.size() );
+	}
+	return stats;
+}
+} // namespace cat
@@ -0,0 +1,279 @@
+#ifndef CATENGINE_CATWORLD_HPP
+#define CATENGINE_CATWORLD_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cat
+{
+// The index is reused after the entity is destroyed, the generation tells the old handles apart.
+struct Entity
+{
+	uint32_t nIndex = ~0u;
+	uint32_t nGeneration = 0;
+
+	[[nodiscard]] bool isNull() const { return nIndex == ~0u; }
+
+	bool operator==( const Entity& other ) const = default;
+};
+
+using ComponentMask = uint64_t;
+
+// Entities with the same set of components share an archetype, which stores them in fixed size chunks with one contiguous
+// array per component. Queries walk the matching archetypes chunk by chunk, so a system only touches the components it
+// asked for. Structural changes (create, destroy, add, remove) move components between rows, so pointers to components
+// and iteration stay valid only until the next one.
+class CatWorld
+{
+public:
+	static constexpr size_t CHUNK_SIZE = 16 * 1024;
+	static constexpr uint32_t MAX_COMPONENTS = 64;
+
+	struct Stats
+	{
+		uint32_t nEntities = 0;
+		uint32_t nArchetypes = 0;
+		uint32_t nChunks = 0;
+	};
+
+	CatWorld() = default;
+	~CatWorld();
+
+	CatWorld( const CatWorld& ) = delete;
+	CatWorld& operator=( const CatWorld& ) = delete;
+
+	template < typename... Ts >
+	Entity create( Ts&&... components );
+	void destroy( Entity entity );
+	[[nodiscard]] bool isAlive( Entity entity ) const;
+
+	// Replaces the component if the entity already has one.
+	template < typename T >
+	std::remove_cvref_t< T >& add( Entity entity, T&& component );
+	template < typename T >
+	void remove( Entity entity );
+	// Null if the entity is dead or doesn't have the component.
+	template < typename T >
+	[[nodiscard]] T* get( Entity entity );
+	template < typename T >
+	[[nodiscard]] bool has( Entity entity ) const;
+
+	// Calls fnVisit( Entity, Ts&... ) for every entity that has all of Ts. Don't change the structure of the world inside.
+	template < typename... Ts, typename TFunction >
+	void each( TFunction&& fnVisit );
+	// Calls fnVisit( nCount, const Entity*, Ts*... ) with the arrays of every matching chunk.
+	template < typename... Ts, typename TFunction >
+	void eachChunk( TFunction&& fnVisit );
+
+	[[nodiscard]] Stats getStats() const;
+
+private:
+	// Type erased operations of a component type, registered the first time the type is used.
+	struct ComponentInfo
+	{
+		size_t nSize = 0;
+		size_t nAlignment = 0;
+		// Move constructs into pDst and destroys pSrc.
+		void ( *fnMove )( void* pDst, void* pSrc ) = nullptr;
+		void ( *fnDestroy )( void* pComponent ) = nullptr;
+	};
+
+	struct ChunkDeleter
+	{
+		void operator()( std::byte* pData ) const;
+	};
+
+	struct Chunk
+	{
+		std::unique_ptr< std::byte[], ChunkDeleter > pData;
+		uint32_t nCount = 0;
+	};
+
+	struct Archetype
+	{
+		ComponentMask mask = 0;
+		std::vector< uint32_t > aComponents;
+		// Byte offset of every component's array in a chunk, the entities are at the start.
+		std::array< uint32_t, MAX_COMPONENTS > aOffsets{};
+		uint32_t nCapacity = 0;
+		size_t nChunkSize = CHUNK_SIZE;
+		// Only the last chunk has free rows.
+		std::vector< Chunk > aChunks;
+	};
+
+	struct Record
+	{
+		Archetype* pArchetype = nullptr;
+		uint32_t nChunk = 0;
+		uint32_t nRow = 0;
+		uint32_t nGeneration = 0;
+	};
+
+	template < typename T >
+	static void MoveComponent( void* pDst, void* pSrc )
+	{
+		auto* pComponent = static_cast< T* >( pSrc );
+		new ( pDst ) T( std::move( *pComponent ) );
+		pComponent->~T();
+	}
+
+	template < typename T >
+	static void DestroyComponent( void* pComponent )
+	{
+		static_cast< T* >( pComponent )->~T();
+	}
+
+	static std::array< ComponentInfo, MAX_COMPONENTS >& GetComponentInfos();
+	static uint32_t RegisterComponent( const ComponentInfo& info );
+	static const ComponentInfo& GetComponentInfo( uint32_t nComponent );
+
+	template < typename T >
+	static uint32_t getComponentId()
+	{
+		using Component = std::remove_cvref_t< T >;
+		// Const queries share the id of the component.
+		if constexpr ( !std::is_same_v< T, Component > )
+		{
+			return getComponentId< Component >();
+		}
+		else
+		{
+			static const uint32_t nId = RegisterComponent( ComponentInfo{
+				.nSize = sizeof( Component ),
+				.nAlignment = alignof( Component ),
+				.fnMove = &MoveComponent< Component >,
+				.fnDestroy = &DestroyComponent< Component >,
+			} );
+			return nId;
+		}
+	}
+
+	template < typename... Ts >
+	static ComponentMask getMask()
+	{
+		return ( ComponentMask( 0 ) | ... | ( ComponentMask( 1 ) << getComponentId< Ts >() ) );
+	}
+
+	static void* getComponent( const Archetype& archetype, const Chunk& chunk, uint32_t nComponent, uint32_t nRow );
+
+	Archetype& getArchetype( ComponentMask mask );
+	Entity allocateEntity();
+	// Appends a row for the entity to the archetype and points its record at it, the components are left uninitialized.
+	void allocateRow( Archetype& archetype, Entity entity );
+	// Fills the row with the last one of the archetype, the components in the row have to be moved out or destroyed.
+	void freeRow( Archetype& archetype, uint32_t nChunk, uint32_t nRow );
+	// Moves the entity to the archetype of the mask, the components it loses are destroyed.
+	void moveEntity( Entity entity, ComponentMask mask );
+
+	template < typename... Ts, typename TFunction, size_t... Is >
+	void eachChunk( TFunction& fnVisit, std::index_sequence< Is... > );
+
+	std::unordered_map< ComponentMask, std::unique_ptr< Archetype > > m_mArchetypes;
+	// In creation order, the queries walk this.
+	std::vector< Archetype* > m_aArchetypes;
+	std::vector< Record > m_aRecords;
+	std::vector< uint32_t > m_aFreeIndices;
+	uint32_t m_nEntities = 0;
+};
+
+template < typename... Ts >
+Entity CatWorld::create( Ts&&... components )
+{
+	const auto entity = allocateEntity();
+	auto& archetype = getArchetype( getMask< Ts... >() );
+	allocateRow( archetype, entity );
+
+	const auto& record = m_aRecords[entity.nIndex];
+	const auto& chunk = archetype.aChunks[record.nChunk];
+	( new ( getComponent( archetype, chunk, getComponentId< Ts >(), record.nRow ) )
+			std::remove_cvref_t< Ts >( std::forward< Ts >( components ) ),
+		... );
+	return entity;
+}
+
+template < typename T >
+std::remove_cvref_t< T >& CatWorld::add( const Entity entity, T&& component )
+{
+	using Component = std::remove_cvref_t< T >;
+	if ( auto* pComponent = get< Component >( entity ) )
+	{
+		*pComponent = std::forward< T >( component );
+		return *pComponent;
+	}
+
+	const auto nComponent = getComponentId< Component >();
+	moveEntity( entity, m_aRecords[entity.nIndex].pArchetype->mask | ( ComponentMask( 1 ) << nComponent ) );
+	const auto& record = m_aRecords[entity.nIndex];
+	auto* pComponent = new ( getComponent( *record.pArchetype, record.pArchetype->aChunks[record.nChunk], nComponent,
+		record.nRow ) ) Component( std::forward< T >( component ) );
+	return *pComponent;
+}
+
+template < typename T >
+void CatWorld::remove( const Entity entity )
+{
+	if ( !has< T >( entity ) ) return;
+	moveEntity( entity, m_aRecords[entity.nIndex].pArchetype->mask & ~( ComponentMask( 1 ) << getComponentId< T >() ) );
+}
+
+template < typename T >
+T* CatWorld::get( const Entity entity )
+{
+	if ( !has< T >( entity ) ) return nullptr;
+	const auto& record = m_aRecords[entity.nIndex];
+	return static_cast< T* >(
+		getComponent( *record.pArchetype, record.pArchetype->aChunks[record.nChunk], getComponentId< T >(), record.nRow ) );
+}
+
+template < typename T >
+bool CatWorld::has( const Entity entity ) const
+{
+	return isAlive( entity )
+		   && ( m_aRecords[entity.nIndex].pArchetype->mask & ( ComponentMask( 1 ) << getComponentId< T >() ) ) != 0;
+}
+
+template < typename... Ts, typename TFunction >
+void CatWorld::each( TFunction&& fnVisit )
+{
+	eachChunk< Ts... >(
+		[&]( const uint32_t nCount, const Entity* pEntities, Ts*... pComponents )
+		{
+			for ( uint32_t i = 0; i < nCount; ++i )
+			{
+				fnVisit( pEntities[i], pComponents[i]... );
+			}
+		} );
+}
+
+template < typename... Ts, typename TFunction >
+void CatWorld::eachChunk( TFunction&& fnVisit )
+{
+	eachChunk< Ts... >( fnVisit, std::index_sequence_for< Ts... >{} );
+}
+
+template < typename... Ts, typename TFunction, size_t... Is >
+void CatWorld::eachChunk( TFunction& fnVisit, std::index_sequence< Is... > )
+{
+	const auto mask = getMask< Ts... >();
+	const std::array< uint32_t, sizeof...( Ts ) > aComponents{ getComponentId< Ts >()... };
+	for ( const auto* pArchetype : m_aArchetypes )
+	{
+		if ( ( pArchetype->mask & mask ) != mask ) continue;
+
+		for ( const auto& chunk : pArchetype->aChunks )
+		{
+			fnVisit( chunk.nCount, reinterpret_cast< const Entity* >( chunk.pData.get() ),
+				reinterpret_cast< Ts* >( chunk.pData.get() + pArchetype->aOffsets[aComponents[Is]] )... );
+		}
+	}
+}
+} // namespace cat
+
+#endif // CATENGINE_CATWORLD_HPP
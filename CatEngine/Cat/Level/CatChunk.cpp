@@ -55,4 +55,19 @@ bool CatChunk::unload()
 	return true;
 }
 
+uint32_t CatChunk::beginStreaming()
+{
+	m_eState = ChunkState::eStreaming;
+	return ++m_nGeneration;
+}
+
+void CatChunk::evict()
+{
+	// Editor objects like the chunk visualizer are not part of the level data, they stay.
+	std::erase_if( m_mObjects, []( const auto& pair ) { return !( pair.second->getType() >= ObjectType::eNotSaved ); } );
+
+	m_eState = ChunkState::eUnloaded;
+	++m_nGeneration;
+}
+
 } // namespace cat
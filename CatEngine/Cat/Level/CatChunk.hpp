@@ -3,6 +3,7 @@
 
 #include "Cat/Utils/CatUtils.hpp"
 #include "Cat/Objects/CatObject.hpp"
+#include "Cat/Level/CatLevelFile.hpp"
 
 #include <string>
 #include <utility>
@@ -11,15 +12,35 @@
 namespace cat
 {
 
+enum class ChunkState
+{
+	eUnloaded,
+	eQueued,
+	eStreaming,
+	eResident,
+};
+
 class CatChunk
 {
 private:
 	const id_t m_id;
 	glm::ivec2 m_vPosition;
 	CatObject::Map m_mObjects;
-	std::vector< id_t > m_aObjectIds;
 	bool m_bLoaded = false;
 
+	ChunkState m_eState = ChunkState::eUnloaded;
+	// Bumped every time the chunk starts streaming or gets evicted, objects from an older stream are dropped.
+	uint32_t m_nGeneration = 0;
+	// Edited chunks keep their objects in memory, the source data would not contain the edits.
+	bool m_bDirty = false;
+	// Requested by the prefetcher and did not enter the load radius yet.
+	bool m_bPrefetched = false;
+	uint64_t m_nLastUsed = 0;
+
+	// Where the chunk's objects are streamed from, only one of them is set.
+	const json* m_pJsonData = nullptr;
+	const CatLevelFile::Chunk* m_pFileData = nullptr;
+
 public:
 	CatChunk( const id_t id, glm::ivec2 vPosition, glm::ivec2 vSize, glm::ivec2 vMaxSize );
 	~CatChunk() = default;
@@ -27,10 +48,40 @@ public:
 	bool load();
 	bool unload();
 
+	// Starts a new stream of the chunk's objects, returns its generation.
+	uint32_t beginStreaming();
+	// Drops the streamed objects and returns to the unloaded state.
+	void evict();
+
+	void setSource( const json* pJsonData )
+	{
+		m_pJsonData = pJsonData;
+		m_pFileData = nullptr;
+	}
+	void setSource( const CatLevelFile::Chunk* pFileData )
+	{
+		m_pJsonData = nullptr;
+		m_pFileData = pFileData;
+	}
+	void clearSource()
+	{
+		m_pJsonData = nullptr;
+		m_pFileData = nullptr;
+	}
+
+	[[nodiscard]] bool isLoaded() const { return m_bLoaded; }
+	[[nodiscard]] bool hasSource() const { return m_pJsonData || m_pFileData; }
+
 	CAT_READONLY_PROPERTY( m_id, getId, m_ID );
 	CAT_PROPERTY( m_vPosition, getPosition, setPosition, m_VPosition );
 	CAT_READONLY_PROPERTY( m_mObjects, getObjects, m_MObjects );
-	CAT_READONLY_PROPERTY( m_aObjectIds, getObjectIds, m_AObjectIds );
+	CAT_PROPERTY( m_eState, getState, setState, m_EState );
+	CAT_CONST_READONLY_PROPERTY( m_nGeneration, getGeneration, m_NGeneration );
+	CAT_PROPERTY( m_bDirty, getDirty, setDirty, m_BDirty );
+	CAT_PROPERTY( m_bPrefetched, getPrefetched, setPrefetched, m_BPrefetched );
+	CAT_PROPERTY( m_nLastUsed, getLastUsed, setLastUsed, m_NLastUsed );
+	CAT_CONST_READONLY_PROPERTY( m_pJsonData, getJsonData, m_PJsonData );
+	CAT_CONST_READONLY_PROPERTY( m_pFileData, getFileData, m_PFileData );
 };
 } // namespace cat
 
@@ -3,16 +3,28 @@
 #include "Cat/Objects/CatLight.hpp"
 #include "Cat/Objects/CatVolume.hpp"
 #include "Cat/Objects/CatAssetLoader.hpp"
+#include "Cat/ECS/CatComponents.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
 #include <memory>
 #include <fstream>
+#include <filesystem>
 
 namespace cat
 {
 
+CatLevel::~CatLevel()
+{
+	// Loader tasks reference the level and the data it streams from.
+	cancelLoading();
+	waitForLoading();
+	// Requests made by tasks that were already past their cancellation check.
+	GetEditorInstance()->m_AssetLoader.cancel( this );
+}
+
 bool CatLevel::isFullyLoaded()
 {
 	return m_bIsFullyLoaded;
@@ -34,18 +46,562 @@ bool CatLevel::isLoadingFinished()
 	return false;
 }
 
-CatObject::Map CatLevel::getAllObjects()
+void CatLevel::cancelLoading()
+{
+	m_bCancelled = true;
+	GetEditorInstance()->m_AssetLoader.cancel( this );
+}
+
+void CatLevel::waitForLoading()
+{
+	if ( m_fLoaded.valid() )
+	{
+		m_fLoaded.wait();
+	}
+	GetEditorInstance()->m_TObjectLoader.wait_for_tasks();
+}
+
+void CatLevel::addObject( std::shared_ptr< CatObject > pObject,
+	const id_t idChunk /* = 0 */,
+	const uint32_t nGeneration /* = 0 */ )
+{
+	m_qPendingObjects.enqueue( { idChunk, nGeneration, std::move( pObject ) } );
+}
+
+void CatLevel::markChunkStreamed( const id_t idChunk, const uint32_t nGeneration )
+{
+	m_qStreamedChunks.enqueue( { idChunk, nGeneration } );
+}
+
+void CatLevel::update()
+{
+	integrateLoaded( m_nObjectsPerFrame );
+	enforceMemoryBudget();
+	dispatchStreaming();
+
+	if ( m_dReadyTime == 0.0 && m_bIsFullyLoaded && m_idLastChunk != 0 )
+	{
+		const bool bReady = std::ranges::all_of( m_mChunks | std::views::values,
+			[]( const auto& chunk ) { return !chunk->isLoaded() || chunk->getState() == ChunkState::eResident; } );
+		if ( bReady )
+		{
+			m_dReadyTime = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - m_tLoadStart ).count();
+			LOG_F( INFO, "Level %s ready after %.1f ms", m_sName.c_str(), m_dReadyTime );
+		}
+	}
+}
+
+void CatLevel::integrateLoaded( const size_t nMaxObjects /* = SIZE_MAX */ )
+{
+	// Taken before the objects, so every object queued before one of these chunks was marked is in the queue already.
+	std::pair< id_t, uint32_t > streamed;
+	while ( m_qStreamedChunks.try_dequeue( streamed ) )
+	{
+		m_aStreamedChunks.push_back( streamed );
+	}
+
+	bool bDrained = false;
+	size_t nIntegrated = 0;
+	while ( nIntegrated < nMaxObjects )
+	{
+		const auto nBatch = std::min< size_t >( nMaxObjects - nIntegrated, 64 );
+		m_aIntegrating.resize( nBatch );
+		const auto nCount = m_qPendingObjects.try_dequeue_bulk( m_aIntegrating.begin(), nBatch );
+		for ( size_t i = 0; i < nCount; ++i )
+		{
+			integrateObject( m_aIntegrating[i] );
+		}
+		m_aIntegrating.clear();
+
+		nIntegrated += nCount;
+		if ( nCount < nBatch )
+		{
+			bDrained = true;
+			break;
+		}
+	}
+
+	// Objects left in the queue could belong to these chunks, they are only complete once it was emptied.
+	if ( !bDrained ) return;
+
+	for ( const auto& [idChunk, nGeneration] : m_aStreamedChunks )
+	{
+		--m_nStreamsInFlight;
+
+		auto it = m_mChunks.find( idChunk );
+		if ( it == m_mChunks.end() ) continue;
+
+		auto chunk = it->second.get();
+		if ( chunk->getGeneration() == nGeneration && chunk->m_EState == ChunkState::eStreaming )
+		{
+			chunk->m_EState = ChunkState::eResident;
+		}
+	}
+	m_aStreamedChunks.clear();
+}
+
+void CatLevel::integrateObject( PendingObject& pending )
+{
+	auto& [idChunk, nGeneration, pObject] = pending;
+	auto pRaw = pObject.get();
+	if ( idChunk == 0 )
+	{
+		m_mObjects.emplace( pRaw->getId(), std::move( pObject ) );
+		addToRenderView( pRaw );
+		return;
+	}
+
+	auto it = m_mChunks.find( idChunk );
+	if ( it == m_mChunks.end() ) return;
+
+	auto chunk = it->second.get();
+	// The chunk was evicted or streamed again since this object was requested.
+	if ( nGeneration != 0 && nGeneration != chunk->getGeneration() ) return;
+
+	chunk->m_MObjects.emplace( pRaw->getId(), std::move( pObject ) );
+	pRaw->m_BVisible = chunk->isLoaded();
+	if ( chunk->isLoaded() )
+	{
+		addToRenderView( pRaw );
+	}
+}
+
+CatLevel::StreamingStats CatLevel::getStreamingStats() const
+{
+	StreamingStats stats{};
+	stats.nEvictedChunks = m_nEvictedChunks;
+	stats.nPrefetchRequests = m_nPrefetchRequests;
+	stats.nPrefetchHits = m_nPrefetchHits;
+	stats.nPrefetchLate = m_nPrefetchLate;
+	stats.nPrefetchWasted = m_nPrefetchWasted;
+	stats.nMisses = m_nMisses;
+	stats.nCancelledChunks = m_nCancelledChunks;
+	stats.dReadyTime = m_dReadyTime;
+	stats.nPendingObjects = static_cast< uint32_t >( m_qPendingObjects.size_approx() );
+	for ( const auto& chunk : m_mChunks | std::views::values )
+	{
+		if ( chunk->getState() == ChunkState::eResident ) ++stats.nResidentChunks;
+		if ( chunk->getState() == ChunkState::eQueued ) ++stats.nQueuedChunks;
+		if ( chunk->getState() == ChunkState::eStreaming ) ++stats.nStreamingChunks;
+		if ( chunk->getDirty() ) ++stats.nDirtyChunks;
+	}
+	return stats;
+}
+
+CatObject* CatLevel::getObject( const id_t id )
+{
+	if ( id == 0 ) return nullptr;
+
+	if ( auto it = m_mRenderViewIndices.find( id ); it != m_mRenderViewIndices.end() )
+	{
+		return m_aRenderView[it->second];
+	}
+
+	// Not in the view, the object is in an unloaded chunk.
+	if ( auto it = m_mObjects.find( id ); it != m_mObjects.end() )
+	{
+		return it->second.get();
+	}
+	for ( const auto& chunk : m_mChunks | std::views::values )
+	{
+		if ( auto it = chunk->m_MObjects.find( id ); it != chunk->m_MObjects.end() )
+		{
+			return it->second.get();
+		}
+	}
+	return nullptr;
+}
+
+void CatLevel::addToRenderView( CatObject* pObject )
+{
+	if ( m_mRenderViewIndices.contains( pObject->getId() ) ) return;
+
+	m_mRenderViewIndices[pObject->getId()] = m_aRenderView.size();
+	m_aRenderView.push_back( pObject );
+	m_transforms.add( pObject->m_transform );
+
+	const auto entity = m_world.create( ObjectComponent{ pObject } );
+	m_aRenderViewEntities.push_back( entity );
+	writeComponents( pObject, entity );
+}
+
+void CatLevel::writeComponents( CatObject* pObject, const Entity entity )
+{
+	const auto eType = pObject->getType();
+	if ( eType >= ObjectType::eLight )
+	{
+		m_world.add( entity,
+			LightComponent{
+				.pTransform = &pObject->m_transform,
+				.vColor = pObject->m_vColor,
+				.fIntensity = pObject->m_transform.scale.x,
+				.fRadius = pObject->m_transform.scale.y,
+			} );
+	}
+	else if ( eType >= ObjectType::eGameObject && pObject->m_pModel )
+	{
+		m_world.add( entity,
+			MeshComponent{
+				.pModel = pObject->m_pModel.get(),
+				.pTransform = &pObject->m_transform,
+				.vColor = pObject->m_vColor,
+				.fOpacity = pObject->m_fOpacity,
+			} );
+	}
+	else if ( eType >= ObjectType::eGrid )
+	{
+		m_world.add( entity, GridComponent{ .pTransform = &pObject->m_transform } );
+	}
+	else if ( eType >= ObjectType::eVolume )
+	{
+		m_world.add( entity,
+			VolumeComponent{
+				.pModel = pObject->m_pModel.get(),
+				.pTransform = &pObject->m_transform,
+				.vColor = pObject->m_vColor,
+			} );
+	}
+}
+
+void CatLevel::updateEntity( const id_t id )
+{
+	if ( auto it = m_mRenderViewIndices.find( id ); it != m_mRenderViewIndices.end() )
+	{
+		writeComponents( m_aRenderView[it->second], m_aRenderViewEntities[it->second] );
+	}
+}
+
+void CatLevel::removeFromRenderView( const id_t id )
+{
+	auto it = m_mRenderViewIndices.find( id );
+	if ( it == m_mRenderViewIndices.end() ) return;
+
+	// Swap with the last element so the view stays contiguous.
+	const auto nIndex = it->second;
+	m_mRenderViewIndices.erase( it );
+	m_transforms.remove( m_aRenderView[nIndex]->m_transform );
+	m_world.destroy( m_aRenderViewEntities[nIndex] );
+	if ( nIndex != m_aRenderView.size() - 1 )
+	{
+		m_aRenderView[nIndex] = m_aRenderView.back();
+		m_aRenderViewEntities[nIndex] = m_aRenderViewEntities.back();
+		m_mRenderViewIndices[m_aRenderView[nIndex]->getId()] = nIndex;
+	}
+	m_aRenderView.pop_back();
+	m_aRenderViewEntities.pop_back();
+}
+
+void CatLevel::setChunkLoaded( CatChunk* pChunk, const bool bLoaded )
+{
+	if ( pChunk->isLoaded() == bLoaded ) return;
+
+	if ( bLoaded )
+	{
+		if ( pChunk->m_BPrefetched )
+		{
+			pChunk->m_BPrefetched = false;
+			if ( pChunk->m_EState == ChunkState::eResident )
+			{
+				++m_nPrefetchHits;
+			}
+			else
+			{
+				++m_nPrefetchLate;
+				if ( pChunk->m_EState == ChunkState::eStreaming )
+				{
+					GetEditorInstance()->m_AssetLoader.setChunkPriority(
+						this, pChunk->getId(), CatAssetLoader::RequestPriority::eRequired );
+				}
+			}
+		}
+		else if ( pChunk->m_EState != ChunkState::eResident )
+		{
+			++m_nMisses;
+		}
+
+		pChunk->load();
+		for ( const auto& obj : pChunk->m_MObjects | std::views::values )
+		{
+			addToRenderView( obj.get() );
+		}
+
+		// Prefetched chunks that are still queued move up to the required ones.
+		if ( pChunk->m_EState == ChunkState::eUnloaded || pChunk->m_EState == ChunkState::eQueued )
+		{
+			queueChunk( pChunk );
+			m_qRequiredChunks.push_back( pChunk->getId() );
+		}
+	}
+	else
+	{
+		pChunk->unload();
+		for ( const auto& id : pChunk->m_MObjects | std::views::keys )
+		{
+			removeFromRenderView( id );
+		}
+
+		// Kept resident until the memory budget needs the space, queued streams are not needed anymore.
+		pChunk->m_NLastUsed = ++m_nChunkUseCounter;
+		if ( pChunk->m_EState == ChunkState::eQueued )
+		{
+			pChunk->m_EState = ChunkState::eUnloaded;
+		}
+		else if ( pChunk->m_EState == ChunkState::eStreaming && !pChunk->m_BDirty )
+		{
+			// The models still queued for it are not needed anymore, the stale objects are dropped by the generation check.
+			GetEditorInstance()->m_AssetLoader.cancel( this, pChunk->getId() );
+			pChunk->evict();
+			++m_nCancelledChunks;
+		}
+	}
+}
+
+void CatLevel::queueChunk( CatChunk* pChunk )
+{
+	pChunk->m_EState = ChunkState::eQueued;
+}
+
+void CatLevel::dispatchStreaming()
+{
+	// One chunk stream per object loader thread.
+	const auto nMaxStreams = GetEditorInstance()->m_TObjectLoader.get_thread_count();
+	while ( m_nStreamsInFlight < nMaxStreams )
+	{
+		id_t id = 0;
+		if ( !m_qRequiredChunks.empty() )
+		{
+			id = m_qRequiredChunks.front();
+			m_qRequiredChunks.pop_front();
+		}
+		else if ( !m_aPrefetchChunks.empty() )
+		{
+			id = m_aPrefetchChunks.front();
+			m_aPrefetchChunks.erase( m_aPrefetchChunks.begin() );
+		}
+		else
+		{
+			break;
+		}
+
+		// Entries are not removed when a chunk gets cancelled or streamed by other means.
+		auto pChunk = m_mChunks[id].get();
+		if ( pChunk->m_EState != ChunkState::eQueued ) continue;
+
+		streamChunk( pChunk );
+	}
+}
+
+template < typename TFunction >
+void CatLevel::forEachChunkInRadius( const id_t id, const int nRadius, TFunction&& fnVisit )
+{
+	for ( int j = -nRadius; j <= nRadius; j++ )
+	{
+		for ( int i = -nRadius; i <= nRadius; i++ )
+		{
+			auto neighbourId = id + ( j * m_vSize.y ) + i;
+			if ( neighbourId <= 0 || neighbourId > m_vSize.x * m_vSize.y ) continue;
+			// dont wrap on edge
+			// if ( m_mChunks[neighbourId]->m_VPosition.x + i <= 0 || m_mChunks[neighbourId]->m_VPosition.x + i >= m_vSize.x )
+			// continue;
+
+			fnVisit( m_mChunks[neighbourId].get() );
+		}
+	}
+}
+
+void CatLevel::prefetchChunks( const glm::vec3& vLocation, const double dDeltaTime )
+{
+	m_dTime += dDeltaTime;
+	m_aCameraHistory.emplace_back( m_dTime, vLocation );
+	while ( m_aCameraHistory.size() > 2 && m_dTime - m_aCameraHistory.front().first > CAMERA_HISTORY_TIME )
+	{
+		m_aCameraHistory.pop_front();
+	}
+
+	// Drop the previous prediction, chunks that are still predicted get queued again below.
+	for ( const auto id : m_aPrefetchChunks )
+	{
+		auto pChunk = m_mChunks[id].get();
+		if ( pChunk->m_BPrefetched && pChunk->m_EState == ChunkState::eQueued )
+		{
+			pChunk->m_BPrefetched = false;
+			pChunk->m_EState = ChunkState::eUnloaded;
+		}
+	}
+	m_aPrefetchChunks.clear();
+
+	if ( !m_bPrefetch || m_idLastChunk == 0 || m_aCameraHistory.size() < 2 ) return;
+	// The load radius already covers the whole level.
+	if ( m_nLastRadius >= std::max( m_vSize.x, m_vSize.y ) ) return;
+
+	const auto& [dOldTime, vOldLocation] = m_aCameraHistory.front();
+	if ( m_dTime - dOldTime <= 0.0 ) return;
+
+	auto vVelocity = ( vLocation - vOldLocation ) / static_cast< float >( m_dTime - dOldTime );
+	vVelocity.y = 0.0f;
+	if ( glm::dot( vVelocity, vVelocity ) < 0.01f ) return;
+
+	// Sample the extrapolated path, a fast camera would skip chunks with a single prediction. Closer samples come first so
+	// the chunks needed soonest are streamed first.
+	for ( int nStep = 1; nStep <= PREFETCH_STEPS; ++nStep )
+	{
+		const auto fTime = m_fPrefetchTime * static_cast< float >( nStep ) / static_cast< float >( PREFETCH_STEPS );
+		const auto idPredicted = getChunkAtLocation( vLocation + vVelocity * fTime );
+		if ( idPredicted == 0 ) continue;
+
+		forEachChunkInRadius( idPredicted, m_nLastRadius,
+			[this]( CatChunk* pChunk )
+			{
+				if ( pChunk->isLoaded() || pChunk->m_EState != ChunkState::eUnloaded ) return;
+
+				pChunk->m_BPrefetched = true;
+				queueChunk( pChunk );
+				m_aPrefetchChunks.push_back( pChunk->getId() );
+			} );
+	}
+}
+
+void CatLevel::streamChunk( CatChunk* pChunk )
+{
+	const auto nGeneration = pChunk->beginStreaming();
+	if ( !pChunk->hasSource() )
+	{
+		pChunk->m_EState = ChunkState::eResident;
+		return;
+	}
+
+	if ( pChunk->m_BPrefetched )
+	{
+		++m_nPrefetchRequests;
+	}
+	++m_nStreamsInFlight;
+
+	const auto ePriority =
+		pChunk->m_BPrefetched ? CatAssetLoader::RequestPriority::ePrefetch : CatAssetLoader::RequestPriority::eRequired;
+	auto task = [this, pChunk, nGeneration, ePriority]()
+	{
+		const auto id = pChunk->getId();
+		auto& assetLoader = GetEditorInstance()->m_AssetLoader;
+		auto aFutures = std::vector< std::shared_future< std::shared_ptr< CatModel > > >();
+
+		try
+		{
+			if ( const auto pJsonData = pChunk->getJsonData() )
+			{
+				for ( const auto& object : ( *pJsonData )["objects"] )
+				{
+					if ( isCancelled() ) break;
+					if ( object.is_null() ) continue;
+					aFutures.push_back( assetLoader.load( object, this, id, nGeneration, ePriority ) );
+				}
+			}
+			else
+			{
+				for ( const auto& object : m_pLevelFile->getObjects( *pChunk->getFileData() ) )
+				{
+					if ( isCancelled() ) break;
+					aFutures.push_back( assetLoader.load( object, *m_pLevelFile, this, id, nGeneration, ePriority ) );
+				}
+			}
+
+			// Objects are handed to the level before their model future is ready.
+			for ( auto& f : aFutures )
+			{
+				if ( f.valid() )
+				{
+					f.wait();
+				}
+			}
+		}
+		catch ( const std::exception& e )
+		{
+			LOG_F( ERROR, "Failed to stream chunk %llu: %s", id, e.what() );
+		}
+
+		markChunkStreamed( id, nGeneration );
+	};
+
+	GetEditorInstance()->m_TObjectLoader.push_task( std::move( task ) );
+}
+
+void CatLevel::evictChunk( CatChunk* pChunk )
+{
+	for ( const auto& id : pChunk->m_MObjects | std::views::keys )
+	{
+		removeFromRenderView( id );
+	}
+	if ( pChunk->m_BPrefetched )
+	{
+		pChunk->m_BPrefetched = false;
+		++m_nPrefetchWasted;
+	}
+	pChunk->evict();
+	++m_nEvictedChunks;
+
+	DLOG_F( INFO, "Evicted chunk: %llu", pChunk->getId() );
+}
+
+void CatLevel::enforceMemoryBudget()
 {
-	// return m_mObjects;
+	auto& assetLoader = GetEditorInstance()->m_AssetLoader;
+	bool bEvicted = false;
+	while ( assetLoader.isOverBudget() )
+	{
+		CatChunk* pOldest = nullptr;
+		for ( const auto& chunk : m_mChunks | std::views::values )
+		{
+			if ( chunk->isLoaded() || chunk->m_BDirty || chunk->m_EState != ChunkState::eResident ) continue;
+			if ( !pOldest || chunk->m_NLastUsed < pOldest->m_NLastUsed )
+			{
+				pOldest = chunk.get();
+			}
+		}
+		if ( !pOldest ) break;
+
+		evictChunk( pOldest );
+		assetLoader.releaseUnused();
+		bEvicted = true;
+	}
+	// Once for all the evicted chunks, it walks every pool.
+	if ( bEvicted )
+	{
+		CatObjectPool::TrimAll();
+	}
+}
 
-	// Old copy code
-	CatObject::Map mObjects;
-	mObjects.insert( m_mObjects.begin(), m_mObjects.end() );
+void CatLevel::bindChunkSources()
+{
 	for ( const auto& chunk : m_mChunks | std::views::values )
 	{
-		mObjects.insert( chunk->m_MObjects.begin(), chunk->m_MObjects.end() );
+		chunk->clearSource();
+	}
+
+	if ( m_pLevelFile )
+	{
+		for ( const auto& chunkData : m_pLevelFile->getChunks() )
+		{
+			auto it = m_mChunks.find( chunkData.nId );
+			if ( it == m_mChunks.end() ) continue;
+
+			it->second->m_VPosition = glm::make_vec2( chunkData.aPosition );
+			it->second->setSource( &chunkData );
+		}
+		return;
+	}
+
+	if ( !m_jData.contains( "chunks" ) ) return;
+
+	for ( const auto& chunkData : m_jData["chunks"] )
+	{
+		if ( chunkData.is_null() ) continue;
+
+		auto it = m_mChunks.find( chunkData["id"].get< id_t >() );
+		if ( it == m_mChunks.end() ) continue;
+
+		const auto& jPosition = chunkData["position"];
+		it->second->m_VPosition = glm::ivec2( jPosition[0].get< int >(), jPosition[1].get< int >() );
+		it->second->setSource( &chunkData );
 	}
-	return mObjects;
 }
 
 std::unique_ptr< CatLevel > CatLevel::create( const std::string& sName,
@@ -56,6 +612,7 @@ std::unique_ptr< CatLevel > CatLevel::create( const std::string& sName,
 
 	auto grid = CatObject::create( "BaseGrid", "", ObjectType::eGrid );
 	// grid->m_transform.translation = glm::vec3( 0.0f, 0.001f, 0.0f );
+	level->addToRenderView( grid.get() );
 	level->m_mObjects.emplace( grid->getId(), std::move( grid ) );
 
 	id_t id = 0;
@@ -81,10 +638,22 @@ std::unique_ptr< CatLevel > CatLevel::create( const std::string& sName,
 std::unique_ptr< CatLevel > CatLevel::load( const std::string& sName )
 {
 	LOG_SCOPE_FUNCTION( INFO );
-	std::string sPath = LEVELS_BASE_PATH + sName;
-	if ( !sPath.ends_with( ".json" ) )
+	const auto tStart = std::chrono::steady_clock::now();
+	// The name keeps the extension it resolved to, so save() writes the level back in the format it was loaded from.
+	std::string sFileName = sName;
+	if ( !sFileName.ends_with( ".json" ) && !sFileName.ends_with( CatLevelFile::EXTENSION ) )
 	{
-		sPath += ".json";
+		sFileName += std::filesystem::exists( LEVELS_BASE_PATH + sFileName + CatLevelFile::EXTENSION )
+			? CatLevelFile::EXTENSION
+			: ".json";
+	}
+	const std::string sPath = LEVELS_BASE_PATH + sFileName;
+
+	if ( sPath.ends_with( CatLevelFile::EXTENSION ) )
+	{
+		auto level = loadBinary( sFileName, sPath );
+		level->m_tLoadStart = tStart;
+		return level;
 	}
 
 	json jLevelData;
@@ -96,9 +665,12 @@ std::unique_ptr< CatLevel > CatLevel::load( const std::string& sName )
 	glm::ivec2 vChunkSize = glm::make_vec2( jLevelData["chunkSize"].get< std::vector< int > >().data() );
 
 	// We only block to parse the level data from disk, loading objects is done async.
-	auto level = create( sName, vSize, vChunkSize );
-	level->m_jData = jLevelData;
+	auto level = create( sFileName, vSize, vChunkSize );
+	level->m_jData = std::move( jLevelData );
+	level->m_tLoadStart = tStart;
 	level->m_bIsFullyLoaded = false;
+	// Chunk objects are streamed once the chunks enter the load radius.
+	level->bindChunkSources();
 
 	auto task = []( CatLevel* level )
 	{
@@ -106,31 +678,12 @@ std::unique_ptr< CatLevel > CatLevel::load( const std::string& sName )
 		auto aGlobalFutures = std::vector< std::shared_future< std::shared_ptr< CatModel > > >();
 		for ( auto& object : level->m_jData["globals"] )
 		{
+			if ( level->isCancelled() ) break;
 			if ( object.is_null() ) continue;
 
 			// TODO: multiple objects of same model (shouldn't wait) block the object after them
 			LOG_SCOPE_F( INFO, "Loading object: %s", object["name"].get< std::string >().c_str() );
-			aGlobalFutures.push_back( GetEditorInstance()->m_AssetLoader.load( object, level->m_mObjects ) );
-		}
-
-		for ( auto& chunkData : level->m_jData["chunks"] )
-		{
-			if ( chunkData.is_null() ) continue;
-
-			auto id = chunkData["id"].get< id_t >();
-			auto vPosition = glm::make_vec2( chunkData["position"].get< std::vector< int > >().data() );
-
-			auto chunk = level->m_mChunks.at( id ).get();
-			chunk->m_VPosition = vPosition;
-
-			for ( auto& object : chunkData["objects"] )
-			{
-				if ( object.is_null() ) continue;
-
-				// TODO: multiple objects of same model (shouldn't wait) block the object after them
-				LOG_SCOPE_F( INFO, "Loading object: %s", object["name"].get< std::string >().c_str() );
-				aGlobalFutures.push_back( GetEditorInstance()->m_AssetLoader.load( object, chunk->m_MObjects ) );
-			}
+			aGlobalFutures.push_back( GetEditorInstance()->m_AssetLoader.load( object, level ) );
 		}
 
 		// Wait for all aGlobalFutures to finish.
@@ -144,18 +697,54 @@ std::unique_ptr< CatLevel > CatLevel::load( const std::string& sName )
 			}
 		}
 
-		for ( auto& chunk : level->m_mChunks | std::views::values )
+		DLOG_F( INFO, "Fully loaded level: %s", ( LEVELS_BASE_PATH + level->m_sName ).c_str() );
+	};
+
+	LOG_F( INFO, "Loaded level data: %s", ( LEVELS_BASE_PATH + level->m_sName ).c_str() );
+
+	level->m_fLoaded = GetEditorInstance()->m_TLevelLoader.submit( std::move( task ), level.get() );
+
+	return level;
+}
+
+std::unique_ptr< CatLevel > CatLevel::loadBinary( const std::string& sName, const std::string& sPath )
+{
+	auto pLevelFile = CatLevelFile::open( sPath );
+	if ( !pLevelFile )
+	{
+		return create( sName );
+	}
+
+	// Nothing to parse, the records are read straight from the mapped file by the loaders.
+	auto level = create( sName, pLevelFile->getSize(), pLevelFile->getChunkSize() );
+	level->m_pLevelFile = std::move( pLevelFile );
+	level->m_bIsFullyLoaded = false;
+	// Chunk objects are streamed once the chunks enter the load radius.
+	level->bindChunkSources();
+
+	auto task = []( CatLevel* level )
+	{
+		LOG_SCOPE_F( INFO, "Running binary level load task" );
+		const auto& file = *level->m_pLevelFile;
+		auto aGlobalFutures = std::vector< std::shared_future< std::shared_ptr< CatModel > > >();
+		for ( const auto& object : file.getGlobals() )
 		{
-			for ( auto& key : chunk->m_MObjects | std::views::keys )
+			if ( level->isCancelled() ) break;
+			aGlobalFutures.push_back( GetEditorInstance()->m_AssetLoader.load( object, file, level ) );
+		}
+
+		for ( auto& f : aGlobalFutures )
+		{
+			if ( f.valid() )
 			{
-				chunk->m_AObjectIds.push_back( key );
+				f.wait();
 			}
 		}
 
 		DLOG_F( INFO, "Fully loaded level: %s", ( LEVELS_BASE_PATH + level->m_sName ).c_str() );
 	};
 
-	LOG_F( INFO, "Loaded level data: %s", ( LEVELS_BASE_PATH + level->m_sName ).c_str() );
+	LOG_F( INFO, "Mapped level data: %s", sPath.c_str() );
 
 	level->m_fLoaded = GetEditorInstance()->m_TLevelLoader.submit( std::move( task ), level.get() );
 
@@ -168,11 +757,77 @@ void CatLevel::save( const std::string& sFileName /* = "" */ )
 
 	if ( !sFileName.empty() )
 	{
+		// Without an extension the level is saved in the format it was loaded from, load() would pick up a stale binary
+		// level over a newer json one.
+		const bool bBinary = m_sName.ends_with( CatLevelFile::EXTENSION );
 		m_sName = sFileName;
+		if ( !m_sName.ends_with( ".json" ) && !m_sName.ends_with( CatLevelFile::EXTENSION ) )
+		{
+			m_sName += bBinary ? CatLevelFile::EXTENSION : ".json";
+		}
 	}
 
 	auto sPath = LEVELS_BASE_PATH + m_sName;
 
+	// Streaming reads the current level data, and objects still queued have to be part of the save.
+	waitForLoading();
+	integrateLoaded();
+
+	if ( sPath.ends_with( CatLevelFile::EXTENSION ) )
+	{
+		CatLevelFile::Writer writer( m_vSize, m_vChunkSize );
+		for ( const auto& obj : m_mObjects | std::views::values )
+		{
+			obj->save( writer );
+		}
+		for ( const auto& chunk : m_mChunks | std::views::values )
+		{
+			writer.beginChunk( chunk->m_ID, chunk->m_VPosition );
+			if ( chunk->m_EState == ChunkState::eResident )
+			{
+				for ( const auto& obj : chunk->m_MObjects | std::views::values )
+				{
+					obj->save( writer );
+				}
+			}
+			else if ( const auto pJsonData = chunk->getJsonData() )
+			{
+				for ( const auto& object : ( *pJsonData )["objects"] )
+				{
+					if ( object.is_null() ) continue;
+					writer.addObject( object );
+				}
+			}
+			else if ( const auto pFileData = chunk->getFileData() )
+			{
+				for ( const auto& object : m_pLevelFile->getObjects( *pFileData ) )
+				{
+					writer.addObject( *m_pLevelFile, object );
+				}
+			}
+		}
+
+		// The writer copied everything it needs, the mapping has to be released before overwriting the file.
+		if ( m_pLevelFile && m_pLevelFile->getPath() == sPath )
+		{
+			m_pLevelFile.reset();
+		}
+
+		if ( writer.write( sPath ) )
+		{
+			// Unloaded chunks stream from the saved file from now on.
+			m_pLevelFile = CatLevelFile::open( sPath );
+			m_jData = {};
+			LOG_F( INFO, "Saved level: %s", sPath.c_str() );
+		}
+		else if ( !m_pLevelFile )
+		{
+			m_pLevelFile = CatLevelFile::open( sPath );
+		}
+		bindChunkSources();
+
+		return;
+	}
 
 	nlohmann::ordered_json file;
 
@@ -202,12 +857,27 @@ void CatLevel::save( const std::string& sFileName /* = "" */ )
 			chunkData["position"] = chunk->m_VPosition;
 
 			json objects = json::array();
-			int i = 0;
-			for ( const auto& obj : chunk->m_MObjects | std::views::values )
+			if ( chunk->m_EState == ChunkState::eResident )
 			{
-				if ( const auto& save = obj->save(); !save.empty() )
+				int i = 0;
+				for ( const auto& obj : chunk->m_MObjects | std::views::values )
 				{
-					objects[i++] = save;
+					if ( const auto& save = obj->save(); !save.empty() )
+					{
+						objects[i++] = save;
+					}
+				}
+			}
+			else if ( const auto pJsonData = chunk->getJsonData() )
+			{
+				// Not streamed in, the source data is still up to date.
+				objects = ( *pJsonData )["objects"];
+			}
+			else if ( const auto pFileData = chunk->getFileData() )
+			{
+				for ( const auto& object : m_pLevelFile->getObjects( *pFileData ) )
+				{
+					objects.push_back( m_pLevelFile->toJson( object ) );
 				}
 			}
 			chunkData["objects"] = objects;
@@ -226,13 +896,19 @@ void CatLevel::save( const std::string& sFileName /* = "" */ )
 	ofs << file.dump( -1, '\t' ) << std::endl;
 	ofs.close();
 
+	// Unloaded chunks stream from the saved data from now on.
 	m_jData = file;
+	m_pLevelFile.reset();
+	bindChunkSources();
 
 	LOG_F( INFO, "Saved level: %s", sPath.c_str() );
 }
 
 void CatLevel::updateObjectLocation( id_t id )
 {
+	// The scale of a light is its intensity and radius.
+	updateEntity( id );
+
 	{
 		auto it = m_mObjects.find( id );
 		if ( it != m_mObjects.end() )
@@ -246,6 +922,9 @@ void CatLevel::updateObjectLocation( id_t id )
 		auto it = chunk->m_MObjects.find( id );
 		if ( it != chunk->m_MObjects.end() )
 		{
+			// The object was edited, the chunk can't be restored from the level data anymore.
+			chunk->m_BDirty = true;
+
 			auto obj = it->second.get();
 			auto newId = getChunkAtLocation( obj->m_transform.translation );
 			if ( newId <= 0 || newId > m_vSize.x * m_vSize.y ) return;
@@ -256,6 +935,25 @@ void CatLevel::updateObjectLocation( id_t id )
 
 			newChunk->m_MObjects[obj->getId()] = std::move( it->second );
 			chunk->m_MObjects.erase( it );
+			newChunk->m_BDirty = true;
+
+			// The rest of the new chunk is needed in memory too, otherwise it could not be saved.
+			if ( newChunk->m_EState == ChunkState::eUnloaded || newChunk->m_EState == ChunkState::eQueued )
+			{
+				streamChunk( newChunk );
+			}
+
+			// Moving into a chunk that is not loaded hides the object until that chunk is loaded.
+			if ( newChunk->isLoaded() )
+			{
+				obj->m_BVisible = true;
+				addToRenderView( obj );
+			}
+			else
+			{
+				obj->m_BVisible = false;
+				removeFromRenderView( obj->getId() );
+			}
 			return;
 		}
 	}
@@ -283,30 +981,18 @@ void CatLevel::loadChunk( const glm::vec3& vLocation, int nRadius /* = 1 */ )
 	std::swap( m_aLoadedChunks, m_aLastLoadedChunks );
 	std::fill( m_aLoadedChunks.begin(), m_aLoadedChunks.end(), false );
 
-	if ( m_mChunks[id]->load() )
-	{
-		m_aLoadedChunks[id] = true;
-	}
+	setChunkLoaded( m_mChunks[id].get(), true );
+	m_aLoadedChunks[id] = true;
 
 	int lx = -std::min( m_mChunks[id]->m_VPosition.x / m_vChunkSize.x, nRadius );
 	int hx = std::min( m_mChunks[id]->m_VPosition.x / m_vChunkSize.x, nRadius );
 
-	for ( int j = -nRadius; j <= nRadius; j++ )
-	{
-		for ( int i = -nRadius; i <= nRadius; i++ )
+	forEachChunkInRadius( id, nRadius,
+		[this]( CatChunk* pChunk )
 		{
-			auto neighbourId = id + ( j * m_vSize.y ) + i;
-			if ( neighbourId <= 0 || neighbourId > m_vSize.x * m_vSize.y ) continue;
-			// dont wrap on edge
-			// if ( m_mChunks[neighbourId]->m_VPosition.x + i <= 0 || m_mChunks[neighbourId]->m_VPosition.x + i >= m_vSize.x )
-			// continue;
-
-			if ( m_mChunks[neighbourId]->load() )
-			{
-				m_aLoadedChunks[neighbourId] = true;
-			}
-		}
-	}
+			setChunkLoaded( pChunk, true );
+			m_aLoadedChunks[pChunk->getId()] = true;
+		} );
 
 	// Unload chunks that are too far away
 
@@ -314,7 +1000,7 @@ void CatLevel::loadChunk( const glm::vec3& vLocation, int nRadius /* = 1 */ )
 	{
 		if ( m_aLastLoadedChunks[i] && !m_aLoadedChunks[i] )
 		{
-			m_mChunks[i]->unload();
+			setChunkLoaded( m_mChunks[i].get(), false );
 		}
 	}
 }
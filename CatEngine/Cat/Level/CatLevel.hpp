@@ -4,16 +4,23 @@
 #include "Cat/Utils/CatUtils.hpp"
 #include "Cat/Objects/CatObject.hpp"
 #include "Cat/Level/CatChunk.hpp"
+#include "Cat/ECS/CatWorld.hpp"
+#include "Cat/Level/CatLevelFile.hpp"
 #include "Cat/Terrain/CatTerrain.hpp"
 
+#include <concurrentqueue.h>
+
 #include <string>
 #include <utility>
 #include <future>
 #include <queue>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace cat
 {
-
 // TODO: Levels are rectangular, and chunks have ascending ids, so you can easily calculate the neighbouring chunk ids on the x
 // axis by adding/subtracting 1 and ont the z axis by adding/subtracting the width of the level in chunks.
 // By storing the currently loaded chunk ids you can unload chunks when moving by checking if the old loadedchunks contained the
@@ -26,6 +33,8 @@ private:
 	glm::ivec2 m_vSize;
 	glm::ivec2 m_vChunkSize;
 	id_t m_idCurrentChunk = 0;
+	// The matrices of the render view's objects, declared before the objects so it outlives them.
+	CatTransformSystem m_transforms;
 	std::unordered_map< id_t, std::unique_ptr< CatChunk > > m_mChunks;
 	std::vector< bool > m_aLoadedChunks;
 	std::vector< bool > m_aLastLoadedChunks;
@@ -33,29 +42,155 @@ private:
 	std::unique_ptr< CatTerrain > m_pTerrain;
 	std::future< void > m_fLoaded;
 	json m_jData;
+	// Mapped binary level, chunks stream their object records from it so it stays open with the level.
+	std::unique_ptr< CatLevelFile > m_pLevelFile;
+
+	// Flat view of every live object (globals and objects of loaded chunks), updated incrementally so render systems can
+	// iterate it every frame without copying the object maps.
+	std::vector< CatObject* > m_aRenderView;
+	std::unordered_map< id_t, size_t > m_mRenderViewIndices;
+	// An entity for every object of the render view at the same index, the render systems query their components instead
+	// of testing the object types.
+	CatWorld m_world;
+	std::vector< Entity > m_aRenderViewEntities;
+
+	struct PendingObject
+	{
+		id_t idChunk;
+		uint32_t nGeneration;
+		std::shared_ptr< CatObject > pObject;
+	};
+
+	// Objects and chunks finished by the loader threads, waiting to be integrated on the main thread.
+	// The loader threads never wait on the main thread, and the main thread integrates at most m_nObjectsPerFrame objects a
+	// frame so loading doesn't show up in the frame time.
+	moodycamel::ConcurrentQueue< PendingObject > m_qPendingObjects;
+	moodycamel::ConcurrentQueue< std::pair< id_t, uint32_t > > m_qStreamedChunks;
+	// The queue only keeps the order of each thread, so streamed chunks wait here until the object queue was emptied.
+	std::vector< std::pair< id_t, uint32_t > > m_aStreamedChunks;
+	std::vector< PendingObject > m_aIntegrating;
+	uint32_t m_nObjectsPerFrame = 256;
+
+	uint64_t m_nChunkUseCounter = 0;
+	uint32_t m_nEvictedChunks = 0;
+
+	// Chunks waiting for a free streaming slot, the ones inside the load radius go first.
+	std::deque< id_t > m_qRequiredChunks;
+	std::vector< id_t > m_aPrefetchChunks;
+	uint32_t m_nStreamsInFlight = 0;
+
+	// Camera samples used to predict the chunks that will enter the load radius.
+	std::deque< std::pair< double, glm::vec3 > > m_aCameraHistory;
+	double m_dTime = 0.0;
+	bool m_bPrefetch = true;
+	float m_fPrefetchTime = 0.5f;
+
+	uint32_t m_nPrefetchRequests = 0;
+	uint32_t m_nPrefetchHits = 0;
+	uint32_t m_nPrefetchLate = 0;
+	uint32_t m_nPrefetchWasted = 0;
+	uint32_t m_nMisses = 0;
+	uint32_t m_nCancelledChunks = 0;
+
+	// Set once the level is being replaced, loader threads stop requesting its objects.
+	std::atomic< bool > m_bCancelled = false;
+	// Time to the first frame with the globals and every chunk in the load radius resident.
+	std::chrono::steady_clock::time_point m_tLoadStart = std::chrono::steady_clock::now();
+	double m_dReadyTime = 0.0;
+
+	void addToRenderView( CatObject* pObject );
+	void removeFromRenderView( id_t id );
+	// Copies the render data of the object into the components of its entity.
+	void writeComponents( CatObject* pObject, Entity entity );
+	void setChunkLoaded( CatChunk* pChunk, bool bLoaded );
+
+	template < typename TFunction >
+	void forEachChunkInRadius( id_t id, int nRadius, TFunction&& fnVisit );
+
+	// Without a limit everything queued so far is integrated.
+	void integrateLoaded( size_t nMaxObjects = SIZE_MAX );
+	void integrateObject( PendingObject& pending );
+	void queueChunk( CatChunk* pChunk );
+	// Starts streaming queued chunks while there are free slots.
+	void dispatchStreaming();
+	// Reads the chunk's objects from the level data on the object loader threads.
+	void streamChunk( CatChunk* pChunk );
+	void markChunkStreamed( id_t idChunk, uint32_t nGeneration );
+	void evictChunk( CatChunk* pChunk );
+	// Evicts the least recently used chunks outside of the load radius while the models are over the memory budget.
+	void enforceMemoryBudget();
+	// Points the chunks at their data in m_jData or m_pLevelFile.
+	void bindChunkSources();
+	void waitForLoading();
+
+	[[nodiscard]] static std::unique_ptr< CatLevel > loadBinary( const std::string& sName, const std::string& sPath );
 
 public:
-	virtual ~CatLevel() = default;
+	struct StreamingStats
+	{
+		uint32_t nResidentChunks = 0;
+		uint32_t nStreamingChunks = 0;
+		uint32_t nDirtyChunks = 0;
+		uint32_t nEvictedChunks = 0;
+		uint32_t nQueuedChunks = 0;
+		// Prefetched chunks that were resident, still streaming, or evicted before entering the load radius.
+		uint32_t nPrefetchRequests = 0;
+		uint32_t nPrefetchHits = 0;
+		uint32_t nPrefetchLate = 0;
+		uint32_t nPrefetchWasted = 0;
+		// Chunks that entered the load radius without being prefetched or resident.
+		uint32_t nMisses = 0;
+		// Chunks that left the load radius while streaming.
+		uint32_t nCancelledChunks = 0;
+		// Loaded objects waiting to be integrated.
+		uint32_t nPendingObjects = 0;
+		// Milliseconds from the start of loading to the first frame with everything around the camera resident, 0 until then.
+		double dReadyTime = 0.0;
+	};
+
+	static constexpr double CAMERA_HISTORY_TIME = 0.25;
+	static constexpr int PREFETCH_STEPS = 4;
+
+	virtual ~CatLevel();
 
 	[[nodiscard]] static std::unique_ptr< CatLevel > create( const std::string& sName,
 		glm::ivec2 vSize = glm::ivec2( 7, 7 ),
 		glm::ivec2 vChunkSize = glm::ivec2( 10, 10 ) );
+	// Writes the binary format if the file name ends with CatLevelFile::EXTENSION, json otherwise.
 	void save( const std::string& sFileName = "" );
-	[[nodiscard]] static std::unique_ptr< CatLevel > load( const std::string& levelData );
+	// Without an extension the binary level is preferred if it exists.
+	[[nodiscard]] static std::unique_ptr< CatLevel > load( const std::string& sName );
 
 	bool isFullyLoaded();
 	bool isLoadingFinished();
+	// Drops the level's queued asset requests, called before the level is replaced.
+	void cancelLoading();
+	[[nodiscard]] bool isCancelled() const { return m_bCancelled; }
 
 	void updateObjectLocation( id_t id );
+	// Has to be called after changing the color or opacity of an object in the render view, transforms only need markDirty().
+	void updateEntity( id_t id );
 	id_t getChunkAtLocation( const glm::vec3& vLocation );
 
-	CatObject::Map getAllObjects();
+	// Thread safe, the object is integrated into the level on the next update(). Chunk id 0 means global object.
+	// Objects streamed for an older generation of the chunk are dropped, generation 0 is always accepted.
+	void addObject( std::shared_ptr< CatObject > pObject, id_t idChunk = 0, uint32_t nGeneration = 0 );
+	void update();
+
+	[[nodiscard]] StreamingStats getStreamingStats() const;
+
+	[[nodiscard]] const std::vector< CatObject* >& getRenderView() const { return m_aRenderView; }
+	[[nodiscard]] CatWorld& getWorld() { return m_world; }
+	[[nodiscard]] CatTransformSystem& getTransforms() { return m_transforms; }
+	[[nodiscard]] CatObject* getObject( id_t id );
 
 	void loadChunk( const glm::vec3& vLocationm, int nRadius = 1 );
+	// Queues the chunks around the camera's extrapolated path at a lower priority than the ones in the load radius.
+	void prefetchChunks( const glm::vec3& vLocation, double dDeltaTime );
 
 	bool m_bIsFullyLoaded = false;
-	id_t m_idLastChunk;
-	int m_nLastRadius;
+	id_t m_idLastChunk = 0;
+	int m_nLastRadius = 0;
 
 protected:
 	[[nodiscard]] explicit CatLevel( std::string sName, const glm::ivec2 vSize, const glm::ivec2 vChunkSize )
@@ -69,6 +204,9 @@ public:
 	CAT_PROPERTY( m_sName, getName, setName, m_SName );
 	CAT_READONLY_PROPERTY( m_idCurrentChunk, getCurrentChunkId, m_IDCurrentChunk );
 	CAT_READONLY_PROPERTY( m_pTerrain, getTerrain, m_PTerrain );
+	CAT_PROPERTY( m_bPrefetch, getPrefetch, setPrefetch, m_BPrefetch );
+	CAT_PROPERTY( m_fPrefetchTime, getPrefetchTime, setPrefetchTime, m_FPrefetchTime );
+	CAT_PROPERTY( m_nObjectsPerFrame, getObjectsPerFrame, setObjectsPerFrame, m_NObjectsPerFrame );
 };
 
 } // namespace cat
@@ -0,0 +1,309 @@
+#include "CatLevelFile.hpp"
+
+#include "loguru.hpp"
+
+#include <fstream>
+
+namespace cat
+{
+static uint64_t AlignOffset( const uint64_t nOffset )
+{
+	return ( nOffset + 7 ) & ~uint64_t( 7 );
+}
+
+static void ReadVec3( const json& array, float* pOut )
+{
+	for ( int i = 0; i < 3; ++i )
+	{
+		pOut[i] = array[i].get< float >();
+	}
+}
+
+static void WriteVec3( const glm::vec3& vValue, float* pOut )
+{
+	pOut[0] = vValue.x;
+	pOut[1] = vValue.y;
+	pOut[2] = vValue.z;
+}
+
+uint32_t CatLevelFile::Writer::intern( const std::string& sString )
+{
+	if ( sString.empty() ) return NO_STRING;
+
+	auto [it, bInserted] = m_mStrings.try_emplace( sString, static_cast< uint32_t >( m_sStrings.size() ) );
+	if ( bInserted )
+	{
+		m_sStrings.append( sString );
+		m_sStrings.push_back( '\0' );
+	}
+	return it->second;
+}
+
+void CatLevelFile::Writer::beginChunk( const id_t id, const glm::ivec2& vPosition )
+{
+	if ( m_aChunks.empty() )
+	{
+		m_nGlobalCount = static_cast< uint32_t >( m_aObjects.size() );
+	}
+
+	Chunk chunk{};
+	chunk.nId = id;
+	chunk.aPosition[0] = vPosition.x;
+	chunk.aPosition[1] = vPosition.y;
+	chunk.nFirstObject = static_cast< uint32_t >( m_aObjects.size() );
+	m_aChunks.push_back( chunk );
+}
+
+void CatLevelFile::Writer::addObject( const ObjectType eType,
+	const std::string& sName,
+	const std::string& sFile,
+	const glm::vec3& vColor,
+	const glm::vec3& vTranslation,
+	const glm::vec3& vRotation,
+	const glm::vec3& vScale,
+	const float fOpacity )
+{
+	Object object{};
+	object.nType = static_cast< uint32_t >( eType );
+	object.nName = intern( sName );
+	object.nFile = intern( sFile );
+	object.fTransparency = 1.f - fOpacity;
+	WriteVec3( vColor, object.aColor );
+	WriteVec3( vTranslation, object.aTranslation );
+	WriteVec3( vRotation, object.aRotation );
+	WriteVec3( vScale, object.aScale );
+	m_aObjects.push_back( object );
+
+	if ( !m_aChunks.empty() )
+	{
+		++m_aChunks.back().nObjectCount;
+	}
+}
+
+void CatLevelFile::Writer::addObject( const json& object )
+{
+	Object record{};
+	record.nType = object["type"].get< uint32_t >();
+	record.nName = intern( object["name"].get< std::string >() );
+	record.nFile = intern( object.value( "file", std::string() ) );
+	record.fTransparency = 1.f - object.value( "opacity", 1.f );
+	ReadVec3( object["color"], record.aColor );
+	ReadVec3( object["transform"]["t"], record.aTranslation );
+	ReadVec3( object["transform"]["r"], record.aRotation );
+	ReadVec3( object["transform"]["s"], record.aScale );
+	m_aObjects.push_back( record );
+
+	if ( !m_aChunks.empty() )
+	{
+		++m_aChunks.back().nObjectCount;
+	}
+}
+
+void CatLevelFile::Writer::addObject( const CatLevelFile& file, const Object& object )
+{
+	Object record = object;
+	record.nName = intern( std::string( file.getString( object.nName ) ) );
+	record.nFile = intern( std::string( file.getString( object.nFile ) ) );
+	m_aObjects.push_back( record );
+
+	if ( !m_aChunks.empty() )
+	{
+		++m_aChunks.back().nObjectCount;
+	}
+}
+
+bool CatLevelFile::Writer::write( const std::string& sPath )
+{
+	if ( m_aChunks.empty() )
+	{
+		m_nGlobalCount = static_cast< uint32_t >( m_aObjects.size() );
+	}
+
+	Header header{};
+	header.nMagic = MAGIC;
+	header.nVersion = VERSION;
+	header.aSize[0] = m_vSize.x;
+	header.aSize[1] = m_vSize.y;
+	header.aChunkSize[0] = m_vChunkSize.x;
+	header.aChunkSize[1] = m_vChunkSize.y;
+	header.nObjectCount = static_cast< uint32_t >( m_aObjects.size() );
+	header.nGlobalCount = m_nGlobalCount;
+	header.nChunkCount = static_cast< uint32_t >( m_aChunks.size() );
+	header.nStringTableSize = static_cast< uint32_t >( m_sStrings.size() );
+	header.nObjectsOffset = AlignOffset( sizeof( Header ) );
+	header.nChunksOffset = AlignOffset( header.nObjectsOffset + m_aObjects.size() * sizeof( Object ) );
+	header.nStringsOffset = AlignOffset( header.nChunksOffset + m_aChunks.size() * sizeof( Chunk ) );
+
+	std::ofstream ofs( sPath, std::ios::binary | std::ios::trunc );
+	if ( !ofs )
+	{
+		LOG_F( ERROR, "Failed to open level file for writing: %s", sPath.c_str() );
+		return false;
+	}
+
+	static constexpr char PADDING[8] = {};
+	auto pad = [&ofs]( const uint64_t nOffset )
+	{ ofs.write( PADDING, static_cast< std::streamsize >( nOffset - static_cast< uint64_t >( ofs.tellp() ) ) ); };
+
+	ofs.write( reinterpret_cast< const char* >( &header ), sizeof( Header ) );
+	pad( header.nObjectsOffset );
+	ofs.write( reinterpret_cast< const char* >( m_aObjects.data() ),
+		static_cast< std::streamsize >( m_aObjects.size() * sizeof( Object ) ) );
+	pad( header.nChunksOffset );
+	ofs.write(
+		reinterpret_cast< const char* >( m_aChunks.data() ), static_cast< std::streamsize >( m_aChunks.size() * sizeof( Chunk ) ) );
+	pad( header.nStringsOffset );
+	ofs.write( m_sStrings.data(), static_cast< std::streamsize >( m_sStrings.size() ) );
+	ofs.close();
+
+	if ( !ofs )
+	{
+		LOG_F( ERROR, "Failed to write level file: %s", sPath.c_str() );
+		return false;
+	}
+
+	LOG_F( INFO, "Wrote binary level: %s (%u objects, %u chunks)", sPath.c_str(), header.nObjectCount, header.nChunkCount );
+	return true;
+}
+
+std::unique_ptr< CatLevelFile > CatLevelFile::open( const std::string& sPath )
+{
+	auto file = std::unique_ptr< CatLevelFile >( new CatLevelFile() );
+	file->m_sPath = sPath;
+	if ( !file->m_file.open( sPath ) )
+	{
+		LOG_F( ERROR, "Failed to map level file: %s", sPath.c_str() );
+		return nullptr;
+	}
+
+	const auto pData = file->m_file.data();
+	const auto nSize = static_cast< uint64_t >( file->m_file.size() );
+
+	auto fail = [&sPath]( const char* sReason ) -> std::unique_ptr< CatLevelFile >
+	{
+		LOG_F( ERROR, "Invalid level file %s: %s", sPath.c_str(), sReason );
+		return nullptr;
+	};
+
+	if ( nSize < sizeof( Header ) ) return fail( "truncated header" );
+
+	const auto pHeader = reinterpret_cast< const Header* >( pData );
+	if ( pHeader->nMagic != MAGIC ) return fail( "bad magic" );
+	if ( pHeader->nVersion != VERSION ) return fail( "unsupported version" );
+	if ( pHeader->aSize[0] <= 0 || pHeader->aSize[1] <= 0 || pHeader->aChunkSize[0] <= 0 || pHeader->aChunkSize[1] <= 0 )
+	{
+		return fail( "bad level dimensions" );
+	}
+	if ( pHeader->nGlobalCount > pHeader->nObjectCount ) return fail( "bad global count" );
+
+	const auto fits = [nSize]( const uint64_t nOffset, const uint64_t nBytes )
+	{ return nOffset % 8 == 0 && nOffset <= nSize && nBytes <= nSize - nOffset; };
+	if ( !fits( pHeader->nObjectsOffset, uint64_t( pHeader->nObjectCount ) * sizeof( Object ) ) )
+	{
+		return fail( "object table out of bounds" );
+	}
+	if ( !fits( pHeader->nChunksOffset, uint64_t( pHeader->nChunkCount ) * sizeof( Chunk ) ) )
+	{
+		return fail( "chunk table out of bounds" );
+	}
+	if ( !fits( pHeader->nStringsOffset, pHeader->nStringTableSize ) ) return fail( "string table out of bounds" );
+
+	file->m_pHeader = pHeader;
+	file->m_aObjects = { reinterpret_cast< const Object* >( pData + pHeader->nObjectsOffset ), pHeader->nObjectCount };
+	file->m_aChunks = { reinterpret_cast< const Chunk* >( pData + pHeader->nChunksOffset ), pHeader->nChunkCount };
+	file->m_pStrings = reinterpret_cast< const char* >( pData + pHeader->nStringsOffset );
+
+	if ( pHeader->nStringTableSize > 0 && file->m_pStrings[pHeader->nStringTableSize - 1] != '\0' )
+	{
+		return fail( "unterminated string table" );
+	}
+
+	const auto nMaxChunkId = uint64_t( pHeader->aSize[0] ) * uint64_t( pHeader->aSize[1] );
+	for ( const auto& chunk : file->m_aChunks )
+	{
+		if ( chunk.nId == 0 || chunk.nId > nMaxChunkId ) return fail( "chunk id out of range" );
+		if ( chunk.nFirstObject < pHeader->nGlobalCount || chunk.nFirstObject > pHeader->nObjectCount
+			 || chunk.nObjectCount > pHeader->nObjectCount - chunk.nFirstObject )
+		{
+			return fail( "chunk object range out of bounds" );
+		}
+	}
+
+	const auto validString = [&pHeader]( const uint32_t nOffset )
+	{ return nOffset == NO_STRING || nOffset < pHeader->nStringTableSize; };
+	for ( const auto& object : file->m_aObjects )
+	{
+		if ( !validString( object.nName ) || !validString( object.nFile ) ) return fail( "string offset out of bounds" );
+	}
+
+	return file;
+}
+
+json CatLevelFile::toJson( const Object& object ) const
+{
+	json jObject;
+	jObject["name"] = getString( object.nName );
+	if ( object.nFile != NO_STRING )
+	{
+		jObject["file"] = getString( object.nFile );
+	}
+	jObject["type"] = object.nType;
+
+	jObject["transform"]["t"] = object.aTranslation;
+	jObject["transform"]["r"] = object.aRotation;
+	jObject["transform"]["s"] = object.aScale;
+
+	jObject["color"] = object.aColor;
+	if ( object.fTransparency > 0.f )
+	{
+		jObject["opacity"] = 1.f - object.fTransparency;
+	}
+
+	return jObject;
+}
+
+bool CatLevelFile::convert( const std::string& sJsonPath, const std::string& sBinaryPath )
+{
+	LOG_SCOPE_FUNCTION( INFO );
+
+	std::ifstream ifs( sJsonPath );
+	if ( !ifs )
+	{
+		LOG_F( ERROR, "Failed to open level: %s", sJsonPath.c_str() );
+		return false;
+	}
+
+	json jLevelData;
+	ifs >> jLevelData;
+	ifs.close();
+
+	const auto& jSize = jLevelData["size"];
+	const auto& jChunkSize = jLevelData["chunkSize"];
+	Writer writer( glm::ivec2( jSize[0].get< int >(), jSize[1].get< int >() ),
+		glm::ivec2( jChunkSize[0].get< int >(), jChunkSize[1].get< int >() ) );
+
+	for ( const auto& object : jLevelData["globals"] )
+	{
+		if ( object.is_null() ) continue;
+		writer.addObject( object );
+	}
+
+	for ( const auto& chunkData : jLevelData["chunks"] )
+	{
+		if ( chunkData.is_null() ) continue;
+
+		const auto& jPosition = chunkData["position"];
+		writer.beginChunk(
+			chunkData["id"].get< id_t >(), glm::ivec2( jPosition[0].get< int >(), jPosition[1].get< int >() ) );
+
+		for ( const auto& object : chunkData["objects"] )
+		{
+			if ( object.is_null() ) continue;
+			writer.addObject( object );
+		}
+	}
+
+	return writer.write( sBinaryPath );
+}
+
+} // namespace cat
@@ -0,0 +1,145 @@
+#ifndef CATENGINE_CATLEVELFILE_HPP
+#define CATENGINE_CATLEVELFILE_HPP
+
+#include "Globals.hpp"
+#include "Cat/Objects/CatObjectType.hpp"
+#include "Cat/Utils/CatMappedFile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cat
+{
+
+// Binary level format, the file is memory mapped and the records are used in place without any parsing.
+// Layout: [Header][Object records][Chunk table][String table]
+// The first nGlobalCount object records are the globals, every chunk references a contiguous range of the records after them.
+// Names and asset paths are interned into the string table as NUL terminated strings.
+class CatLevelFile
+{
+public:
+	static constexpr uint32_t MAGIC = 0x4C544143; // "CATL"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t NO_STRING = 0xFFFFFFFF;
+	static constexpr char EXTENSION[] = ".catl";
+
+	struct Header
+	{
+		uint32_t nMagic;
+		uint32_t nVersion;
+		int32_t aSize[2];
+		int32_t aChunkSize[2];
+		uint32_t nObjectCount;
+		uint32_t nGlobalCount;
+		uint32_t nChunkCount;
+		uint32_t nStringTableSize;
+		uint64_t nObjectsOffset;
+		uint64_t nChunksOffset;
+		uint64_t nStringsOffset;
+	};
+
+	struct Chunk
+	{
+		uint64_t nId;
+		int32_t aPosition[2];
+		uint32_t nFirstObject;
+		uint32_t nObjectCount;
+	};
+
+	struct Object
+	{
+		uint32_t nType;
+		uint32_t nName;
+		uint32_t nFile;
+		// 1 - opacity, so the zeroed field of older files reads as opaque.
+		float fTransparency;
+		float aColor[3];
+		float aTranslation[3];
+		float aRotation[3];
+		float aScale[3];
+	};
+
+	static_assert( sizeof( Header ) == 64 );
+	static_assert( sizeof( Chunk ) == 24 );
+	static_assert( sizeof( Object ) == 64 );
+
+	// Collects the objects of a level and writes them in the binary format.
+	// Objects added before the first beginChunk() are the globals.
+	class Writer
+	{
+	private:
+		glm::ivec2 m_vSize;
+		glm::ivec2 m_vChunkSize;
+		std::vector< Object > m_aObjects;
+		std::vector< Chunk > m_aChunks;
+		std::string m_sStrings;
+		std::unordered_map< std::string, uint32_t > m_mStrings;
+		uint32_t m_nGlobalCount = 0;
+
+		uint32_t intern( const std::string& sString );
+
+	public:
+		Writer( const glm::ivec2 vSize, const glm::ivec2 vChunkSize ) : m_vSize( vSize ), m_vChunkSize( vChunkSize ) {}
+
+		void beginChunk( id_t id, const glm::ivec2& vPosition );
+		void addObject( ObjectType eType,
+			const std::string& sName,
+			const std::string& sFile,
+			const glm::vec3& vColor,
+			const glm::vec3& vTranslation,
+			const glm::vec3& vRotation,
+			const glm::vec3& vScale,
+			float fOpacity = 1.f );
+		// Adds an object saved in the json level format.
+		void addObject( const json& object );
+		// Copies an object record of another level file.
+		void addObject( const CatLevelFile& file, const Object& object );
+
+		bool write( const std::string& sPath );
+	};
+
+	// Maps the file and validates its header and tables, returns nullptr if the file is missing or malformed.
+	[[nodiscard]] static std::unique_ptr< CatLevelFile > open( const std::string& sPath );
+	// Converts a json level to the binary format.
+	static bool convert( const std::string& sJsonPath, const std::string& sBinaryPath );
+
+	// Converts an object record to the json level format.
+	[[nodiscard]] json toJson( const Object& object ) const;
+
+	[[nodiscard]] const std::string& getPath() const { return m_sPath; }
+	[[nodiscard]] const Header& getHeader() const { return *m_pHeader; }
+	[[nodiscard]] glm::ivec2 getSize() const { return { m_pHeader->aSize[0], m_pHeader->aSize[1] }; }
+	[[nodiscard]] glm::ivec2 getChunkSize() const { return { m_pHeader->aChunkSize[0], m_pHeader->aChunkSize[1] }; }
+	[[nodiscard]] std::span< const Object > getGlobals() const { return m_aObjects.first( m_pHeader->nGlobalCount ); }
+	[[nodiscard]] std::span< const Chunk > getChunks() const { return m_aChunks; }
+	[[nodiscard]] std::span< const Object > getObjects( const Chunk& chunk ) const
+	{
+		return m_aObjects.subspan( chunk.nFirstObject, chunk.nObjectCount );
+	}
+	[[nodiscard]] std::string_view getString( const uint32_t nOffset ) const
+	{
+		if ( nOffset == NO_STRING ) return {};
+		return { m_pStrings + nOffset };
+	}
+
+private:
+	CatLevelFile() = default;
+
+	std::string m_sPath;
+	CatMappedFile m_file;
+	const Header* m_pHeader = nullptr;
+	std::span< const Object > m_aObjects;
+	std::span< const Chunk > m_aChunks;
+	const char* m_pStrings = nullptr;
+};
+
+} // namespace cat
+
+#endif // CATENGINE_CATLEVELFILE_HPP
@@ -1,79 +1,349 @@
 #include "CatAssetLoader.hpp"
 #include "CatLight.hpp"
 #include "Cat/CatApp.hpp"
+#include "Cat/Level/CatLevel.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <ranges>
+#include <thread>
 
 namespace cat
 {
-std::shared_future< std::shared_ptr< CatModel > > CatAssetLoader::load( const json& object, CatObject::Map& mObjects )
+bool CatAssetLoader::isLessUrgent( const std::shared_ptr< Request >& a, const std::shared_ptr< Request >& b )
+{
+	if ( a->ePriority != b->ePriority ) return a->ePriority > b->ePriority;
+	return a->fDistance2 > b->fDistance2;
+}
+
+CatAssetLoader::~CatAssetLoader()
 {
-	auto type = cat::ObjectType( object["type"] );
-	if ( type >= cat::ObjectType::eCamera )
+	// Queued requests are dropped, the running ones finish before the loader goes away.
 	{
-		return {};
+		const std::lock_guard lock( m_mutexModelCache );
+		for ( const auto& pRequest : m_aRequestQueue )
+		{
+			m_mRequests.erase( pRequest->sFile );
+			m_mModelCache.erase( pRequest->sFile );
+			pRequest->promise.set_value( nullptr );
+		}
+		m_aRequestQueue.clear();
 	}
-	if ( type >= cat::ObjectType::eLight )
+	GetEditorInstance()->m_TAssetLoader.wait_for_tasks();
+}
+
+std::shared_ptr< CatModel > CatAssetLoader::loadModel( const std::string& sFile )
+{
+	// Every asset loader thread parses its own model, they share the hardware threads.
+	const auto nLoaderThreads = std::max( 1u, GetEditorInstance()->m_TAssetLoader.get_thread_count() );
+	const auto nMaxThreads = std::max( 1u, std::thread::hardware_concurrency() / nLoaderThreads );
+	auto model = CatModel::createModelFromFile( GetEditorInstance()->m_PDevice, sFile, nMaxThreads );
+	// Objects are drawn as soon as they get the model.
+	model->waitUntilUploaded();
+	m_nResidentMemory += model->getMemorySize();
+	return model;
+}
+
+void CatAssetLoader::updatePriority( Request& request ) const
+{
+	if ( request.bPinned )
 	{
-		auto light = CatLight::create( object["name"] );
+		request.ePriority = RequestPriority::eRequired;
+		request.fDistance2 = 0.0f;
+		return;
+	}
 
-		light->load( object );
+	request.ePriority = RequestPriority::ePrefetch;
+	request.fDistance2 = std::numeric_limits< float >::max();
+	for ( const auto& waiter : request.aWaiters )
+	{
+		const auto vOffset = waiter.pObject->m_transform.translation - m_vFocus;
+		const auto fDistance2 = glm::dot( vOffset, vOffset );
+		if ( waiter.ePriority < request.ePriority || ( waiter.ePriority == request.ePriority && fDistance2 < request.fDistance2 ) )
+		{
+			request.ePriority = waiter.ePriority;
+			request.fDistance2 = fDistance2;
+		}
+	}
+}
 
-		mObjects[light->getId()] = std::move( light );
+std::shared_future< std::shared_ptr< CatModel > > CatAssetLoader::enqueue( std::shared_ptr< Request > pRequest )
+{
+	auto fModel = pRequest->promise.get_future().share();
+	pRequest->fModel = fModel;
+	m_mModelCache[pRequest->sFile] = fModel;
+	m_mRequests[pRequest->sFile] = pRequest;
 
-		return {};
+	m_aRequestQueue.push_back( std::move( pRequest ) );
+	if ( !m_bQueueDirty )
+	{
+		updatePriority( *m_aRequestQueue.back() );
+		std::push_heap( m_aRequestQueue.begin(), m_aRequestQueue.end(), isLessUrgent );
 	}
-	if ( type >= cat::ObjectType::eGameObject )
+
+	// Every task takes whichever request is the most urgent when it runs, so the pool's FIFO order does not matter.
+	GetEditorInstance()->m_TAssetLoader.push_task( [this]() { processNextRequest(); } );
+
+	return fModel;
+}
+
+void CatAssetLoader::processNextRequest()
+{
+	std::shared_ptr< Request > pRequest;
 	{
-		// Load object if it's not already loaded.
-		if ( !m_mModelCache.contains( object["file"] ) )
+		const std::lock_guard lock( m_mutexModelCache );
+		// Cancelled requests leave their tasks behind.
+		if ( m_aRequestQueue.empty() ) return;
+
+		if ( m_bQueueDirty )
 		{
-			auto task = [&object, &mObjects]()
+			for ( const auto& pQueued : m_aRequestQueue )
 			{
-				auto model = CatModel::createModelFromFile( GetEditorInstance()->m_PDevice, object["file"] );
-
-				auto obj = CatObject::create( object["name"], object["file"] );
-
-				obj->load( object );
-				obj->m_pModel = model;
+				updatePriority( *pQueued );
+			}
+			std::make_heap( m_aRequestQueue.begin(), m_aRequestQueue.end(), isLessUrgent );
+			m_bQueueDirty = false;
+		}
 
-				mObjects[obj->getId()] = std::move( obj );
+		std::pop_heap( m_aRequestQueue.begin(), m_aRequestQueue.end(), isLessUrgent );
+		pRequest = std::move( m_aRequestQueue.back() );
+		m_aRequestQueue.pop_back();
+		pRequest->bRunning = true;
+	}
 
-				return model;
-			};
-			auto sharedFuture = GetEditorInstance()->m_TAssetLoader.submit( std::move( task ) ).share();
+	try
+	{
+		pRequest->pModel = loadModel( pRequest->sFile );
+	}
+	catch ( const std::exception& e )
+	{
+		LOG_F( ERROR, "Failed to load model %s: %s", pRequest->sFile.c_str(), e.what() );
+	}
 
-			m_mModelCache[object["file"]] = sharedFuture;
-			return sharedFuture;
+	// Handed over under the lock, so a level that cancelled its requests never receives objects afterwards.
+	const std::lock_guard lock( m_mutexModelCache );
+	m_mRequests.erase( pRequest->sFile );
+	if ( pRequest->pModel )
+	{
+		for ( auto& [pObject, pLevel, idChunk, nGeneration, ePriority] : pRequest->aWaiters )
+		{
+			pObject->m_pModel = pRequest->pModel;
+			pLevel->addObject( std::move( pObject ), idChunk, nGeneration );
 		}
-		else
+		if ( pRequest->bPinned )
 		{
-			auto obj = CatObject::create( object["name"], object["file"] );
+			m_mPinnedModels[pRequest->sFile] = pRequest->pModel;
+		}
+	}
+	else
+	{
+		m_mModelCache.erase( pRequest->sFile );
+	}
+	// The future takes over the request's reference, releaseUnused never sees a model this thread still holds.
+	pRequest->promise.set_value( std::move( pRequest->pModel ) );
+}
 
-			obj->load( object );
-			obj->m_pModel = m_mModelCache[object["file"]].get();
+template < typename TSource >
+std::shared_future< std::shared_ptr< CatModel > > CatAssetLoader::load( const ObjectType eType,
+	const std::string& sName,
+	const std::string& sFile,
+	const TSource& source,
+	CatLevel* pLevel,
+	const id_t idChunk,
+	const uint32_t nGeneration,
+	const RequestPriority ePriority )
+{
+	if ( eType >= cat::ObjectType::eCamera )
+	{
+		return {};
+	}
+	if ( eType >= cat::ObjectType::eLight )
+	{
+		auto light = CatLight::create( sName );
+
+		light->load( source );
+
+		pLevel->addObject( std::move( light ), idChunk, nGeneration );
+
+		return {};
+	}
+	if ( eType >= cat::ObjectType::eGameObject )
+	{
+		// The description is only needed here, the model is loaded later in priority order.
+		std::shared_ptr< CatObject > obj = CatObject::create( sName, sFile );
+		obj->load( source );
 
-			mObjects[obj->getId()] = std::move( obj );
+		const std::lock_guard lock( m_mutexModelCache );
 
+		// Already queued or loading, the object waits on the same request instead of blocking this thread.
+		if ( auto it = m_mRequests.find( sFile ); it != m_mRequests.end() )
+		{
+			auto& request = *it->second;
+			request.aWaiters.push_back( { std::move( obj ), pLevel, idChunk, nGeneration, ePriority } );
+			m_bQueueDirty |= !request.bRunning;
+			return request.fModel;
+		}
+
+		// Not in the requests anymore, so the cached model is ready. Handed over under the lock like a loaded one, so
+		// releaseUnused can't drop it before the object holds it.
+		if ( auto it = m_mModelCache.find( sFile ); it != m_mModelCache.end() )
+		{
+			obj->m_pModel = it->second.get();
+			pLevel->addObject( std::move( obj ), idChunk, nGeneration );
 			return {};
 		}
+
+		auto pRequest = std::make_shared< Request >();
+		pRequest->sFile = sFile;
+		pRequest->aWaiters.push_back( { std::move( obj ), pLevel, idChunk, nGeneration, ePriority } );
+		return enqueue( std::move( pRequest ) );
 	}
 
 	return {};
 }
 
+std::shared_future< std::shared_ptr< CatModel > > CatAssetLoader::load( const json& object,
+	CatLevel* pLevel,
+	const id_t idChunk /* = 0 */,
+	const uint32_t nGeneration /* = 0 */,
+	const RequestPriority ePriority /* = RequestPriority::eRequired */ )
+{
+	return load( ObjectType( object["type"] ), object["name"].get< std::string >(), object.value( "file", std::string() ), object,
+		pLevel, idChunk, nGeneration, ePriority );
+}
+
+std::shared_future< std::shared_ptr< CatModel > > CatAssetLoader::load( const CatLevelFile::Object& object,
+	const CatLevelFile& levelFile,
+	CatLevel* pLevel,
+	const id_t idChunk /* = 0 */,
+	const uint32_t nGeneration /* = 0 */,
+	const RequestPriority ePriority /* = RequestPriority::eRequired */ )
+{
+	return load( static_cast< ObjectType >( object.nType ), std::string( levelFile.getString( object.nName ) ),
+		std::string( levelFile.getString( object.nFile ) ), object, pLevel, idChunk, nGeneration, ePriority );
+}
+
 std::shared_future< std::shared_ptr< CatModel > > CatAssetLoader::get( const std::string& file )
 {
-	if ( !m_mModelCache.contains( file ) )
+	const std::lock_guard lock( m_mutexModelCache );
+
+	if ( auto it = m_mRequests.find( file ); it != m_mRequests.end() )
+	{
+		it->second->bPinned = true;
+		m_bQueueDirty |= !it->second->bRunning;
+		return it->second->fModel;
+	}
+	if ( auto it = m_mModelCache.find( file ); it != m_mModelCache.end() )
 	{
-		auto task = [file]() { return CatModel::createModelFromFile( GetEditorInstance()->m_PDevice, file ); };
-		auto sharedFuture = GetEditorInstance()->m_TAssetLoader.submit( std::move( task ) ).share();
+		m_mPinnedModels.try_emplace( file, it->second.get() );
+		return it->second;
+	}
+
+	auto pRequest = std::make_shared< Request >();
+	pRequest->sFile = file;
+	pRequest->bPinned = true;
+	return enqueue( std::move( pRequest ) );
+}
 
-		m_mModelCache[file] = sharedFuture;
-		return sharedFuture;
+template < typename TPredicate >
+void CatAssetLoader::cancelWaiters( TPredicate&& fnCancel )
+{
+	const std::lock_guard lock( m_mutexModelCache );
+
+	uint32_t nCancelledObjects = 0;
+	for ( const auto& pRequest : m_mRequests | std::views::values )
+	{
+		nCancelledObjects += static_cast< uint32_t >( std::erase_if( pRequest->aWaiters, fnCancel ) );
 	}
-	else
+	if ( nCancelledObjects == 0 ) return;
+
+	// Running requests finish and stay in the cache, the budget releases them if nothing uses them.
+	const auto nCancelledRequests = std::erase_if( m_aRequestQueue,
+		[this]( const std::shared_ptr< Request >& pRequest )
+		{
+			if ( pRequest->bPinned || !pRequest->aWaiters.empty() ) return false;
+
+			m_mRequests.erase( pRequest->sFile );
+			m_mModelCache.erase( pRequest->sFile );
+			pRequest->promise.set_value( nullptr );
+			return true;
+		} );
+
+	// Erasing breaks the heap, and the remaining requests may have lost their nearest waiters.
+	m_bQueueDirty = true;
+	m_nCancelledObjects += nCancelledObjects;
+	m_nCancelledRequests += static_cast< uint32_t >( nCancelledRequests );
+}
+
+void CatAssetLoader::cancel( const CatLevel* pLevel )
+{
+	cancelWaiters( [pLevel]( const Waiter& waiter ) { return waiter.pLevel == pLevel; } );
+}
+
+void CatAssetLoader::cancel( const CatLevel* pLevel, const id_t idChunk )
+{
+	cancelWaiters( [pLevel, idChunk]( const Waiter& waiter ) { return waiter.pLevel == pLevel && waiter.idChunk == idChunk; } );
+}
+
+void CatAssetLoader::setChunkPriority( const CatLevel* pLevel, const id_t idChunk, const RequestPriority ePriority )
+{
+	const std::lock_guard lock( m_mutexModelCache );
+	for ( const auto& pRequest : m_aRequestQueue )
 	{
-		return m_mModelCache[file];
+		for ( auto& waiter : pRequest->aWaiters )
+		{
+			if ( waiter.pLevel == pLevel && waiter.idChunk == idChunk && waiter.ePriority != ePriority )
+			{
+				waiter.ePriority = ePriority;
+				m_bQueueDirty = true;
+			}
+		}
 	}
 }
 
+void CatAssetLoader::setFocus( const glm::vec3& vFocus )
+{
+	const auto vOffset = vFocus - m_vFocus;
+	if ( glm::dot( vOffset, vOffset ) < REPRIORITIZE_DISTANCE * REPRIORITIZE_DISTANCE ) return;
+
+	const std::lock_guard lock( m_mutexModelCache );
+	m_vFocus = vFocus;
+	m_bQueueDirty = !m_aRequestQueue.empty();
+}
+
+size_t CatAssetLoader::getQueuedRequestCount()
+{
+	const std::lock_guard lock( m_mutexModelCache );
+	return m_aRequestQueue.size();
+}
+
+vk::DeviceSize CatAssetLoader::releaseUnused()
+{
+	using namespace std::chrono_literals;
+
+	vk::DeviceSize nReleased = 0;
+	{
+		const std::lock_guard lock( m_mutexModelCache );
+		std::erase_if( m_mModelCache,
+			[&nReleased]( const auto& pair )
+			{
+				const auto& fModel = pair.second;
+				if ( fModel.wait_for( 0ms ) != std::future_status::ready ) return false;
+
+				// The shared state of the future holds the only reference, no object uses the model anymore. References
+				// are only taken from the cache and given up by the loader threads under the lock, so none can appear
+				// after this check.
+				const auto& model = fModel.get();
+				if ( model.use_count() > 1 ) return false;
+
+				nReleased += model->getMemorySize();
+				GetEditorInstance()->m_PDevice->deferRelease( model );
+				return true;
+			} );
+	}
+	m_nResidentMemory -= nReleased;
+
+	return nReleased;
+}
+
 } // namespace cat
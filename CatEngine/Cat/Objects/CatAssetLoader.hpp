@@ -8,23 +8,138 @@
 #include <string>
 #include <memory>
 #include <future>
+#include <mutex>
+#include <atomic>
+#include <vector>
 
 namespace cat
 {
+class CatLevel;
 
+// Models are loaded through a request queue instead of straight into the thread pool, the asset loader threads always pick
+// the most urgent request when they become free.
 class CatAssetLoader
 {
+public:
+	// Globals and chunks inside the load radius come before prefetched chunks, nearest to the camera first within a class.
+	enum class RequestPriority : uint8_t
+	{
+		eRequired = 0,
+		ePrefetch = 1,
+	};
+
+	// Moving the camera less than this does not reorder the queue.
+	static constexpr float REPRIORITIZE_DISTANCE = 1.0f;
+
 private:
+	// Object waiting for a model, handed to its level when the model is loaded.
+	struct Waiter
+	{
+		std::shared_ptr< CatObject > pObject;
+		CatLevel* pLevel;
+		id_t idChunk;
+		uint32_t nGeneration;
+		RequestPriority ePriority;
+	};
+
+	// One per model file, every object using the model while it loads waits on the same request.
+	struct Request
+	{
+		std::string sFile;
+		std::promise< std::shared_ptr< CatModel > > promise;
+		std::shared_future< std::shared_ptr< CatModel > > fModel;
+		std::vector< Waiter > aWaiters;
+		// Set by the loader thread, only moved on to the objects and the future under m_mutexModelCache.
+		std::shared_ptr< CatModel > pModel;
+		// Requested through get() without a level, never cancelled.
+		bool bPinned = false;
+		bool bRunning = false;
+		RequestPriority ePriority = RequestPriority::eRequired;
+		float fDistance2 = 0.0f;
+	};
+
+	// Accessed by the level and chunk streaming threads, everything below is guarded by m_mutexModelCache.
 	std::unordered_map< std::string, std::shared_future< std::shared_ptr< CatModel > > > m_mModelCache;
+	std::mutex m_mutexModelCache;
+
+	// Queued and running requests by file, the queued ones are also in the heap.
+	std::unordered_map< std::string, std::shared_ptr< Request > > m_mRequests;
+	std::vector< std::shared_ptr< Request > > m_aRequestQueue;
+	// References of the models requested through get(), their callers only take one once the future is ready.
+	std::unordered_map< std::string, std::shared_ptr< CatModel > > m_mPinnedModels;
+	// Set when priorities changed, the heap is rebuilt by the next thread taking a request.
+	bool m_bQueueDirty = false;
+	glm::vec3 m_vFocus{ 0.0f };
+	std::atomic< uint32_t > m_nCancelledRequests = 0;
+	std::atomic< uint32_t > m_nCancelledObjects = 0;
+
+	std::atomic< vk::DeviceSize > m_nResidentMemory = 0;
+	vk::DeviceSize m_nMemoryBudget = vk::DeviceSize( 512 ) << 20;
+
+	std::shared_ptr< CatModel > loadModel( const std::string& sFile );
+
+	// Shared by the json and binary level paths, the object is created from TSource before returning.
+	template < typename TSource >
+	std::shared_future< std::shared_ptr< CatModel > > load( ObjectType eType,
+		const std::string& sName,
+		const std::string& sFile,
+		const TSource& source,
+		CatLevel* pLevel,
+		id_t idChunk,
+		uint32_t nGeneration,
+		RequestPriority ePriority );
+
+	// Expects m_mutexModelCache to be locked.
+	std::shared_future< std::shared_ptr< CatModel > > enqueue( std::shared_ptr< Request > pRequest );
+	void updatePriority( Request& request ) const;
+	// Heap order, the most urgent request ends up at the front.
+	static bool isLessUrgent( const std::shared_ptr< Request >& a, const std::shared_ptr< Request >& b );
+	// Runs on the asset loader threads, loads the most urgent queued request.
+	void processNextRequest();
+
+	template < typename TPredicate >
+	void cancelWaiters( TPredicate&& fnCancel );
 
 public:
 	CatAssetLoader() = default;
-	virtual ~CatAssetLoader() = default;
+	virtual ~CatAssetLoader();
 
-	std::shared_future< std::shared_ptr< CatModel > > load( const json& object, CatObject::Map& mObjects );
+	// Creates the object described by the json, and hands it to the level once its model is ready.
+	// The generation is passed back to the level, so objects of a chunk that was evicted in the meantime can be dropped.
+	// The returned future is valid while the model is loading and becomes ready after the object was handed to the level.
+	std::shared_future< std::shared_ptr< CatModel > > load( const json& object,
+		CatLevel* pLevel,
+		id_t idChunk = 0,
+		uint32_t nGeneration = 0,
+		RequestPriority ePriority = RequestPriority::eRequired );
+	std::shared_future< std::shared_ptr< CatModel > > load( const CatLevelFile::Object& object,
+		const CatLevelFile& levelFile,
+		CatLevel* pLevel,
+		id_t idChunk = 0,
+		uint32_t nGeneration = 0,
+		RequestPriority ePriority = RequestPriority::eRequired );
+	// The model is never cancelled or released.
 	std::shared_future< std::shared_ptr< CatModel > > get( const std::string& file );
 
-	CAT_READONLY_PROPERTY( m_mModelCache, getModelCache, m_MModelCache );
+	// Queued requests nobody waits for anymore are dropped and their futures resolve to nullptr.
+	void cancel( const CatLevel* pLevel );
+	void cancel( const CatLevel* pLevel, id_t idChunk );
+	// Used when a prefetched chunk enters the load radius while it is still streaming.
+	void setChunkPriority( const CatLevel* pLevel, id_t idChunk, RequestPriority ePriority );
+	// Queued requests are ordered by the distance of their objects to the focus, usually the camera.
+	void setFocus( const glm::vec3& vFocus );
+
+	// Drops the models only referenced by the cache, their GPU buffers are destroyed once no frame in flight uses them.
+	// Returns the amount of device memory released.
+	vk::DeviceSize releaseUnused();
+
+	[[nodiscard]] vk::DeviceSize getResidentMemory() const { return m_nResidentMemory; }
+	[[nodiscard]] bool isOverBudget() const { return m_nResidentMemory > m_nMemoryBudget; }
+	[[nodiscard]] size_t getQueuedRequestCount();
+	[[nodiscard]] uint32_t getCancelledRequestCount() const { return m_nCancelledRequests; }
+	[[nodiscard]] uint32_t getCancelledObjectCount() const { return m_nCancelledObjects; }
+
+	CAT_PROPERTY( m_nMemoryBudget, getMemoryBudget, setMemoryBudget, m_NMemoryBudget );
 };
 
 } // namespace cat
@@ -9,13 +9,15 @@ namespace cat
 class CatLight : public CatObject
 {
 public:
-	[[nodiscard]] static std::unique_ptr< CatLight > create( const std::string& sName,
+	static constexpr const char* POOL_NAME = "CatLight";
+
+	[[nodiscard]] static std::shared_ptr< CatLight > create( const std::string& sName,
 		const glm::vec3 vColor = glm::vec3( 1.f ),
 		const float fIntensity = 10.f,
 		const float fRadius = .1f,
 		const ObjectType& eType = ObjectType::eLight )
 	{
-		auto light = std::unique_ptr< CatLight >( new CatLight( sName, eType ) );
+		auto light = std::allocate_shared< CatLight >( CatPoolAllocator< CatLight >(), sName, eType );
 		light->m_vColor = vColor;
 		light->m_transform.scale.x = fIntensity;
 		light->m_transform.scale.y = fRadius;
@@ -25,6 +27,9 @@ public:
 	virtual ~CatLight() override = default;
 
 protected:
+	template < typename, typename >
+	friend struct CatPoolAllocator;
+
 	[[nodiscard]] explicit CatLight( const std::string& sName, const ObjectType& eType = ObjectType::eLight )
 		: CatObject( sName, std::string(), eType )
 	{
@@ -0,0 +1,158 @@
+#include "CatMeshCache.hpp"
+
+#include "loguru.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+namespace cat
+{
+static constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325;
+static constexpr uint64_t FNV_PRIME = 0x100000001B3;
+
+static uint64_t HashBytes( const std::byte* pData, const size_t nSize, uint64_t nHash = FNV_OFFSET )
+{
+	for ( size_t i = 0; i < nSize; ++i )
+	{
+		nHash ^= static_cast< uint64_t >( pData[i] );
+		nHash *= FNV_PRIME;
+	}
+	return nHash;
+}
+
+static uint64_t AlignOffset( const uint64_t nOffset )
+{
+	return ( nOffset + 7 ) & ~uint64_t( 7 );
+}
+
+uint64_t CatMeshCache::hashFile( const std::string& sPath )
+{
+	const CatMappedFile file( sPath );
+	if ( !file.isOpen() ) return 0;
+
+	return HashBytes( file.data(), file.size() );
+}
+
+std::string CatMeshCache::getCachePath( const std::string& sSourcePath )
+{
+	// Stable between runs, unlike std::hash.
+	const auto nPathHash = HashBytes( reinterpret_cast< const std::byte* >( sSourcePath.data() ), sSourcePath.size() );
+
+	char sName[17];
+	std::snprintf( sName, sizeof( sName ), "%016llx", static_cast< unsigned long long >( nPathHash ) );
+	return std::string( CACHE_PATH ) + sName + EXTENSION;
+}
+
+std::unique_ptr< CatMeshCache > CatMeshCache::open( const std::string& sSourcePath, const uint64_t nSourceHash )
+{
+	if ( nSourceHash == 0 ) return nullptr;
+
+	const auto sPath = getCachePath( sSourcePath );
+	auto mesh = std::unique_ptr< CatMeshCache >( new CatMeshCache() );
+	if ( !mesh->m_file.open( sPath ) ) return nullptr;
+
+	const auto pData = mesh->m_file.data();
+	const auto nSize = static_cast< uint64_t >( mesh->m_file.size() );
+
+	auto stale = [&sSourcePath]( const char* sReason ) -> std::unique_ptr< CatMeshCache >
+	{
+		DLOG_F( INFO, "Cooked mesh of %s is stale: %s", sSourcePath.c_str(), sReason );
+		return nullptr;
+	};
+
+	if ( nSize < sizeof( Header ) ) return stale( "truncated header" );
+
+	const auto pHeader = reinterpret_cast< const Header* >( pData );
+	if ( pHeader->nMagic != MAGIC || pHeader->nVersion != VERSION ) return stale( "unsupported version" );
+	if ( pHeader->nVertexSize != sizeof( CatModel::Vertex ) ) return stale( "vertex layout changed" );
+	if ( pHeader->nSourceHash != nSourceHash ) return stale( "source changed" );
+
+	const auto fits = [nSize]( const uint64_t nOffset, const uint64_t nBytes )
+	{ return nOffset % 4 == 0 && nOffset <= nSize && nBytes <= nSize - nOffset; };
+	if ( !fits( pHeader->nVerticesOffset, uint64_t( pHeader->nVertexCount ) * sizeof( CatModel::Vertex ) )
+		 || !fits( pHeader->nIndicesOffset, uint64_t( pHeader->nIndexCount ) * sizeof( uint32_t ) )
+		 || !fits( pHeader->nPathOffset, pHeader->nPathSize ) )
+	{
+		return stale( "out of bounds" );
+	}
+
+	// Two sources hashing to the same cache file.
+	const auto sCookedPath = std::string_view( reinterpret_cast< const char* >( pData + pHeader->nPathOffset ), pHeader->nPathSize );
+	if ( sCookedPath != sSourcePath ) return stale( "path collision" );
+
+	mesh->m_aVertices = { reinterpret_cast< const CatModel::Vertex* >( pData + pHeader->nVerticesOffset ), pHeader->nVertexCount };
+	mesh->m_aIndices = { reinterpret_cast< const uint32_t* >( pData + pHeader->nIndicesOffset ), pHeader->nIndexCount };
+
+	return mesh;
+}
+
+bool CatMeshCache::cook( const std::string& sSourcePath, const uint64_t nSourceHash, const CatModel::Builder& builder )
+{
+	if ( nSourceHash == 0 ) return false;
+
+	const auto sPath = getCachePath( sSourcePath );
+
+	Header header{};
+	header.nMagic = MAGIC;
+	header.nVersion = VERSION;
+	header.nVertexSize = sizeof( CatModel::Vertex );
+	header.nPathSize = static_cast< uint32_t >( sSourcePath.size() );
+	header.nSourceHash = nSourceHash;
+	header.nVertexCount = static_cast< uint32_t >( builder.aVertices.size() );
+	header.nIndexCount = static_cast< uint32_t >( builder.aIndices.size() );
+	header.nVerticesOffset = AlignOffset( sizeof( Header ) );
+	header.nIndicesOffset = AlignOffset( header.nVerticesOffset + builder.aVertices.size() * sizeof( CatModel::Vertex ) );
+	header.nPathOffset = AlignOffset( header.nIndicesOffset + builder.aIndices.size() * sizeof( uint32_t ) );
+
+	std::error_code error;
+	std::filesystem::create_directories( CACHE_PATH, error );
+
+	// Written next to the final file and renamed, a crash can't leave a truncated mesh behind.
+	const auto sTempPath = sPath + ".tmp";
+	std::ofstream ofs( sTempPath, std::ios::binary | std::ios::trunc );
+	if ( !ofs )
+	{
+		LOG_F( WARNING, "Failed to open mesh cache for writing: %s", sTempPath.c_str() );
+		return false;
+	}
+
+	static constexpr char PADDING[8] = {};
+	auto pad = [&ofs]( const uint64_t nOffset )
+	{ ofs.write( PADDING, static_cast< std::streamsize >( nOffset - static_cast< uint64_t >( ofs.tellp() ) ) ); };
+
+	ofs.write( reinterpret_cast< const char* >( &header ), sizeof( Header ) );
+	pad( header.nVerticesOffset );
+	ofs.write( reinterpret_cast< const char* >( builder.aVertices.data() ),
+		static_cast< std::streamsize >( builder.aVertices.size() * sizeof( CatModel::Vertex ) ) );
+	pad( header.nIndicesOffset );
+	ofs.write( reinterpret_cast< const char* >( builder.aIndices.data() ),
+		static_cast< std::streamsize >( builder.aIndices.size() * sizeof( uint32_t ) ) );
+	pad( header.nPathOffset );
+	ofs.write( sSourcePath.data(), static_cast< std::streamsize >( sSourcePath.size() ) );
+	ofs.close();
+
+	if ( !ofs )
+	{
+		LOG_F( WARNING, "Failed to write mesh cache: %s", sTempPath.c_str() );
+		std::filesystem::remove( sTempPath, error );
+		return false;
+	}
+
+	// Renaming over an existing file fails on Windows.
+	std::filesystem::remove( sPath, error );
+	std::filesystem::rename( sTempPath, sPath, error );
+	if ( error )
+	{
+		LOG_F( WARNING, "Failed to move mesh cache into place: %s (%s)", sPath.c_str(), error.message().c_str() );
+		std::filesystem::remove( sTempPath, error );
+		return false;
+	}
+
+	DLOG_F( INFO, "Cooked mesh: %s -> %s (%u vertices, %u indices)", sSourcePath.c_str(), sPath.c_str(), header.nVertexCount,
+		header.nIndexCount );
+	return true;
+}
+
+} // namespace cat
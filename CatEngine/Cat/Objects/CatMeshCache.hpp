@@ -0,0 +1,65 @@
+#ifndef CATENGINE_CATMESHCACHE_HPP
+#define CATENGINE_CATMESHCACHE_HPP
+
+#include "Cat/Objects/CatModel.hpp"
+#include "Cat/Utils/CatMappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace cat
+{
+
+// Cooked mesh, the deduplicated vertex and index arrays of a model in the layout they are uploaded in.
+// Layout: [Header][Vertices][Indices][Source path]
+// Cache files are named after the source path and store a hash of the source content, edited models are cooked again.
+class CatMeshCache
+{
+public:
+	static constexpr uint32_t MAGIC = 0x4D544143; // "CATM"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr char EXTENSION[] = ".catm";
+	static constexpr char CACHE_PATH[] = "assets/cache/meshes/";
+
+	struct Header
+	{
+		uint32_t nMagic;
+		uint32_t nVersion;
+		// A changed vertex layout invalidates every cooked mesh.
+		uint32_t nVertexSize;
+		uint32_t nPathSize;
+		uint64_t nSourceHash;
+		uint32_t nVertexCount;
+		uint32_t nIndexCount;
+		uint64_t nVerticesOffset;
+		uint64_t nIndicesOffset;
+		uint64_t nPathOffset;
+		uint64_t nReserved;
+	};
+
+	static_assert( sizeof( Header ) == 64 );
+
+	// Hash of the file's content, 0 if it can't be read.
+	[[nodiscard]] static uint64_t hashFile( const std::string& sPath );
+	[[nodiscard]] static std::string getCachePath( const std::string& sSourcePath );
+
+	// Maps the cooked mesh of the source, returns nullptr if there is none or it is out of date.
+	[[nodiscard]] static std::unique_ptr< CatMeshCache > open( const std::string& sSourcePath, uint64_t nSourceHash );
+	static bool cook( const std::string& sSourcePath, uint64_t nSourceHash, const CatModel::Builder& builder );
+
+	[[nodiscard]] std::span< const CatModel::Vertex > getVertices() const { return m_aVertices; }
+	[[nodiscard]] std::span< const uint32_t > getIndices() const { return m_aIndices; }
+
+private:
+	CatMeshCache() = default;
+
+	CatMappedFile m_file;
+	std::span< const CatModel::Vertex > m_aVertices;
+	std::span< const uint32_t > m_aIndices;
+};
+
+} // namespace cat
+
+#endif // CATENGINE_CATMESHCACHE_HPP
@@ -1,76 +1,85 @@
 #include "CatModel.hpp"
+#include "CatMeshCache.hpp"
 
-#include "Cat/Utils/CatUtils.hpp"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
-#define GLM_ENABLE_EXPERIMENTAL
-#include "glm/gtx/hash.hpp"
-
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
-#include <unordered_map>
+#include <limits>
 
-namespace std
+namespace cat
 {
-template <>
-struct hash< cat::CatModel::Vertex >
+CatModel::CatModel( CatDevice* pDevice, const CatModel::Builder& builder )
+	: CatModel( pDevice, builder.aVertices, builder.aIndices )
 {
-	size_t operator()( cat::CatModel::Vertex const& vertex ) const
-	{
-		size_t seed = 0;
-		cat::HashCombine( seed, vertex.vPosition, vertex.vColor, vertex.vNormal, vertex.vUV );
-		return seed;
-	}
-};
-} // namespace std
-
+}
 
-namespace cat
+CatModel::CatModel( CatDevice* pDevice, std::span< const Vertex > aVertices, std::span< const uint32_t > aIndices )
+	: m_pDevice{ pDevice }
 {
-CatModel::CatModel( CatDevice* pDevice, const CatModel::Builder& builder ) : m_pDevice{ pDevice }
-{
-	createVertexBuffers( builder.aVertices );
-	createIndexBuffers( builder.aIndices );
+	m_geometry = m_pDevice->getGeometryPool().allocate(
+		static_cast< uint32_t >( aVertices.size() ), static_cast< uint32_t >( aIndices.size() ) );
+	createVertexBuffers( aVertices );
+	createIndexBuffers( aIndices );
+	computeBounds( aVertices );
 }
 
 CatModel::~CatModel()
 {
+	m_pDevice->getGeometryPool().free( m_geometry );
 }
 
-std::shared_ptr< CatModel > CatModel::createModelFromFile( CatDevice* pDevice, const std::string& filepath )
+std::shared_ptr< CatModel > CatModel::createModelFromFile( CatDevice* pDevice,
+	const std::string& filepath,
+	const unsigned nMaxThreads /* = 0 */ )
 {
+	// Cooked meshes skip parsing and deduplication, the arrays are copied to the staging ring straight from the mapping.
+	const auto nSourceHash = CatMeshCache::hashFile( filepath );
+	if ( const auto pMesh = CatMeshCache::open( filepath, nSourceHash ) )
+	{
+		return std::make_shared< CatModel >( pDevice, pMesh->getVertices(), pMesh->getIndices() );
+	}
+
 	Builder builder{};
-	builder.loadModel( filepath );
+	builder.loadModel( filepath, nMaxThreads );
+	CatMeshCache::cook( filepath, nSourceHash, builder );
 	return std::make_shared< CatModel >( pDevice, builder );
 }
 
-void CatModel::createVertexBuffers( const std::vector< Vertex >& vertices )
+void CatModel::computeBounds( std::span< const Vertex > vertices )
+{
+	m_bounds.vMin = glm::vec3( std::numeric_limits< float >::max() );
+	m_bounds.vMax = glm::vec3( std::numeric_limits< float >::lowest() );
+	for ( const auto& vertex : vertices )
+	{
+		m_bounds.vMin = glm::min( m_bounds.vMin, vertex.vPosition );
+		m_bounds.vMax = glm::max( m_bounds.vMax, vertex.vPosition );
+	}
+	m_bounds.vCenter = ( m_bounds.vMin + m_bounds.vMax ) * 0.5f;
+
+	// Tighter than half the diagonal of the box for most meshes.
+	float fRadiusSquared = 0.0f;
+	for ( const auto& vertex : vertices )
+	{
+		const auto vOffset = vertex.vPosition - m_bounds.vCenter;
+		fRadiusSquared = std::max( fRadiusSquared, glm::dot( vOffset, vOffset ) );
+	}
+	m_bounds.fRadius = std::sqrt( fRadiusSquared );
+}
+
+void CatModel::createVertexBuffers( std::span< const Vertex > vertices )
 {
 	m_nVertexCount = static_cast< uint32_t >( vertices.size() );
 	assert( m_nVertexCount >= 3 && "Vertex count must be at least 3" );
 	vk::DeviceSize bufferSize = sizeof( vertices[0] ) * m_nVertexCount;
-	uint32_t vertexSize = sizeof( vertices[0] );
-
-	CatBuffer stagingBuffer{
-		m_pDevice,
-		vertexSize,
-		m_nVertexCount,
-		vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-	};
-
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer( (void*)vertices.data() );
+	vk::DeviceSize offset = sizeof( vertices[0] ) * vk::DeviceSize( m_geometry.nFirstVertex );
 
-	m_pVertexBuffer = std::make_unique< CatBuffer >( m_pDevice, vertexSize, m_nVertexCount,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-		vk::MemoryPropertyFlagBits::eDeviceLocal );
-
-	m_pDevice->copyBuffer( *stagingBuffer, **m_pVertexBuffer, bufferSize );
+	auto& pool = m_pDevice->getGeometryPool();
+	m_aUploads.push_back( m_pDevice->getUploader().uploadBuffer(
+		pool.getVertexBuffer( m_geometry.nPage ), vertices.data(), bufferSize, offset ) );
 }
 
-void CatModel::createIndexBuffers( const std::vector< uint32_t >& indices )
+void CatModel::createIndexBuffers( std::span< const uint32_t > indices )
 {
 	m_nIndexCount = static_cast< uint32_t >( indices.size() );
 	m_bHasIndexBuffer = m_nIndexCount > 0;
@@ -81,48 +90,28 @@ void CatModel::createIndexBuffers( const std::vector< uint32_t >& indices )
 	}
 
 	vk::DeviceSize bufferSize = sizeof( indices[0] ) * m_nIndexCount;
-	uint32_t indexSize = sizeof( indices[0] );
-
-	CatBuffer stagingBuffer{
-		m_pDevice,
-		indexSize,
-		m_nIndexCount,
-		vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-	};
+	vk::DeviceSize offset = sizeof( indices[0] ) * vk::DeviceSize( m_geometry.nFirstIndex );
 
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer( (void*)indices.data() );
-
-	m_pIndexBuffer = std::make_unique< CatBuffer >( m_pDevice, indexSize, m_nIndexCount,
-		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-		vk::MemoryPropertyFlagBits::eDeviceLocal );
-
-	m_pDevice->copyBuffer( *stagingBuffer, **m_pIndexBuffer, bufferSize );
+	auto& pool = m_pDevice->getGeometryPool();
+	m_aUploads.push_back( m_pDevice->getUploader().uploadBuffer(
+		pool.getIndexBuffer( m_geometry.nPage ), indices.data(), bufferSize, offset ) );
 }
 
-void CatModel::draw( vk::CommandBuffer commandBuffer )
+void CatModel::draw( vk::CommandBuffer commandBuffer, const uint32_t nInstanceCount, const uint32_t nFirstInstance ) const
 {
 	if ( m_bHasIndexBuffer )
 	{
-		commandBuffer.drawIndexed( m_nIndexCount, 1, 0, 0, 0 );
+		commandBuffer.drawIndexed( m_nIndexCount, nInstanceCount, m_geometry.nFirstIndex, getVertexOffset(), nFirstInstance );
 	}
 	else
 	{
-		commandBuffer.draw( m_nVertexCount, 1, 0, 0 );
+		commandBuffer.draw( m_nVertexCount, nInstanceCount, m_geometry.nFirstVertex, nFirstInstance );
 	}
 }
 
-void CatModel::bind( vk::CommandBuffer commandBuffer )
+void CatModel::bind( vk::CommandBuffer commandBuffer, uint32_t& nBoundPage ) const
 {
-	vk::Buffer buffers[] = { m_pVertexBuffer->getBuffer() };
-	vk::DeviceSize offsets[] = { 0 };
-	commandBuffer.bindVertexBuffers( 0, 1, buffers, offsets );
-
-	if ( m_bHasIndexBuffer )
-	{
-		commandBuffer.bindIndexBuffer( **m_pIndexBuffer, 0, vk::IndexType::eUint32 );
-	}
+	m_pDevice->getGeometryPool().bind( commandBuffer, m_geometry.nPage, nBoundPage );
 }
 
 std::vector< vk::VertexInputBindingDescription > CatModel::Vertex::getBindingDescriptions()
@@ -149,67 +138,32 @@ std::vector< vk::VertexInputAttributeDescription > CatModel::Vertex::getAttribut
 	return attributeDescriptions;
 }
 
-void CatModel::Builder::loadModel( const std::string& filepath )
+vk::VertexInputBindingDescription CatModel::Instance::getBindingDescription()
 {
-	tinyobj::attrib_t attrib;
-	std::vector< tinyobj::shape_t > shapes;
-	std::vector< tinyobj::material_t > materials;
-	std::string warn, err;
+	return {
+		.binding = BINDING,
+		.stride = sizeof( Instance ),
+		.inputRate = vk::VertexInputRate::eInstance,
+	};
+}
 
-	if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, filepath.c_str() ) )
+std::vector< vk::VertexInputAttributeDescription > CatModel::Instance::getAttributeDescriptions()
+{
+	// A mat4 attribute takes a location per column.
+	std::vector< vk::VertexInputAttributeDescription > attributeDescriptions{};
+	for ( uint32_t i = 0; i < 4; ++i )
 	{
-		throw std::runtime_error( warn + err );
+		attributeDescriptions.push_back( { FIRST_LOCATION + i, BINDING, vk::Format::eR32G32B32A32Sfloat,
+			static_cast< uint32_t >( offsetof( Instance, mxModel ) + i * sizeof( glm::vec4 ) ) } );
 	}
-
-	aVertices.clear();
-	aIndices.clear();
-
-	std::unordered_map< Vertex, uint32_t > uniqueVertices{};
-	for ( const auto& shape : shapes )
+	for ( uint32_t i = 0; i < 4; ++i )
 	{
-		for ( const auto& index : shape.mesh.indices )
-		{
-			Vertex vertex{};
-
-			if ( index.vertex_index >= 0 )
-			{
-				vertex.vPosition = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2],
-				};
-
-				vertex.vColor = {
-					attrib.colors[3 * index.vertex_index + 0],
-					attrib.colors[3 * index.vertex_index + 1],
-					attrib.colors[3 * index.vertex_index + 2],
-				};
-			}
-
-			if ( index.normal_index >= 0 )
-			{
-				vertex.vNormal = {
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2],
-				};
-			}
-
-			if ( index.texcoord_index >= 0 )
-			{
-				vertex.vUV = {
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					attrib.texcoords[2 * index.texcoord_index + 1],
-				};
-			}
-
-			if ( !uniqueVertices.contains( vertex ) )
-			{
-				uniqueVertices[vertex] = static_cast< uint32_t >( aVertices.size() );
-				aVertices.push_back( vertex );
-			}
-			aIndices.push_back( uniqueVertices[vertex] );
-		}
+		attributeDescriptions.push_back( { FIRST_LOCATION + 4 + i, BINDING, vk::Format::eR32G32B32A32Sfloat,
+			static_cast< uint32_t >( offsetof( Instance, mxNormal ) + i * sizeof( glm::vec4 ) ) } );
 	}
+	attributeDescriptions.push_back( { FIRST_LOCATION + 8, BINDING, vk::Format::eR32Sfloat,
+		static_cast< uint32_t >( offsetof( Instance, fOpacity ) ) } );
+
+	return attributeDescriptions;
 }
 } // namespace cat
@@ -9,6 +9,7 @@
 #include "glm/glm.hpp"
 
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace cat
@@ -32,38 +33,97 @@ public:
 		}
 	};
 
+	// Per instance vertex attributes of the instanced pipelines, binding 1 from location 4 on.
+	struct Instance
+	{
+		glm::mat4 mxModel{ 1.f };
+		glm::mat4 mxNormal{ 1.f };
+		float fOpacity = 1.f;
+
+		static constexpr uint32_t BINDING = 1;
+		static constexpr uint32_t FIRST_LOCATION = 4;
+
+		static vk::VertexInputBindingDescription getBindingDescription();
+		static std::vector< vk::VertexInputAttributeDescription > getAttributeDescriptions();
+	};
+
 	struct Builder
 	{
 		std::vector< Vertex > aVertices{};
 		std::vector< uint32_t > aIndices{};
 
-		void loadModel( const std::string& filepath );
+		// Parses with CatObjParser on at most nMaxThreads threads, files it can't handle go through tinyobj.
+		void loadModel( const std::string& filepath, unsigned nMaxThreads = 0 );
+		// The original import path, deduplicates on the vertex values instead of the OBJ indices.
+		void loadModelTinyObj( const std::string& filepath );
+	};
+
+	// Model space bounds, computed from the vertices at load.
+	struct Bounds
+	{
+		glm::vec3 vMin{};
+		glm::vec3 vMax{};
+		glm::vec3 vCenter{};
+		float fRadius = 0.0f;
 	};
 
 	CatModel( CatDevice* pDevice, const CatModel::Builder& builder );
+	CatModel( CatDevice* pDevice, std::span< const Vertex > aVertices, std::span< const uint32_t > aIndices );
 	~CatModel();
 
 	CatModel( const CatModel& ) = delete;
 	CatModel& operator=( const CatModel& ) = delete;
 
 	// TODO: Don't load a model twice
-	static std::shared_ptr< CatModel > createModelFromFile( CatDevice* pDevice, const std::string& filepath );
+	static std::shared_ptr< CatModel > createModelFromFile( CatDevice* pDevice,
+		const std::string& filepath,
+		unsigned nMaxThreads = 0 );
 
-	void bind( vk::CommandBuffer commandBuffer );
-	void draw( vk::CommandBuffer commandBuffer );
+	// Binds the model's geometry page unless nBoundPage says it already is, start a frame with CatGeometryPool::NO_PAGE.
+	void bind( vk::CommandBuffer commandBuffer, uint32_t& nBoundPage ) const;
+	void draw( vk::CommandBuffer commandBuffer, uint32_t nInstanceCount = 1, uint32_t nFirstInstance = 0 ) const;
+
+	// The buffers are uploaded together with the other loader threads' ones, the model can't be drawn before they finished.
+	void waitUntilUploaded() const
+	{
+		for ( const auto& fUploaded : m_aUploads )
+		{
+			fUploaded.wait();
+		}
+	}
+
+	[[nodiscard]] const Bounds& getBounds() const { return m_bounds; }
+
+	// Where the geometry is in the pool's buffers, for indirect draws.
+	[[nodiscard]] uint32_t getGeometryPage() const { return m_geometry.nPage; }
+	[[nodiscard]] bool hasIndexBuffer() const { return m_bHasIndexBuffer; }
+	[[nodiscard]] uint32_t getIndexCount() const { return m_nIndexCount; }
+	[[nodiscard]] uint32_t getFirstIndex() const { return m_geometry.nFirstIndex; }
+	[[nodiscard]] int32_t getVertexOffset() const { return static_cast< int32_t >( m_geometry.nFirstVertex ); }
+
+	// Geometry pool memory used by the vertices and indices.
+	[[nodiscard]] vk::DeviceSize getMemorySize() const
+	{
+		return vk::DeviceSize( m_nVertexCount ) * sizeof( Vertex ) + vk::DeviceSize( m_nIndexCount ) * sizeof( uint32_t );
+	}
 
 private:
-	void createVertexBuffers( const std::vector< Vertex >& vertices );
-	void createIndexBuffers( const std::vector< uint32_t >& indices );
+	void createVertexBuffers( std::span< const Vertex > vertices );
+	void createIndexBuffers( std::span< const uint32_t > indices );
+	void computeBounds( std::span< const Vertex > vertices );
 
 	CatDevice* m_pDevice;
 
-	std::unique_ptr< CatBuffer > m_pVertexBuffer;
+	// Ranges in the device's geometry pool.
+	CatGeometryPool::Allocation m_geometry{};
 	uint32_t m_nVertexCount;
 
 	bool m_bHasIndexBuffer = false;
-	std::unique_ptr< CatBuffer > m_pIndexBuffer;
 	uint32_t m_nIndexCount;
+
+	Bounds m_bounds{};
+
+	std::vector< std::shared_future< void > > m_aUploads;
 };
 } // namespace cat
 
@@ -0,0 +1,104 @@
+#include "CatModel.hpp"
+#include "CatObjParser.hpp"
+
+#include "Cat/Utils/CatUtils.hpp"
+#include "loguru.hpp"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/hash.hpp"
+
+#include <stdexcept>
+#include <unordered_map>
+
+namespace std
+{
+template <>
+struct hash< cat::CatModel::Vertex >
+{
+	size_t operator()( cat::CatModel::Vertex const& vertex ) const
+	{
+		size_t seed = 0;
+		cat::HashCombine( seed, vertex.vPosition, vertex.vColor, vertex.vNormal, vertex.vUV );
+		return seed;
+	}
+};
+} // namespace std
+
+
+namespace cat
+{
+void CatModel::Builder::loadModel( const std::string& filepath, const unsigned nMaxThreads /* = 0 */ )
+{
+	std::string sError;
+	if ( CatObjParser::parse( filepath, *this, sError, nMaxThreads ) ) return;
+
+	LOG_F( WARNING, "Parallel import of %s failed (%s), falling back to tinyobj", filepath.c_str(), sError.c_str() );
+	loadModelTinyObj( filepath );
+}
+
+void CatModel::Builder::loadModelTinyObj( const std::string& filepath )
+{
+	tinyobj::attrib_t attrib;
+	std::vector< tinyobj::shape_t > shapes;
+	std::vector< tinyobj::material_t > materials;
+	std::string warn, err;
+
+	if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, filepath.c_str() ) )
+	{
+		throw std::runtime_error( warn + err );
+	}
+
+	aVertices.clear();
+	aIndices.clear();
+
+	std::unordered_map< Vertex, uint32_t > uniqueVertices{};
+	for ( const auto& shape : shapes )
+	{
+		for ( const auto& index : shape.mesh.indices )
+		{
+			Vertex vertex{};
+
+			if ( index.vertex_index >= 0 )
+			{
+				vertex.vPosition = {
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2],
+				};
+
+				vertex.vColor = {
+					attrib.colors[3 * index.vertex_index + 0],
+					attrib.colors[3 * index.vertex_index + 1],
+					attrib.colors[3 * index.vertex_index + 2],
+				};
+			}
+
+			if ( index.normal_index >= 0 )
+			{
+				vertex.vNormal = {
+					attrib.normals[3 * index.normal_index + 0],
+					attrib.normals[3 * index.normal_index + 1],
+					attrib.normals[3 * index.normal_index + 2],
+				};
+			}
+
+			if ( index.texcoord_index >= 0 )
+			{
+				vertex.vUV = {
+					attrib.texcoords[2 * index.texcoord_index + 0],
+					attrib.texcoords[2 * index.texcoord_index + 1],
+				};
+			}
+
+			if ( !uniqueVertices.contains( vertex ) )
+			{
+				uniqueVertices[vertex] = static_cast< uint32_t >( aVertices.size() );
+				aVertices.push_back( vertex );
+			}
+			aIndices.push_back( uniqueVertices[vertex] );
+		}
+	}
+}
+} // namespace cat
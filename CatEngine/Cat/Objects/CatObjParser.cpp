@@ -0,0 +1,534 @@
+#include "CatObjParser.hpp"
+
+#include "Cat/Utils/CatMappedFile.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace cat
+{
+static constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+
+namespace
+{
+// Indices of a face corner into the attribute arrays of the whole file, NO_INDEX if the attribute is missing.
+struct Corner
+{
+	uint32_t nPosition;
+	uint32_t nTexcoord;
+	uint32_t nNormal;
+
+	bool operator==( const Corner& other ) const = default;
+};
+
+enum class LineType
+{
+	eOther,
+	ePosition,
+	eTexcoord,
+	eNormal,
+	eFace,
+};
+
+// Line range parsed by one thread. The first pass counts the elements, the bases are the offsets of the range's elements in
+// the arrays of the whole file.
+struct Range
+{
+	const char* pBegin;
+	const char* pEnd;
+
+	size_t nPositions = 0;
+	size_t nTexcoords = 0;
+	size_t nNormals = 0;
+	size_t nFaces = 0;
+	size_t nCorners = 0;
+
+	size_t nPositionBase = 0;
+	size_t nTexcoordBase = 0;
+	size_t nNormalBase = 0;
+	size_t nFaceBase = 0;
+	size_t nCornerBase = 0;
+
+	const char* sError = nullptr;
+};
+
+// Attributes of the whole file, every range writes its own part.
+struct Attributes
+{
+	std::vector< float > aPositions;
+	std::vector< float > aColors;
+	std::vector< float > aTexcoords;
+	std::vector< float > aNormals;
+	std::vector< uint32_t > aFaceSizes;
+	std::vector< Corner > aCorners;
+};
+} // namespace
+
+static bool IsSpace( const char c )
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* SkipSpaces( const char* p, const char* pEnd )
+{
+	while ( p < pEnd && IsSpace( *p ) )
+	{
+		++p;
+	}
+	return p;
+}
+
+static LineType GetLineType( const char*& p, const char* pEnd )
+{
+	if ( pEnd - p < 2 ) return LineType::eOther;
+
+	if ( p[0] == 'f' && IsSpace( p[1] ) )
+	{
+		p += 2;
+		return LineType::eFace;
+	}
+	if ( p[0] != 'v' ) return LineType::eOther;
+	if ( IsSpace( p[1] ) )
+	{
+		p += 2;
+		return LineType::ePosition;
+	}
+	if ( pEnd - p < 3 || !IsSpace( p[2] ) ) return LineType::eOther;
+	if ( p[1] == 't' )
+	{
+		p += 3;
+		return LineType::eTexcoord;
+	}
+	if ( p[1] == 'n' )
+	{
+		p += 3;
+		return LineType::eNormal;
+	}
+	return LineType::eOther;
+}
+
+template < typename TFunction >
+static void ForEachLine( const char* p, const char* pEnd, TFunction&& fnLine )
+{
+	while ( p < pEnd )
+	{
+		auto pLineEnd = static_cast< const char* >( std::memchr( p, '\n', static_cast< size_t >( pEnd - p ) ) );
+		if ( !pLineEnd )
+		{
+			pLineEnd = pEnd;
+		}
+
+		auto pLine = SkipSpaces( p, pLineEnd );
+		const auto eType = GetLineType( pLine, pLineEnd );
+		if ( eType != LineType::eOther && !fnLine( eType, pLine, pLineEnd ) ) return;
+
+		p = pLineEnd + 1;
+	}
+}
+
+static size_t CountTokens( const char* p, const char* pEnd )
+{
+	size_t nTokens = 0;
+	while ( ( p = SkipSpaces( p, pEnd ) ) < pEnd )
+	{
+		++nTokens;
+		while ( p < pEnd && !IsSpace( *p ) )
+		{
+			++p;
+		}
+	}
+	return nTokens;
+}
+
+static bool ParseFloat( const char*& p, const char* pEnd, float& fValue )
+{
+	p = SkipSpaces( p, pEnd );
+	// from_chars does not accept a leading plus.
+	if ( p < pEnd && *p == '+' ) ++p;
+
+	const auto [pNext, error] = std::from_chars( p, pEnd, fValue );
+	if ( error != std::errc() ) return false;
+
+	p = pNext;
+	return true;
+}
+
+// Resolves a one based or negative (relative to the last element) OBJ index to a zero based one.
+static bool ParseIndex( const char*& p, const char* pEnd, const size_t nCount, uint32_t& nIndex )
+{
+	int64_t nValue = 0;
+	const auto [pNext, error] = std::from_chars( p, pEnd, nValue );
+	if ( error != std::errc() || nValue == 0 ) return false;
+	p = pNext;
+
+	nValue = nValue > 0 ? nValue - 1 : static_cast< int64_t >( nCount ) + nValue;
+	if ( nValue < 0 || nValue >= NO_INDEX ) return false;
+
+	nIndex = static_cast< uint32_t >( nValue );
+	return true;
+}
+
+// v, v/vt, v//vn or v/vt/vn. The counts are the elements before the line, for relative indices.
+static bool ParseCorner( const char*& p, const char* pEnd, const Range& range, Corner& corner )
+{
+	corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+	if ( !ParseIndex( p, pEnd, range.nPositionBase + range.nPositions, corner.nPosition ) ) return false;
+	if ( p >= pEnd || *p != '/' ) return true;
+
+	++p;
+	if ( p < pEnd && *p != '/' && !ParseIndex( p, pEnd, range.nTexcoordBase + range.nTexcoords, corner.nTexcoord ) )
+	{
+		return false;
+	}
+	if ( p >= pEnd || *p != '/' ) return true;
+
+	++p;
+	return ParseIndex( p, pEnd, range.nNormalBase + range.nNormals, corner.nNormal );
+}
+
+static void CountRange( Range& range )
+{
+	ForEachLine( range.pBegin, range.pEnd,
+		[&range]( const LineType eType, const char* p, const char* pEnd )
+		{
+			switch ( eType )
+			{
+			case LineType::ePosition: ++range.nPositions; break;
+			case LineType::eTexcoord: ++range.nTexcoords; break;
+			case LineType::eNormal: ++range.nNormals; break;
+			case LineType::eFace:
+				++range.nFaces;
+				range.nCorners += CountTokens( p, pEnd );
+				break;
+			default: break;
+			}
+			return true;
+		} );
+}
+
+// The counts are reset and counted again while parsing, relative indices are resolved against them.
+static void ParseRange( Range& range, Attributes& attributes )
+{
+	range.nPositions = range.nTexcoords = range.nNormals = range.nFaces = range.nCorners = 0;
+
+	ForEachLine( range.pBegin, range.pEnd,
+		[&range, &attributes]( const LineType eType, const char* p, const char* pEnd )
+		{
+			switch ( eType )
+			{
+			case LineType::ePosition:
+			{
+				const auto nOffset = 3 * ( range.nPositionBase + range.nPositions++ );
+				auto pPosition = &attributes.aPositions[nOffset];
+				if ( !ParseFloat( p, pEnd, pPosition[0] ) || !ParseFloat( p, pEnd, pPosition[1] )
+					 || !ParseFloat( p, pEnd, pPosition[2] ) )
+				{
+					range.sError = "invalid position";
+					return false;
+				}
+
+				// Vertex colors follow the position, white if there are none like in tinyobj.
+				auto pColor = &attributes.aColors[nOffset];
+				if ( !ParseFloat( p, pEnd, pColor[0] ) || !ParseFloat( p, pEnd, pColor[1] ) || !ParseFloat( p, pEnd, pColor[2] ) )
+				{
+					pColor[0] = pColor[1] = pColor[2] = 1.0f;
+				}
+				return true;
+			}
+			case LineType::eTexcoord:
+			{
+				auto pTexcoord = &attributes.aTexcoords[2 * ( range.nTexcoordBase + range.nTexcoords++ )];
+				if ( !ParseFloat( p, pEnd, pTexcoord[0] ) )
+				{
+					range.sError = "invalid texture coordinate";
+					return false;
+				}
+				if ( !ParseFloat( p, pEnd, pTexcoord[1] ) )
+				{
+					pTexcoord[1] = 0.0f;
+				}
+				return true;
+			}
+			case LineType::eNormal:
+			{
+				auto pNormal = &attributes.aNormals[3 * ( range.nNormalBase + range.nNormals++ )];
+				if ( !ParseFloat( p, pEnd, pNormal[0] ) || !ParseFloat( p, pEnd, pNormal[1] ) || !ParseFloat( p, pEnd, pNormal[2] ) )
+				{
+					range.sError = "invalid normal";
+					return false;
+				}
+				return true;
+			}
+			case LineType::eFace:
+			{
+				uint32_t nSize = 0;
+				while ( ( p = SkipSpaces( p, pEnd ) ) < pEnd )
+				{
+					// A corner has to end its token, the count of the first pass could be exceeded otherwise.
+					if ( !ParseCorner( p, pEnd, range, attributes.aCorners[range.nCornerBase + range.nCorners++] )
+						 || ( p < pEnd && !IsSpace( *p ) ) )
+					{
+						range.sError = "invalid face";
+						return false;
+					}
+					++nSize;
+				}
+				attributes.aFaceSizes[range.nFaceBase + range.nFaces++] = nSize;
+				return true;
+			}
+			default: return true;
+			}
+		} );
+}
+
+// Runs fnTask( i ) for every i below nCount, the first one on the calling thread.
+template < typename TFunction >
+static void ParallelFor( const size_t nCount, TFunction&& fnTask )
+{
+	std::vector< std::future< void > > aFutures;
+	aFutures.reserve( nCount );
+	for ( size_t i = 1; i < nCount; ++i )
+	{
+		aFutures.push_back( std::async( std::launch::async, [&fnTask, i]() { fnTask( i ); } ) );
+	}
+	if ( nCount > 0 )
+	{
+		fnTask( 0 );
+	}
+	for ( auto& f : aFutures )
+	{
+		f.get();
+	}
+}
+
+static uint32_t HashCorner( const Corner& corner )
+{
+	// murmur3 finalizer over the mixed indices.
+	uint32_t nHash = corner.nPosition * 0x9E3779B1u ^ corner.nTexcoord * 0x85EBCA77u ^ corner.nNormal * 0xC2B2AE3Du;
+	nHash ^= nHash >> 16;
+	nHash *= 0x85EBCA6Bu;
+	nHash ^= nHash >> 13;
+	nHash *= 0xC2B2AE35u;
+	nHash ^= nHash >> 16;
+	return nHash;
+}
+
+bool CatObjParser::parse( const std::string& sPath, CatModel::Builder& builder, std::string& sError, unsigned nMaxThreads )
+{
+	const CatMappedFile file( sPath );
+	if ( !file.isOpen() )
+	{
+		sError = "failed to map " + sPath;
+		return false;
+	}
+
+	const auto pData = reinterpret_cast< const char* >( file.data() );
+	const auto pDataEnd = pData + file.size();
+
+	if ( nMaxThreads == 0 )
+	{
+		nMaxThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	}
+	const auto nRanges = std::clamp< size_t >( file.size() / MIN_RANGE_SIZE, 1, nMaxThreads );
+
+	// Split at line ends, every range starts at the beginning of a line.
+	std::vector< Range > aRanges;
+	aRanges.reserve( nRanges );
+	for ( size_t i = 0; i < nRanges; ++i )
+	{
+		const auto pBegin = aRanges.empty() ? pData : aRanges.back().pEnd;
+		auto pEnd = pDataEnd;
+		if ( i + 1 < nRanges )
+		{
+			pEnd = std::max( pBegin, pData + file.size() * ( i + 1 ) / nRanges );
+			auto pNewLine = static_cast< const char* >( std::memchr( pEnd, '\n', static_cast< size_t >( pDataEnd - pEnd ) ) );
+			pEnd = pNewLine ? pNewLine + 1 : pDataEnd;
+		}
+		aRanges.push_back( { pBegin, pEnd } );
+	}
+
+	ParallelFor( nRanges, [&aRanges]( const size_t i ) { CountRange( aRanges[i] ); } );
+
+	size_t nPositions = 0, nTexcoords = 0, nNormals = 0, nFaces = 0, nCorners = 0;
+	for ( auto& range : aRanges )
+	{
+		range.nPositionBase = nPositions;
+		range.nTexcoordBase = nTexcoords;
+		range.nNormalBase = nNormals;
+		range.nFaceBase = nFaces;
+		range.nCornerBase = nCorners;
+		nPositions += range.nPositions;
+		nTexcoords += range.nTexcoords;
+		nNormals += range.nNormals;
+		nFaces += range.nFaces;
+		nCorners += range.nCorners;
+	}
+
+	if ( nFaces == 0 )
+	{
+		sError = "no faces";
+		return false;
+	}
+	if ( nPositions >= NO_INDEX || nCorners >= NO_INDEX )
+	{
+		sError = "too many elements";
+		return false;
+	}
+
+	Attributes attributes;
+	attributes.aPositions.resize( 3 * nPositions );
+	attributes.aColors.resize( 3 * nPositions );
+	attributes.aTexcoords.resize( 2 * nTexcoords );
+	attributes.aNormals.resize( 3 * nNormals );
+	attributes.aFaceSizes.resize( nFaces );
+	attributes.aCorners.resize( nCorners );
+
+	ParallelFor( nRanges, [&aRanges, &attributes]( const size_t i ) { ParseRange( aRanges[i], attributes ); } );
+
+	for ( const auto& range : aRanges )
+	{
+		if ( range.sError )
+		{
+			sError = range.sError;
+			return false;
+		}
+	}
+
+	// Triangulated the same way as tinyobj for triangles and quads, larger polygons become fans.
+	size_t nTriangleCorners = 0;
+	for ( const auto nSize : attributes.aFaceSizes )
+	{
+		if ( nSize >= 3 )
+		{
+			nTriangleCorners += 3 * ( nSize - 2 );
+		}
+	}
+
+	const auto nTableSize = std::bit_ceil( 2 * nCorners );
+	const auto nMask = static_cast< uint32_t >( nTableSize - 1 );
+	std::vector< uint32_t > aTable( nTableSize, NO_INDEX );
+	std::vector< Corner > aUniqueCorners;
+	aUniqueCorners.reserve( nCorners );
+
+	builder.aIndices.clear();
+	builder.aIndices.reserve( nTriangleCorners );
+
+	bool bValid = true;
+	auto emit = [&]( const Corner& corner )
+	{
+		if ( corner.nPosition >= nPositions || ( corner.nTexcoord != NO_INDEX && corner.nTexcoord >= nTexcoords )
+			 || ( corner.nNormal != NO_INDEX && corner.nNormal >= nNormals ) )
+		{
+			bValid = false;
+			return;
+		}
+
+		auto nSlot = HashCorner( corner ) & nMask;
+		while ( true )
+		{
+			auto& nId = aTable[nSlot];
+			if ( nId == NO_INDEX )
+			{
+				nId = static_cast< uint32_t >( aUniqueCorners.size() );
+				aUniqueCorners.push_back( corner );
+				break;
+			}
+			if ( aUniqueCorners[nId] == corner ) break;
+			nSlot = ( nSlot + 1 ) & nMask;
+		}
+		builder.aIndices.push_back( aTable[nSlot] );
+	};
+
+	auto position = [&attributes]( const Corner& corner )
+	{
+		const auto p = &attributes.aPositions[3 * size_t( corner.nPosition )];
+		return glm::vec3( p[0], p[1], p[2] );
+	};
+
+	const Corner* pFace = attributes.aCorners.data();
+	for ( const auto nSize : attributes.aFaceSizes )
+	{
+		if ( nSize == 3 )
+		{
+			emit( pFace[0] );
+			emit( pFace[1] );
+			emit( pFace[2] );
+		}
+		else if ( nSize == 4 )
+		{
+			if ( std::any_of( pFace, pFace + 4, [nPositions]( const Corner& corner ) { return corner.nPosition >= nPositions; } ) )
+			{
+				sError = "face index out of range";
+				return false;
+			}
+
+			// Split along the shorter diagonal.
+			const auto e02 = position( pFace[2] ) - position( pFace[0] );
+			const auto e13 = position( pFace[3] ) - position( pFace[1] );
+			const bool bSplit02 = glm::dot( e02, e02 ) < glm::dot( e13, e13 );
+			emit( pFace[0] );
+			emit( pFace[1] );
+			emit( pFace[bSplit02 ? 2 : 3] );
+			emit( pFace[bSplit02 ? 0 : 1] );
+			emit( pFace[2] );
+			emit( pFace[3] );
+		}
+		else
+		{
+			for ( uint32_t i = 2; i < nSize; ++i )
+			{
+				emit( pFace[0] );
+				emit( pFace[i - 1] );
+				emit( pFace[i] );
+			}
+		}
+
+		if ( !bValid )
+		{
+			sError = "face index out of range";
+			return false;
+		}
+		pFace += nSize;
+	}
+
+	builder.aVertices.clear();
+	builder.aVertices.resize( aUniqueCorners.size() );
+
+	const auto nVertexRanges = std::clamp< size_t >( aUniqueCorners.size() / ( MIN_RANGE_SIZE / sizeof( CatModel::Vertex ) ), 1,
+		nMaxThreads );
+	ParallelFor( nVertexRanges,
+		[&]( const size_t nRange )
+		{
+			const auto nBegin = aUniqueCorners.size() * nRange / nVertexRanges;
+			const auto nEnd = aUniqueCorners.size() * ( nRange + 1 ) / nVertexRanges;
+			for ( size_t i = nBegin; i < nEnd; ++i )
+			{
+				const auto& corner = aUniqueCorners[i];
+				auto& vertex = builder.aVertices[i];
+
+				const auto pColor = &attributes.aColors[3 * size_t( corner.nPosition )];
+				vertex.vPosition = position( corner );
+				vertex.vColor = { pColor[0], pColor[1], pColor[2] };
+
+				if ( corner.nNormal != NO_INDEX )
+				{
+					const auto pNormal = &attributes.aNormals[3 * size_t( corner.nNormal )];
+					vertex.vNormal = { pNormal[0], pNormal[1], pNormal[2] };
+				}
+				if ( corner.nTexcoord != NO_INDEX )
+				{
+					const auto pTexcoord = &attributes.aTexcoords[2 * size_t( corner.nTexcoord )];
+					vertex.vUV = { pTexcoord[0], pTexcoord[1] };
+				}
+			}
+		} );
+
+	return true;
+}
+
+} // namespace cat
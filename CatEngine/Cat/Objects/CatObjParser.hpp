@@ -0,0 +1,29 @@
+#ifndef CATENGINE_CATOBJPARSER_HPP
+#define CATENGINE_CATOBJPARSER_HPP
+
+#include "Cat/Objects/CatModel.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace cat
+{
+
+// Parallel importer for the part of OBJ the engine uses: positions with optional vertex colors, normals, texture coordinates and
+// polygonal faces. Materials, groups and smoothing groups are skipped, the tinyobj path ignores them as well.
+// The file is split into line ranges that are counted and then parsed on separate threads straight into exactly sized arrays.
+// Corners are deduplicated on their (position, texcoord, normal) index triple with an open addressing table.
+class CatObjParser
+{
+public:
+	// Smaller files, or the parts of a file smaller than this, are not worth another thread.
+	static constexpr size_t MIN_RANGE_SIZE = size_t( 1 ) << 20;
+
+	// Returns false with the reason if the file can't be read or uses something the parser does not support.
+	// nMaxThreads 0 uses every hardware thread.
+	static bool parse( const std::string& sPath, CatModel::Builder& builder, std::string& sError, unsigned nMaxThreads = 0 );
+};
+
+} // namespace cat
+
+#endif // CATENGINE_CATOBJPARSER_HPP
@@ -8,55 +8,38 @@
 #include <glm/ext.hpp>
 #include "glm/gtc/matrix_inverse.hpp"
 
+#include <algorithm>
+
 namespace cat
 {
-id_t CatObject::M_ID_CURRENT = 1;
+std::atomic< id_t > CatObject::M_ID_CURRENT = 1;
 
-glm::mat4 TransformComponent::mat4() const
+const CatModel::Bounds& CatObject::getWorldBounds()
 {
-	auto m = glm::mat4( 1.0f );
-
-	const auto rotationRad = glm::radians( rotation );
-
-	m = glm::translate( m, translation );
-	m = glm::rotate( m, rotationRad.y, { 0.f, 1.f, 0.f } );
-	m = glm::rotate( m, rotationRad.x, { 1.f, 0.f, 0.f } );
-	m = glm::rotate( m, rotationRad.z, { 0.f, 0.f, 1.f } );
-	m = glm::scale( m, scale );
-
-	return m;
-}
-
-glm::mat3 TransformComponent::normalMatrix() const
-{
-	return glm::mat3( glm::inverseTranspose( this->mat4() ) );
-
-	// Old manual inverse transpose code
-	const float c3 = glm::cos( rotation.z );
-	const float s3 = glm::sin( rotation.z );
-	const float c2 = glm::cos( rotation.x );
-	const float s2 = glm::sin( rotation.x );
-	const float c1 = glm::cos( rotation.y );
-	const float s1 = glm::sin( rotation.y );
-	const glm::vec3 invScale = 1.0f / scale;
-
-	return glm::mat3{
-		{
-			invScale.x * ( c1 * c3 + s1 * s2 * s3 ),
-			invScale.x * ( c2 * s3 ),
-			invScale.x * ( c1 * s2 * s3 - c3 * s1 ),
-		},
-		{
-			invScale.y * ( c3 * s1 * s2 - c1 * s3 ),
-			invScale.y * ( c2 * c3 ),
-			invScale.y * ( c1 * c3 * s2 + s1 * s3 ),
-		},
-		{
-			invScale.z * ( c2 * s1 ),
-			invScale.z * ( -s2 ),
-			invScale.z * ( c1 * c2 ),
-		},
-	};
+	const auto* pModel = m_pModel.get();
+	if ( pModel == m_pBoundsModel && m_transform == m_boundsTransform )
+	{
+		return m_worldBounds;
+	}
+	m_pBoundsModel = pModel;
+	m_boundsTransform = m_transform;
+	if ( !pModel ) return m_worldBounds = {};
+
+	const auto& bounds = pModel->getBounds();
+	const auto& mxModel = m_transform.mat4();
+
+	// The extents of the transformed box are the extents projected onto the absolute basis vectors.
+	const auto vCenter = glm::vec3( mxModel * glm::vec4( bounds.vCenter, 1.0f ) );
+	const auto vExtent = ( bounds.vMax - bounds.vMin ) * 0.5f;
+	const auto vWorldExtent = glm::abs( glm::vec3( mxModel[0] ) ) * vExtent.x + glm::abs( glm::vec3( mxModel[1] ) ) * vExtent.y
+		+ glm::abs( glm::vec3( mxModel[2] ) ) * vExtent.z;
+
+	const auto vScale = glm::abs( m_transform.scale );
+	m_worldBounds.vMin = vCenter - vWorldExtent;
+	m_worldBounds.vMax = vCenter + vWorldExtent;
+	m_worldBounds.vCenter = vCenter;
+	m_worldBounds.fRadius = bounds.fRadius * std::max( { vScale.x, vScale.y, vScale.z } );
+	return m_worldBounds;
 }
 
 json CatObject::save()
@@ -79,6 +62,10 @@ json CatObject::save()
 	object["transform"]["s"] = m_transform.scale;
 
 	object["color"] = m_vColor;
+	if ( isTransparent() )
+	{
+		object["opacity"] = m_fOpacity;
+	}
 
 	return object;
 }
@@ -87,13 +74,40 @@ void CatObject::load( const json& object )
 {
 	// m_pModel = model;
 
-	m_transform.translation = glm::make_vec3( object["transform"]["t"].get< std::vector< float > >().data() );
-	m_transform.rotation = glm::make_vec3( object["transform"]["r"].get< std::vector< float > >().data() );
-	m_transform.scale = glm::make_vec3( object["transform"]["s"].get< std::vector< float > >().data() );
-	m_vColor = glm::make_vec3( object["color"].get< std::vector< float > >().data() );
+	const auto readVec3 = []( const json& array )
+	{ return glm::vec3( array[0].get< float >(), array[1].get< float >(), array[2].get< float >() ); };
 
-	LOG_F( INFO, "Frame: %llu, obj loaded: %s", GetEditorInstance()->m_RFrameInfo.m_nFrameNumber,
-		object["name"].get< std::string >().c_str() );
+	m_transform.translation = readVec3( object["transform"]["t"] );
+	m_transform.rotation = readVec3( object["transform"]["r"] );
+	m_transform.scale = readVec3( object["transform"]["s"] );
+	m_transform.markDirty();
+	m_vColor = readVec3( object["color"] );
+	m_fOpacity = object.value( "opacity", 1.f );
+
+	LOG_F( INFO, "Frame: %llu, obj loaded: %s", GetEditorInstance()->m_RFrameInfo.m_nFrameNumber, getName().c_str() );
+}
+
+void CatObject::save( CatLevelFile::Writer& writer )
+{
+	if ( getType() >= ObjectType::eNotSaved )
+	{
+		return;
+	}
+
+	writer.addObject( getType(), getName(), getFileName(), m_vColor, m_transform.translation, m_transform.rotation,
+		m_transform.scale, m_fOpacity );
+}
+
+void CatObject::load( const CatLevelFile::Object& object )
+{
+	m_transform.translation = glm::make_vec3( object.aTranslation );
+	m_transform.rotation = glm::make_vec3( object.aRotation );
+	m_transform.scale = glm::make_vec3( object.aScale );
+	m_transform.markDirty();
+	m_vColor = glm::make_vec3( object.aColor );
+	m_fOpacity = 1.f - object.fTransparency;
+
+	LOG_F( INFO, "Frame: %llu, obj loaded: %s", GetEditorInstance()->m_RFrameInfo.m_nFrameNumber, getName().c_str() );
 }
 
 void CatObject::updateTransform( const glm::vec3& vTranslation, const glm::vec3& vRotation, const glm::vec3& vScale )
@@ -101,16 +115,19 @@ void CatObject::updateTransform( const glm::vec3& vTranslation, const glm::vec3&
 	m_transform.translation = vTranslation;
 	m_transform.rotation = vRotation;
 	m_transform.scale = vScale;
+	m_transform.markDirty();
 }
 
 void CatObject::updateTransform( const glm::vec3& vTranslation, const glm::vec3& vRotation )
 {
 	m_transform.translation = vTranslation;
 	m_transform.rotation = vRotation;
+	m_transform.markDirty();
 }
 
 void CatObject::updateTransform( const glm::vec3& vTranslation )
 {
 	m_transform.translation = vTranslation;
+	m_transform.markDirty();
 }
 } // namespace cat
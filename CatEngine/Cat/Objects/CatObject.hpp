@@ -3,38 +3,31 @@
 
 #include "CatModel.hpp"
 #include "CatObjectType.hpp"
+#include "CatTransform.hpp"
+#include "CatObjectPool.hpp"
+#include "Cat/Level/CatLevelFile.hpp"
 
 #include "glm/gtc/matrix_transform.hpp"
 
+#include <atomic>
 #include <memory>
 
 namespace cat
 {
-struct TransformComponent
-{
-	glm::vec3 translation{};
-	glm::vec3 rotation{};
-	glm::vec3 scale{ 1.f, 1.f, 1.f };
-
-	// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
-	// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
-	// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-	[[nodiscard]] glm::mat4 mat4() const;
-
-	[[nodiscard]] glm::mat3 normalMatrix() const;
-};
-
 class CatObject
 {
 public:
 	using Map = std::unordered_map< id_t, std::shared_ptr< CatObject > >;
 
 
-	[[nodiscard]] static std::unique_ptr< CatObject > create( const std::string& sName,
+	static constexpr const char* POOL_NAME = "CatObject";
+
+	// Allocated from the object pool of the type.
+	[[nodiscard]] static std::shared_ptr< CatObject > create( const std::string& sName,
 		const std::string& sFile,
 		const ObjectType& eType = ObjectType::eGameObject )
 	{
-		return std::unique_ptr< CatObject >( new CatObject( sName, sFile, eType ) );
+		return std::allocate_shared< CatObject >( CatPoolAllocator< CatObject >(), sName, sFile, eType );
 	}
 
 
@@ -47,6 +40,8 @@ public:
 
 	virtual json save();
 	virtual void load( const json& object );
+	virtual void save( CatLevelFile::Writer& writer );
+	virtual void load( const CatLevelFile::Object& object );
 
 	void updateTransform( const glm::vec3& vTranslation, const glm::vec3& vRotation, const glm::vec3& vScale );
 	void updateTransform( const glm::vec3& vTranslation, const glm::vec3& vRotation );
@@ -57,7 +52,15 @@ public:
 	[[nodiscard]] auto& getFileName() const { return m_sFile; }
 	[[nodiscard]] virtual const ObjectType& getType() const { return m_eType; }
 
+	// World space bounds of the model, recomputed when the transform or the model changed since the last call.
+	// Only valid if the object has a model.
+	[[nodiscard]] const CatModel::Bounds& getWorldBounds();
+
+	// Below 1 the object is drawn in the transparent pass, after the opaque ones.
+	[[nodiscard]] bool isTransparent() const { return m_fOpacity < 1.f; }
+
 	glm::vec3 m_vColor{};
+	float m_fOpacity = 1.f;
 	TransformComponent m_transform{};
 
 	std::shared_ptr< CatModel > m_pModel{};
@@ -65,8 +68,12 @@ public:
 	virtual ~CatObject() = default;
 
 protected:
+	template < typename, typename >
+	friend struct CatPoolAllocator;
+
 	[[nodiscard]] explicit CatObject( std::string sName, std::string sFile, const ObjectType& eType = ObjectType::eGameObject )
-		: m_id( M_ID_CURRENT++ ), m_sName( std::move( sName ) ), m_sFile( std::move( sFile ) ), m_eType( eType )
+		: m_id( M_ID_CURRENT.fetch_add( 1, std::memory_order_relaxed ) ), m_sName( std::move( sName ) ),
+		  m_sFile( std::move( sFile ) ), m_eType( eType )
 	{
 	}
 
@@ -74,10 +81,15 @@ protected:
 	std::string m_sName;
 	std::string m_sFile;
 	ObjectType m_eType;
-	bool m_bVisible;
+	bool m_bVisible = true;
+
+	CatModel::Bounds m_worldBounds{};
+	TransformComponent m_boundsTransform{};
+	const CatModel* m_pBoundsModel = nullptr;
 
 private:
-	static id_t M_ID_CURRENT;
+	// Objects are created on the loader threads.
+	static std::atomic< id_t > M_ID_CURRENT;
 
 public:
 	CAT_PROPERTY( m_bVisible, getVisible, setVisible, m_BVisible );
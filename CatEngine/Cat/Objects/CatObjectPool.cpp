@@ -0,0 +1,171 @@
+#include "CatObjectPool.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+
+namespace cat
+{
+namespace
+{
+size_t AlignUp( const size_t nValue, const size_t nAlignment )
+{
+	return ( nValue + nAlignment - 1 ) / nAlignment * nAlignment;
+}
+
+struct PoolRegistry
+{
+	std::mutex mutex;
+	std::vector< CatObjectPool* > aPools;
+};
+
+PoolRegistry& GetRegistry()
+{
+	static auto* pRegistry = new PoolRegistry();
+	return *pRegistry;
+}
+} // namespace
+
+CatObjectPool::CatObjectPool( const char* sName, const size_t nBlockSize, const size_t nAlignment )
+	: m_sName( sName ), m_nBlockSize( AlignUp( std::max( nBlockSize, sizeof( FreeBlock ) ), nAlignment ) ),
+	  m_nFirstBlock( AlignUp( sizeof( Slab ), nAlignment ) )
+{
+	CHECK_F( m_nFirstBlock + m_nBlockSize <= SLAB_SIZE, "pool block doesn't fit in a slab" );
+	m_nBlocksPerSlab = static_cast< uint32_t >( ( SLAB_SIZE - m_nFirstBlock ) / m_nBlockSize );
+
+	auto& registry = GetRegistry();
+	const std::lock_guard lock( registry.mutex );
+	registry.aPools.push_back( this );
+}
+
+CatObjectPool::~CatObjectPool()
+{
+	{
+		auto& registry = GetRegistry();
+		const std::lock_guard lock( registry.mutex );
+		std::erase( registry.aPools, this );
+	}
+	if ( m_nLive > 0 )
+	{
+		LOG_F( WARNING, "Pool %s destroyed with %u live objects", m_sName, m_nLive );
+	}
+	for ( auto* pSlab : m_aSlabs )
+	{
+		pSlab->~Slab();
+		::operator delete( pSlab, std::align_val_t( SLAB_SIZE ) );
+	}
+}
+
+CatObjectPool::Slab* CatObjectPool::getSlab( void* pBlock )
+{
+	return reinterpret_cast< Slab* >( reinterpret_cast< uintptr_t >( pBlock ) & ~uintptr_t( SLAB_SIZE - 1 ) );
+}
+
+void* CatObjectPool::allocate()
+{
+	const std::lock_guard lock( m_mutex );
+	while ( !m_aAvailable.empty() && !m_aAvailable.back()->pFree )
+	{
+		m_aAvailable.back()->bAvailable = false;
+		m_aAvailable.pop_back();
+	}
+
+	if ( m_aAvailable.empty() )
+	{
+		auto* pData = static_cast< std::byte* >( ::operator new( SLAB_SIZE, std::align_val_t( SLAB_SIZE ) ) );
+		auto* pSlab = new ( pData ) Slab{ .bAvailable = true };
+		// Threaded back to front, so the blocks are handed out in address order.
+		for ( uint32_t i = m_nBlocksPerSlab; i-- > 0; )
+		{
+			auto* pBlock = reinterpret_cast< FreeBlock* >( pData + m_nFirstBlock + i * m_nBlockSize );
+			pBlock->pNext = pSlab->pFree;
+			pSlab->pFree = pBlock;
+		}
+		m_aSlabs.push_back( pSlab );
+		m_aAvailable.push_back( pSlab );
+	}
+
+	auto* pSlab = m_aAvailable.back();
+	auto* pBlock = pSlab->pFree;
+	pSlab->pFree = pBlock->pNext;
+	pSlab->nLive++;
+
+	m_nPeak = std::max( m_nPeak, ++m_nLive );
+	m_nAllocations++;
+	return pBlock;
+}
+
+void CatObjectPool::deallocate( void* pBlock )
+{
+	const std::lock_guard lock( m_mutex );
+	auto* pSlab = getSlab( pBlock );
+	auto* pFree = static_cast< FreeBlock* >( pBlock );
+	pFree->pNext = pSlab->pFree;
+	pSlab->pFree = pFree;
+	pSlab->nLive--;
+	m_nLive--;
+
+	if ( !pSlab->bAvailable )
+	{
+		pSlab->bAvailable = true;
+		m_aAvailable.push_back( pSlab );
+	}
+}
+
+uint32_t CatObjectPool::trim()
+{
+	const std::lock_guard lock( m_mutex );
+	const auto isEmpty = []( const Slab* pSlab ) { return pSlab->nLive == 0; };
+	std::erase_if( m_aAvailable, isEmpty );
+
+	uint32_t nReleased = 0;
+	std::erase_if( m_aSlabs,
+		[&]( Slab* pSlab )
+		{
+			if ( !isEmpty( pSlab ) ) return false;
+			pSlab->~Slab();
+			::operator delete( pSlab, std::align_val_t( SLAB_SIZE ) );
+			++nReleased;
+			return true;
+		} );
+	return nReleased;
+}
+
+CatObjectPool::Stats CatObjectPool::getStats() const
+{
+	const std::lock_guard lock( m_mutex );
+	return {
+		.sName = m_sName,
+		.nBlockSize = m_nBlockSize,
+		.nSlabs = static_cast< uint32_t >( m_aSlabs.size() ),
+		.nLive = m_nLive,
+		.nPeak = m_nPeak,
+		.nAllocations = m_nAllocations,
+	};
+}
+
+uint32_t CatObjectPool::TrimAll()
+{
+	auto& registry = GetRegistry();
+	const std::lock_guard lock( registry.mutex );
+	uint32_t nReleased = 0;
+	for ( auto* pPool : registry.aPools )
+	{
+		nReleased += pPool->trim();
+	}
+	return nReleased;
+}
+
+std::vector< CatObjectPool::Stats > CatObjectPool::GetAllStats()
+{
+	auto& registry = GetRegistry();
+	const std::lock_guard lock( registry.mutex );
+	std::vector< Stats > aStats;
+	aStats.reserve( registry.aPools.size() );
+	for ( const auto* pPool : registry.aPools )
+	{
+		aStats.push_back( pPool->getStats() );
+	}
+	return aStats;
+}
+} // namespace cat
@@ -0,0 +1,141 @@
+#ifndef CATENGINE_CATOBJECTPOOL_HPP
+#define CATENGINE_CATOBJECTPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cat
+{
+// Hands out fixed size blocks from 64 KiB slabs, so objects of a type end up next to each other instead of all over the
+// heap. Thread safe, the objects are created on the loader threads and released on the main thread.
+class CatObjectPool
+{
+public:
+	static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+	struct Stats
+	{
+		const char* sName = nullptr;
+		size_t nBlockSize = 0;
+		uint32_t nSlabs = 0;
+		uint32_t nLive = 0;
+		uint32_t nPeak = 0;
+		uint64_t nAllocations = 0;
+	};
+
+	CatObjectPool( const char* sName, size_t nBlockSize, size_t nAlignment );
+	~CatObjectPool();
+
+	CatObjectPool( const CatObjectPool& ) = delete;
+	CatObjectPool& operator=( const CatObjectPool& ) = delete;
+
+	[[nodiscard]] void* allocate();
+	void deallocate( void* pBlock );
+	// Releases the slabs without live blocks, returns how many.
+	uint32_t trim();
+
+	[[nodiscard]] Stats getStats() const;
+
+	// Called after unloading a level or evicting chunks.
+	static uint32_t TrimAll();
+	[[nodiscard]] static std::vector< Stats > GetAllStats();
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* pNext;
+	};
+
+	// At the start of every slab, the slabs are aligned to their size so a block finds its slab by masking the address.
+	struct Slab
+	{
+		FreeBlock* pFree = nullptr;
+		uint32_t nLive = 0;
+		bool bAvailable = false;
+	};
+
+	static Slab* getSlab( void* pBlock );
+
+	const char* m_sName;
+	size_t m_nBlockSize;
+	size_t m_nFirstBlock;
+	uint32_t m_nBlocksPerSlab;
+
+	mutable std::mutex m_mutex;
+	std::vector< Slab* > m_aSlabs;
+	// Slabs that had a free block when they were pushed, the ones that filled up since are skipped lazily.
+	std::vector< Slab* > m_aAvailable;
+	uint32_t m_nLive = 0;
+	uint32_t m_nPeak = 0;
+	uint64_t m_nAllocations = 0;
+};
+
+// Allocates the objects and their shared_ptr control block with std::allocate_shared from one pool per object type.
+// Friend of the object types, so their protected constructors stay behind create(). The pool is named by the type's
+// POOL_NAME, derived types have to declare their own.
+template < typename T, typename TObject = T >
+struct CatPoolAllocator
+{
+	using value_type = T;
+
+	template < typename U >
+	struct rebind
+	{
+		using other = CatPoolAllocator< U, TObject >;
+	};
+
+	CatPoolAllocator() = default;
+	template < typename U >
+	CatPoolAllocator( const CatPoolAllocator< U, TObject >& ) // NOLINT(google-explicit-constructor)
+	{
+	}
+
+	[[nodiscard]] T* allocate( const size_t nCount )
+	{
+		if ( nCount != 1 ) return static_cast< T* >( ::operator new( nCount * sizeof( T ), std::align_val_t( alignof( T ) ) ) );
+		return static_cast< T* >( GetPool().allocate() );
+	}
+
+	void deallocate( T* p, const size_t nCount )
+	{
+		if ( nCount != 1 )
+		{
+			::operator delete( p, std::align_val_t( alignof( T ) ) );
+			return;
+		}
+		GetPool().deallocate( p );
+	}
+
+	template < typename U, typename... TArgs >
+	void construct( U* p, TArgs&&... args )
+	{
+		::new ( static_cast< void* >( p ) ) U( std::forward< TArgs >( args )... );
+	}
+
+	template < typename U >
+	void destroy( U* p )
+	{
+		p->~U();
+	}
+
+	// The blocks are the size of whatever allocate_shared rebinds to.
+	// Never destroyed, objects owned by other statics are released after the static destructors ran.
+	static CatObjectPool& GetPool()
+	{
+		static auto* pPool = new CatObjectPool( TObject::POOL_NAME, sizeof( T ), alignof( T ) );
+		return *pPool;
+	}
+
+	template < typename U >
+	bool operator==( const CatPoolAllocator< U, TObject >& ) const
+	{
+		return true;
+	}
+};
+} // namespace cat
+
+#endif // CATENGINE_CATOBJECTPOOL_HPP
@@ -0,0 +1,552 @@
+#include "CatTransform.hpp"
+
+#include <BS_thread_pool.hpp>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <bit>
+#include <cmath>
+#include <utility>
+
+namespace cat
+{
+namespace
+{
+constexpr float DEGREES_TO_RADIANS = 0.01745329251994329577f;
+
+// The rotation part of Translate * Ry * Rx * Rz * Scale, columns 0 to 2 are multiplied by the scale for the world matrix
+// and divided by it for the normal matrix. (c1, s1) is the Y angle, (c2, s2) the X angle and (c3, s3) the Z angle.
+// Same as the inverse transpose, the rotation part is orthonormal.
+void BuildRotation( const float c1,
+	const float s1,
+	const float c2,
+	const float s2,
+	const float c3,
+	const float s3,
+	float aRotation[3][3] )
+{
+	aRotation[0][0] = c1 * c3 + s1 * s2 * s3;
+	aRotation[0][1] = c2 * s3;
+	aRotation[0][2] = c1 * s2 * s3 - c3 * s1;
+	aRotation[1][0] = c3 * s1 * s2 - c1 * s3;
+	aRotation[1][1] = c2 * c3;
+	aRotation[1][2] = c1 * c3 * s2 + s1 * s3;
+	aRotation[2][0] = c2 * s1;
+	aRotation[2][1] = -s2;
+	aRotation[2][2] = c1 * c2;
+}
+
+#ifdef CAT_SIMD_X86
+// Cody-Waite reduction to [-pi/4, pi/4] with pi/2 split in three, then the sinf and cosf minimax polynomials of Cephes.
+// Accurate to a few ulp for the angles an editor produces.
+constexpr float TWO_OVER_PI = 0.63661977236758134308f;
+constexpr float HALF_PI_1 = 1.5703125f;
+constexpr float HALF_PI_2 = 4.837512969970703125e-4f;
+constexpr float HALF_PI_3 = 7.54978995489188216e-8f;
+constexpr float SIN_1 = -1.6666654611e-1f;
+constexpr float SIN_2 = 8.3321608736e-3f;
+constexpr float SIN_3 = -1.9515295891e-4f;
+constexpr float COS_1 = 4.166664568298827e-2f;
+constexpr float COS_2 = -1.388731625493765e-3f;
+constexpr float COS_3 = 2.443315711809948e-5f;
+
+void SinCosSSE( const __m128 x, __m128& s, __m128& c )
+{
+	const __m128i q = _mm_cvtps_epi32( _mm_mul_ps( x, _mm_set1_ps( TWO_OVER_PI ) ) );
+	const __m128 qf = _mm_cvtepi32_ps( q );
+	__m128 r = _mm_sub_ps( x, _mm_mul_ps( qf, _mm_set1_ps( HALF_PI_1 ) ) );
+	r = _mm_sub_ps( r, _mm_mul_ps( qf, _mm_set1_ps( HALF_PI_2 ) ) );
+	r = _mm_sub_ps( r, _mm_mul_ps( qf, _mm_set1_ps( HALF_PI_3 ) ) );
+	const __m128 z = _mm_mul_ps( r, r );
+
+	__m128 sinR = _mm_add_ps( _mm_mul_ps( z, _mm_set1_ps( SIN_3 ) ), _mm_set1_ps( SIN_2 ) );
+	sinR = _mm_add_ps( _mm_mul_ps( sinR, z ), _mm_set1_ps( SIN_1 ) );
+	sinR = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( sinR, z ), r ), r );
+	__m128 cosR = _mm_add_ps( _mm_mul_ps( z, _mm_set1_ps( COS_3 ) ), _mm_set1_ps( COS_2 ) );
+	cosR = _mm_add_ps( _mm_mul_ps( cosR, z ), _mm_set1_ps( COS_1 ) );
+	cosR = _mm_add_ps(
+		_mm_mul_ps( _mm_mul_ps( cosR, z ), z ), _mm_sub_ps( _mm_set1_ps( 1.0f ), _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) ) );
+
+	// Odd quadrants swap sine and cosine, the sign bits come from the quadrant's second bit.
+	const __m128 swap = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( q, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( 1 ) ) );
+	const __m128 sinSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( q, _mm_set1_epi32( 2 ) ), 30 ) );
+	const __m128 cosSign =
+		_mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( _mm_add_epi32( q, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( 2 ) ), 30 ) );
+	s = _mm_xor_ps( _mm_or_ps( _mm_and_ps( swap, cosR ), _mm_andnot_ps( swap, sinR ) ), sinSign );
+	c = _mm_xor_ps( _mm_or_ps( _mm_and_ps( swap, sinR ), _mm_andnot_ps( swap, cosR ) ), cosSign );
+}
+
+CAT_TARGET_AVX2 void SinCosAVX2( const __m256 x, __m256& s, __m256& c )
+{
+	const __m256i q = _mm256_cvtps_epi32( _mm256_mul_ps( x, _mm256_set1_ps( TWO_OVER_PI ) ) );
+	const __m256 qf = _mm256_cvtepi32_ps( q );
+	__m256 r = _mm256_sub_ps( x, _mm256_mul_ps( qf, _mm256_set1_ps( HALF_PI_1 ) ) );
+	r = _mm256_sub_ps( r, _mm256_mul_ps( qf, _mm256_set1_ps( HALF_PI_2 ) ) );
+	r = _mm256_sub_ps( r, _mm256_mul_ps( qf, _mm256_set1_ps( HALF_PI_3 ) ) );
+	const __m256 z = _mm256_mul_ps( r, r );
+
+	__m256 sinR = _mm256_add_ps( _mm256_mul_ps( z, _mm256_set1_ps( SIN_3 ) ), _mm256_set1_ps( SIN_2 ) );
+	sinR = _mm256_add_ps( _mm256_mul_ps( sinR, z ), _mm256_set1_ps( SIN_1 ) );
+	sinR = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( sinR, z ), r ), r );
+	__m256 cosR = _mm256_add_ps( _mm256_mul_ps( z, _mm256_set1_ps( COS_3 ) ), _mm256_set1_ps( COS_2 ) );
+	cosR = _mm256_add_ps( _mm256_mul_ps( cosR, z ), _mm256_set1_ps( COS_1 ) );
+	cosR = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( cosR, z ), z ),
+		_mm256_sub_ps( _mm256_set1_ps( 1.0f ), _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) ) );
+
+	const __m256 swap =
+		_mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_and_si256( q, _mm256_set1_epi32( 1 ) ), _mm256_set1_epi32( 1 ) ) );
+	const __m256 sinSign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_and_si256( q, _mm256_set1_epi32( 2 ) ), 30 ) );
+	const __m256 cosSign = _mm256_castsi256_ps(
+		_mm256_slli_epi32( _mm256_and_si256( _mm256_add_epi32( q, _mm256_set1_epi32( 1 ) ), _mm256_set1_epi32( 2 ) ), 30 ) );
+	s = _mm256_xor_ps( _mm256_blendv_ps( sinR, cosR, swap ), sinSign );
+	c = _mm256_xor_ps( _mm256_blendv_ps( cosR, sinR, swap ), cosSign );
+}
+
+void StoreVec3( float* pDst, const __m128 v )
+{
+	_mm_storel_pi( reinterpret_cast< __m64* >( pDst ), v );
+	_mm_store_ss( pDst + 2, _mm_movehl_ps( v, v ) );
+}
+
+// Lane i of the inputs belongs to the transform i, the columns are transposed into the matrices of four transforms.
+void StoreMatrices( const __m128 aWorld[3][3],
+	const __m128 aNormal[3][3],
+	const __m128 aTranslation[3],
+	glm::mat4* pWorld,
+	glm::mat3* pNormal )
+{
+	const __m128 zero = _mm_setzero_ps();
+	for ( int nColumn = 0; nColumn < 3; ++nColumn )
+	{
+		__m128 a = aWorld[nColumn][0];
+		__m128 b = aWorld[nColumn][1];
+		__m128 c = aWorld[nColumn][2];
+		__m128 d = zero;
+		_MM_TRANSPOSE4_PS( a, b, c, d );
+		_mm_storeu_ps( &pWorld[0][nColumn].x, a );
+		_mm_storeu_ps( &pWorld[1][nColumn].x, b );
+		_mm_storeu_ps( &pWorld[2][nColumn].x, c );
+		_mm_storeu_ps( &pWorld[3][nColumn].x, d );
+
+		a = aNormal[nColumn][0];
+		b = aNormal[nColumn][1];
+		c = aNormal[nColumn][2];
+		d = zero;
+		_MM_TRANSPOSE4_PS( a, b, c, d );
+		StoreVec3( &pNormal[0][nColumn].x, a );
+		StoreVec3( &pNormal[1][nColumn].x, b );
+		StoreVec3( &pNormal[2][nColumn].x, c );
+		StoreVec3( &pNormal[3][nColumn].x, d );
+	}
+	__m128 a = aTranslation[0];
+	__m128 b = aTranslation[1];
+	__m128 c = aTranslation[2];
+	__m128 d = _mm_set1_ps( 1.0f );
+	_MM_TRANSPOSE4_PS( a, b, c, d );
+	_mm_storeu_ps( &pWorld[0][3].x, a );
+	_mm_storeu_ps( &pWorld[1][3].x, b );
+	_mm_storeu_ps( &pWorld[2][3].x, c );
+	_mm_storeu_ps( &pWorld[3][3].x, d );
+}
+
+// Four transforms starting at nSlot.
+void BuildMatricesSSE( const float* const aComponents[9], const size_t nSlot, glm::mat4* pWorld, glm::mat3* pNormal )
+{
+	__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+	const __m128 toRadians = _mm_set1_ps( DEGREES_TO_RADIANS );
+	SinCosSSE( _mm_mul_ps( _mm_loadu_ps( aComponents[3] + nSlot ), toRadians ), sinX, cosX );
+	SinCosSSE( _mm_mul_ps( _mm_loadu_ps( aComponents[4] + nSlot ), toRadians ), sinY, cosY );
+	SinCosSSE( _mm_mul_ps( _mm_loadu_ps( aComponents[5] + nSlot ), toRadians ), sinZ, cosZ );
+
+	// Same products as BuildRotation.
+	__m128 aRotation[3][3];
+	const __m128 s2s3 = _mm_mul_ps( sinX, sinZ );
+	const __m128 s2c3 = _mm_mul_ps( sinX, cosZ );
+	aRotation[0][0] = _mm_add_ps( _mm_mul_ps( cosY, cosZ ), _mm_mul_ps( sinY, s2s3 ) );
+	aRotation[0][1] = _mm_mul_ps( cosX, sinZ );
+	aRotation[0][2] = _mm_sub_ps( _mm_mul_ps( cosY, s2s3 ), _mm_mul_ps( cosZ, sinY ) );
+	aRotation[1][0] = _mm_sub_ps( _mm_mul_ps( sinY, s2c3 ), _mm_mul_ps( cosY, sinZ ) );
+	aRotation[1][1] = _mm_mul_ps( cosX, cosZ );
+	aRotation[1][2] = _mm_add_ps( _mm_mul_ps( cosY, s2c3 ), _mm_mul_ps( sinY, sinZ ) );
+	aRotation[2][0] = _mm_mul_ps( cosX, sinY );
+	aRotation[2][1] = _mm_sub_ps( _mm_setzero_ps(), sinX );
+	aRotation[2][2] = _mm_mul_ps( cosY, cosX );
+
+	__m128 aWorld[3][3], aNormal[3][3];
+	for ( int nColumn = 0; nColumn < 3; ++nColumn )
+	{
+		const __m128 scale = _mm_loadu_ps( aComponents[6 + nColumn] + nSlot );
+		const __m128 inverseScale = _mm_div_ps( _mm_set1_ps( 1.0f ), scale );
+		for ( int nRow = 0; nRow < 3; ++nRow )
+		{
+			aWorld[nColumn][nRow] = _mm_mul_ps( aRotation[nColumn][nRow], scale );
+			aNormal[nColumn][nRow] = _mm_mul_ps( aRotation[nColumn][nRow], inverseScale );
+		}
+	}
+	const __m128 aTranslation[3] = { _mm_loadu_ps( aComponents[0] + nSlot ), _mm_loadu_ps( aComponents[1] + nSlot ),
+		_mm_loadu_ps( aComponents[2] + nSlot ) };
+	StoreMatrices( aWorld, aNormal, aTranslation, pWorld + nSlot, pNormal + nSlot );
+}
+
+// Eight transforms starting at nSlot, the halves are stored like the SSE version.
+CAT_TARGET_AVX2 void BuildMatricesAVX2( const float* const aComponents[9],
+	const size_t nSlot,
+	glm::mat4* pWorld,
+	glm::mat3* pNormal )
+{
+	__m256 sinX, cosX, sinY, cosY, sinZ, cosZ;
+	const __m256 toRadians = _mm256_set1_ps( DEGREES_TO_RADIANS );
+	SinCosAVX2( _mm256_mul_ps( _mm256_loadu_ps( aComponents[3] + nSlot ), toRadians ), sinX, cosX );
+	SinCosAVX2( _mm256_mul_ps( _mm256_loadu_ps( aComponents[4] + nSlot ), toRadians ), sinY, cosY );
+	SinCosAVX2( _mm256_mul_ps( _mm256_loadu_ps( aComponents[5] + nSlot ), toRadians ), sinZ, cosZ );
+
+	__m256 aRotation[3][3];
+	const __m256 s2s3 = _mm256_mul_ps( sinX, sinZ );
+	const __m256 s2c3 = _mm256_mul_ps( sinX, cosZ );
+	aRotation[0][0] = _mm256_add_ps( _mm256_mul_ps( cosY, cosZ ), _mm256_mul_ps( sinY, s2s3 ) );
+	aRotation[0][1] = _mm256_mul_ps( cosX, sinZ );
+	aRotation[0][2] = _mm256_sub_ps( _mm256_mul_ps( cosY, s2s3 ), _mm256_mul_ps( cosZ, sinY ) );
+	aRotation[1][0] = _mm256_sub_ps( _mm256_mul_ps( sinY, s2c3 ), _mm256_mul_ps( cosY, sinZ ) );
+	aRotation[1][1] = _mm256_mul_ps( cosX, cosZ );
+	aRotation[1][2] = _mm256_add_ps( _mm256_mul_ps( cosY, s2c3 ), _mm256_mul_ps( sinY, sinZ ) );
+	aRotation[2][0] = _mm256_mul_ps( cosX, sinY );
+	aRotation[2][1] = _mm256_sub_ps( _mm256_setzero_ps(), sinX );
+	aRotation[2][2] = _mm256_mul_ps( cosY, cosX );
+
+	__m128 aWorld[2][3][3], aNormal[2][3][3];
+	for ( int nColumn = 0; nColumn < 3; ++nColumn )
+	{
+		const __m256 scale = _mm256_loadu_ps( aComponents[6 + nColumn] + nSlot );
+		const __m256 inverseScale = _mm256_div_ps( _mm256_set1_ps( 1.0f ), scale );
+		for ( int nRow = 0; nRow < 3; ++nRow )
+		{
+			const __m256 world = _mm256_mul_ps( aRotation[nColumn][nRow], scale );
+			const __m256 normal = _mm256_mul_ps( aRotation[nColumn][nRow], inverseScale );
+			aWorld[0][nColumn][nRow] = _mm256_castps256_ps128( world );
+			aWorld[1][nColumn][nRow] = _mm256_extractf128_ps( world, 1 );
+			aNormal[0][nColumn][nRow] = _mm256_castps256_ps128( normal );
+			aNormal[1][nColumn][nRow] = _mm256_extractf128_ps( normal, 1 );
+		}
+	}
+	// The stores are SSE code, mixing it with dirty upper halves would stall on every switch.
+	_mm256_zeroupper();
+	for ( int nHalf = 0; nHalf < 2; ++nHalf )
+	{
+		const size_t nFirst = nSlot + nHalf * 4;
+		const __m128 aTranslation[3] = { _mm_loadu_ps( aComponents[0] + nFirst ), _mm_loadu_ps( aComponents[1] + nFirst ),
+			_mm_loadu_ps( aComponents[2] + nFirst ) };
+		StoreMatrices( aWorld[nHalf], aNormal[nHalf], aTranslation, pWorld + nFirst, pNormal + nFirst );
+	}
+}
+#endif // CAT_SIMD_X86
+} // namespace
+
+TransformComponent::TransformComponent( const TransformComponent& other )
+	: translation( other.translation ), rotation( other.rotation ), scale( other.scale )
+{
+}
+
+TransformComponent& TransformComponent::operator=( const TransformComponent& other )
+{
+	if ( this == &other ) return *this;
+
+	translation = other.translation;
+	rotation = other.rotation;
+	scale = other.scale;
+	markDirty();
+	return *this;
+}
+
+TransformComponent::TransformComponent( TransformComponent&& other ) noexcept
+{
+	*this = std::move( other );
+}
+
+TransformComponent& TransformComponent::operator=( TransformComponent&& other ) noexcept
+{
+	if ( this == &other ) return *this;
+
+	// Like a copy, a registered transform keeps its own slot.
+	if ( m_pSystem )
+	{
+		return *this = other;
+	}
+	translation = other.translation;
+	rotation = other.rotation;
+	scale = other.scale;
+	m_bDirty = true;
+
+	// The slot stays the same, only its owner changes.
+	if ( other.m_pSystem )
+	{
+		m_pSystem = std::exchange( other.m_pSystem, nullptr );
+		m_nHandle = other.m_nHandle;
+		m_pSystem->m_aBlocks[m_nHandle / CatTransformSystem::BLOCK_SIZE]->aOwners[m_nHandle % CatTransformSystem::BLOCK_SIZE] =
+			this;
+		m_pSystem->set( *this );
+	}
+	return *this;
+}
+
+TransformComponent::~TransformComponent()
+{
+	if ( m_pSystem )
+	{
+		m_pSystem->remove( *this );
+	}
+}
+
+void TransformComponent::markDirty()
+{
+	m_bDirty = true;
+	if ( m_pSystem )
+	{
+		m_pSystem->set( *this );
+	}
+}
+
+bool TransformComponent::isDirty() const
+{
+	return m_pSystem ? m_pSystem->isDirty( m_nHandle ) : m_bDirty;
+}
+
+void TransformComponent::update() const
+{
+	if ( !m_bDirty ) return;
+
+	const auto rotationRad = glm::radians( rotation );
+
+	m_mxWorld = glm::translate( glm::mat4( 1.0f ), translation );
+	m_mxWorld = glm::rotate( m_mxWorld, rotationRad.y, { 0.f, 1.f, 0.f } );
+	m_mxWorld = glm::rotate( m_mxWorld, rotationRad.x, { 1.f, 0.f, 0.f } );
+	m_mxWorld = glm::rotate( m_mxWorld, rotationRad.z, { 0.f, 0.f, 1.f } );
+	m_mxWorld = glm::scale( m_mxWorld, scale );
+
+	// The translation doesn't affect the normals, the inverse of the upper 3x3 is enough.
+	m_mxNormal = glm::inverseTranspose( glm::mat3( m_mxWorld ) );
+	m_bDirty = false;
+}
+
+const glm::mat4& TransformComponent::mat4() const
+{
+	if ( m_pSystem ) return m_pSystem->getWorldMatrix( m_nHandle );
+
+	update();
+	return m_mxWorld;
+}
+
+const glm::mat3& TransformComponent::normalMatrix() const
+{
+	if ( m_pSystem ) return m_pSystem->getNormalMatrix( m_nHandle );
+
+	update();
+	return m_mxNormal;
+}
+
+CatTransformSystem::~CatTransformSystem()
+{
+	// Transforms outliving the system fall back to their own cache.
+	for ( const auto& pBlock : m_aBlocks )
+	{
+		for ( auto* pOwner : pBlock->aOwners )
+		{
+			if ( !pOwner ) continue;
+
+			pOwner->m_pSystem = nullptr;
+			pOwner->m_bDirty = true;
+		}
+	}
+}
+
+void CatTransformSystem::add( TransformComponent& transform )
+{
+	if ( transform.m_pSystem == this ) return;
+	if ( transform.m_pSystem )
+	{
+		transform.m_pSystem->remove( transform );
+	}
+
+	if ( m_aFreeHandles.empty() )
+	{
+		// Handed out from the front of the block, the free list is a stack.
+		const auto nFirst = static_cast< uint32_t >( m_aBlocks.size() ) * BLOCK_SIZE;
+		m_aBlocks.push_back( std::make_unique< Block >() );
+		auto& block = *m_aBlocks.back();
+		block.aScaleX.fill( 1.0f );
+		block.aScaleY.fill( 1.0f );
+		block.aScaleZ.fill( 1.0f );
+		for ( uint32_t i = BLOCK_SIZE; i > 0; --i )
+		{
+			m_aFreeHandles.push_back( nFirst + i - 1 );
+		}
+	}
+
+	transform.m_pSystem = this;
+	transform.m_nHandle = m_aFreeHandles.back();
+	m_aFreeHandles.pop_back();
+	m_aBlocks[transform.m_nHandle / BLOCK_SIZE]->aOwners[transform.m_nHandle % BLOCK_SIZE] = &transform;
+	set( transform );
+
+	m_stats.nTransforms++;
+	m_stats.nBlocks = static_cast< uint32_t >( m_aBlocks.size() );
+}
+
+void CatTransformSystem::remove( TransformComponent& transform )
+{
+	if ( transform.m_pSystem != this ) return;
+
+	const auto nSlot = transform.m_nHandle % BLOCK_SIZE;
+	auto& block = *m_aBlocks[transform.m_nHandle / BLOCK_SIZE];
+	block.aOwners[nSlot] = nullptr;
+	block.aDirty[nSlot / 64] &= ~( uint64_t( 1 ) << ( nSlot % 64 ) );
+	// Free slots are rebuilt along with their neighbours, an identity transform keeps them finite.
+	block.aScaleX[nSlot] = block.aScaleY[nSlot] = block.aScaleZ[nSlot] = 1.0f;
+
+	m_aFreeHandles.push_back( transform.m_nHandle );
+	transform.m_pSystem = nullptr;
+	transform.m_bDirty = true;
+	m_stats.nTransforms--;
+}
+
+void CatTransformSystem::set( const TransformComponent& transform )
+{
+	const auto nSlot = transform.m_nHandle % BLOCK_SIZE;
+	auto& block = *m_aBlocks[transform.m_nHandle / BLOCK_SIZE];
+	block.aTranslationX[nSlot] = transform.translation.x;
+	block.aTranslationY[nSlot] = transform.translation.y;
+	block.aTranslationZ[nSlot] = transform.translation.z;
+	block.aRotationX[nSlot] = transform.rotation.x;
+	block.aRotationY[nSlot] = transform.rotation.y;
+	block.aRotationZ[nSlot] = transform.rotation.z;
+	block.aScaleX[nSlot] = transform.scale.x;
+	block.aScaleY[nSlot] = transform.scale.y;
+	block.aScaleZ[nSlot] = transform.scale.z;
+	block.aDirty[nSlot / 64] |= uint64_t( 1 ) << ( nSlot % 64 );
+}
+
+bool CatTransformSystem::isDirty( const uint32_t nHandle ) const
+{
+	const auto nSlot = nHandle % BLOCK_SIZE;
+	return ( m_aBlocks[nHandle / BLOCK_SIZE]->aDirty[nSlot / 64] >> ( nSlot % 64 ) ) & 1;
+}
+
+const glm::mat4& CatTransformSystem::getWorldMatrix( const uint32_t nHandle )
+{
+	auto& block = *m_aBlocks[nHandle / BLOCK_SIZE];
+	if ( isDirty( nHandle ) )
+	{
+		rebuildSlot( block, nHandle % BLOCK_SIZE );
+	}
+	return block.aWorld[nHandle % BLOCK_SIZE];
+}
+
+const glm::mat3& CatTransformSystem::getNormalMatrix( const uint32_t nHandle )
+{
+	auto& block = *m_aBlocks[nHandle / BLOCK_SIZE];
+	if ( isDirty( nHandle ) )
+	{
+		rebuildSlot( block, nHandle % BLOCK_SIZE );
+	}
+	return block.aNormal[nHandle % BLOCK_SIZE];
+}
+
+void CatTransformSystem::rebuildSlot( Block& block, const uint32_t nSlot ) const
+{
+	const auto vRotation =
+		glm::vec3( block.aRotationX[nSlot], block.aRotationY[nSlot], block.aRotationZ[nSlot] ) * DEGREES_TO_RADIANS;
+	const float aScale[3] = { block.aScaleX[nSlot], block.aScaleY[nSlot], block.aScaleZ[nSlot] };
+
+	float aRotation[3][3];
+	BuildRotation( std::cos( vRotation.y ), std::sin( vRotation.y ), std::cos( vRotation.x ), std::sin( vRotation.x ),
+		std::cos( vRotation.z ), std::sin( vRotation.z ), aRotation );
+
+	auto& mxWorld = block.aWorld[nSlot];
+	auto& mxNormal = block.aNormal[nSlot];
+	for ( int nColumn = 0; nColumn < 3; ++nColumn )
+	{
+		for ( int nRow = 0; nRow < 3; ++nRow )
+		{
+			mxWorld[nColumn][nRow] = aRotation[nColumn][nRow] * aScale[nColumn];
+			mxNormal[nColumn][nRow] = aRotation[nColumn][nRow] / aScale[nColumn];
+		}
+		mxWorld[nColumn][3] = 0.0f;
+	}
+	mxWorld[3] = glm::vec4( block.aTranslationX[nSlot], block.aTranslationY[nSlot], block.aTranslationZ[nSlot], 1.0f );
+
+	block.aDirty[nSlot / 64] &= ~( uint64_t( 1 ) << ( nSlot % 64 ) );
+}
+
+void CatTransformSystem::rebuildBlock( Block& block ) const
+{
+	const uint32_t nLanes = m_eSimdLevel == SimdLevel::eAVX2 ? 8 : m_eSimdLevel == SimdLevel::eSSE ? 4 : 1;
+#ifdef CAT_SIMD_X86
+	const float* const aComponents[9] = { block.aTranslationX.data(), block.aTranslationY.data(), block.aTranslationZ.data(),
+		block.aRotationX.data(), block.aRotationY.data(), block.aRotationZ.data(), block.aScaleX.data(), block.aScaleY.data(),
+		block.aScaleZ.data() };
+#endif
+
+	for ( uint32_t nWord = 0; nWord < block.aDirty.size(); ++nWord )
+	{
+		auto& nDirty = block.aDirty[nWord];
+		while ( nDirty != 0 )
+		{
+			// The whole group of lanes around the lowest dirty slot, its clean slots come out the same.
+			const auto nBit = static_cast< uint32_t >( std::countr_zero( nDirty ) ) / nLanes * nLanes;
+			const auto nSlot = nWord * 64 + nBit;
+#ifdef CAT_SIMD_X86
+			switch ( m_eSimdLevel )
+			{
+				case SimdLevel::eAVX2:
+					BuildMatricesAVX2( aComponents, nSlot, block.aWorld.data(), block.aNormal.data() );
+					break;
+				case SimdLevel::eSSE: BuildMatricesSSE( aComponents, nSlot, block.aWorld.data(), block.aNormal.data() ); break;
+				case SimdLevel::eScalar: rebuildSlot( block, nSlot ); break;
+			}
+#else
+			rebuildSlot( block, nSlot );
+#endif
+			nDirty &= ~( ( ( uint64_t( 1 ) << nLanes ) - 1 ) << nBit );
+		}
+	}
+}
+
+void CatTransformSystem::update( BS::thread_pool* pPool )
+{
+	m_stats.nRebuilt = 0;
+	m_aDirtyBlocks.clear();
+	for ( const auto& pBlock : m_aBlocks )
+	{
+		uint32_t nDirty = 0;
+		for ( const auto nWord : pBlock->aDirty )
+		{
+			nDirty += static_cast< uint32_t >( std::popcount( nWord ) );
+		}
+		if ( nDirty == 0 ) continue;
+
+		m_stats.nRebuilt += nDirty;
+		m_aDirtyBlocks.push_back( pBlock.get() );
+	}
+
+	if ( pPool && m_aDirtyBlocks.size() >= PARALLEL_BLOCKS )
+	{
+		// Blocks don't share anything, every thread takes a range of them.
+		pPool
+			->parallelize_loop( m_aDirtyBlocks.size(),
+				[this]( const size_t nBegin, const size_t nEnd )
+				{
+					for ( size_t i = nBegin; i < nEnd; ++i )
+					{
+						rebuildBlock( *m_aDirtyBlocks[i] );
+					}
+				} )
+			.wait();
+		return;
+	}
+
+	for ( auto* pBlock : m_aDirtyBlocks )
+	{
+		rebuildBlock( *pBlock );
+	}
+}
+} // namespace cat
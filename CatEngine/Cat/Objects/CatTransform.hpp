@@ -0,0 +1,148 @@
+#ifndef CATENGINE_CATTRANSFORM_HPP
+#define CATENGINE_CATTRANSFORM_HPP
+
+#include "Cat/Utils/CatSimd.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace BS
+{
+class thread_pool;
+}
+
+namespace cat
+{
+class CatTransformSystem;
+
+struct TransformComponent
+{
+	glm::vec3 translation{};
+	glm::vec3 rotation{};
+	glm::vec3 scale{ 1.f, 1.f, 1.f };
+
+	TransformComponent() = default;
+	// Copies only take the components. Assigning to a registered transform keeps its slot in the CatTransformSystem, moving
+	// into an unregistered one takes over the slot of the source.
+	TransformComponent( const TransformComponent& other );
+	TransformComponent& operator=( const TransformComponent& other );
+	TransformComponent( TransformComponent&& other ) noexcept;
+	TransformComponent& operator=( TransformComponent&& other ) noexcept;
+	~TransformComponent();
+
+	// The matrices are cached, this has to be called after changing the translation, rotation or scale.
+	void markDirty();
+	[[nodiscard]] bool isDirty() const;
+
+	// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
+	// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
+	// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+	[[nodiscard]] const glm::mat4& mat4() const;
+
+	[[nodiscard]] const glm::mat3& normalMatrix() const;
+
+	// Registered transforms keep their matrices in the system instead of the cache below.
+	[[nodiscard]] bool isRegistered() const { return m_pSystem != nullptr; }
+
+	bool operator==( const TransformComponent& other ) const
+	{
+		return translation == other.translation && rotation == other.rotation && scale == other.scale;
+	}
+
+private:
+	friend class CatTransformSystem;
+
+	// Rebuilds both matrices if the transform was marked dirty since the last call.
+	void update() const;
+
+	mutable glm::mat4 m_mxWorld{ 1.f };
+	mutable glm::mat3 m_mxNormal{ 1.f };
+	mutable bool m_bDirty = true;
+
+	CatTransformSystem* m_pSystem = nullptr;
+	uint32_t m_nHandle = 0;
+};
+
+// Stores the components and matrices of the registered transforms in fixed size SoA blocks.
+// Marking a transform dirty copies its components into its block, update() then rebuilds the dirty matrices of a block
+// four or eight at a time with SSE or AVX2, so transforms that don't change cost nothing per frame.
+class CatTransformSystem
+{
+public:
+	static constexpr uint32_t BLOCK_SIZE = 256;
+	// Below this many dirty blocks the rebuild isn't worth waking the worker threads for.
+	static constexpr uint32_t PARALLEL_BLOCKS = 4;
+
+	struct Stats
+	{
+		uint32_t nTransforms = 0;
+		uint32_t nBlocks = 0;
+		// Rebuilt by the last update().
+		uint32_t nRebuilt = 0;
+	};
+
+	CatTransformSystem() = default;
+	~CatTransformSystem();
+
+	CatTransformSystem( const CatTransformSystem& ) = delete;
+	CatTransformSystem& operator=( const CatTransformSystem& ) = delete;
+
+	// Takes over the transform's matrices until it is removed or destroyed.
+	void add( TransformComponent& transform );
+	void remove( TransformComponent& transform );
+
+	// Rebuilds the dirty matrices, split across the pool's threads by block if it is set and there are enough of them.
+	void update( BS::thread_pool* pPool = nullptr );
+
+	// Clamped to the supported level, for comparing the implementations.
+	void setSimdLevel( const SimdLevel eLevel ) { m_eSimdLevel = std::min( eLevel, GetSupportedSimdLevel() ); }
+	[[nodiscard]] SimdLevel getSimdLevel() const { return m_eSimdLevel; }
+
+	[[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+private:
+	friend struct TransformComponent;
+
+	struct Block
+	{
+		alignas( 32 ) std::array< float, BLOCK_SIZE > aTranslationX;
+		std::array< float, BLOCK_SIZE > aTranslationY;
+		std::array< float, BLOCK_SIZE > aTranslationZ;
+		std::array< float, BLOCK_SIZE > aRotationX;
+		std::array< float, BLOCK_SIZE > aRotationY;
+		std::array< float, BLOCK_SIZE > aRotationZ;
+		std::array< float, BLOCK_SIZE > aScaleX;
+		std::array< float, BLOCK_SIZE > aScaleY;
+		std::array< float, BLOCK_SIZE > aScaleZ;
+
+		std::array< glm::mat4, BLOCK_SIZE > aWorld;
+		std::array< glm::mat3, BLOCK_SIZE > aNormal;
+
+		std::array< TransformComponent*, BLOCK_SIZE > aOwners{};
+		std::array< uint64_t, BLOCK_SIZE / 64 > aDirty{};
+	};
+
+	// Copies the transform's components into its slot and marks it dirty.
+	void set( const TransformComponent& transform );
+	// A dirty slot read before the next update() is rebuilt on its own.
+	const glm::mat4& getWorldMatrix( uint32_t nHandle );
+	const glm::mat3& getNormalMatrix( uint32_t nHandle );
+	[[nodiscard]] bool isDirty( uint32_t nHandle ) const;
+
+	void rebuildSlot( Block& block, uint32_t nSlot ) const;
+	void rebuildBlock( Block& block ) const;
+
+	std::vector< std::unique_ptr< Block > > m_aBlocks;
+	std::vector< uint32_t > m_aFreeHandles;
+	std::vector< Block* > m_aDirtyBlocks;
+	SimdLevel m_eSimdLevel = GetSupportedSimdLevel();
+	Stats m_stats;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATTRANSFORM_HPP
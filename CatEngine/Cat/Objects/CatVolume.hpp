@@ -11,22 +11,28 @@ namespace cat
 class CatVolume : public CatObject
 {
 public:
-	[[nodiscard]] static std::unique_ptr< CatVolume > create( const std::string& sName,
+	static constexpr const char* POOL_NAME = "CatVolume";
+
+	[[nodiscard]] static std::shared_ptr< CatVolume > create( const std::string& sName,
 		const std::string& sFile = "assets/models/cube.obj",
 		const ObjectType& eType = ObjectType::eVolume )
 	{
-		auto volume = std::unique_ptr< CatVolume >( new CatVolume( sName, sFile, eType ) );
+		auto volume = std::allocate_shared< CatVolume >( CatPoolAllocator< CatVolume >(), sName, sFile, eType );
 		volume->m_vColor = { 1.0f, 0.0f, 0.0f };
 		return volume;
 	}
 
 	virtual bool isInside( const CatObject& other );
 	virtual bool isInside2D( const CatObject& other );
+	using CatObject::save;
 	json save() override;
 
 	virtual ~CatVolume() override = default;
 
 protected:
+	template < typename, typename >
+	friend struct CatPoolAllocator;
+
 	[[nodiscard]] CatVolume( const std::string& sName,
 		const std::string& sFile = "assets/models/cube.obj",
 		const ObjectType& eType = ObjectType::eVolume )
@@ -0,0 +1,289 @@
+#include "CatGpuDrivenRenderSystem.hpp"
+
+#include "Cat/VulkanRHI/CatSwapChain.hpp"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace cat
+{
+// Has to match the push constants of simple_shader_2.frag, the indirect vertex shader doesn't use them.
+struct CatPushConstantData
+{
+	glm::mat4 m_mxModel{ 1.f };
+	glm::mat4 m_mxNormal{ 1.f };
+};
+
+struct CatCullPushConstantData
+{
+	std::array< glm::vec4, 6 > m_aPlanes{};
+	uint32_t m_nObjectCount = 0;
+	std::array< uint32_t, CatGeometryPool::MAX_PAGES > m_aPageFirstObjects{};
+};
+
+// gpu_cull.comp's local size.
+static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+CatGpuDrivenRenderSystem::CatGpuDrivenRenderSystem( CatDevice* pDevice,
+	vk::RenderPass renderPass,
+	vk::DescriptorSetLayout globalSetLayout )
+	: m_pDevice{ pDevice }, m_aFrames( CatSwapChain::MAX_FRAMES_IN_FLIGHT )
+{
+	createDescriptors();
+	createPipelineLayouts( globalSetLayout );
+	createPipelines( renderPass );
+}
+
+CatGpuDrivenRenderSystem::~CatGpuDrivenRenderSystem()
+{
+	( **m_pDevice ).destroy( m_pCullPipelineLayout );
+	( **m_pDevice ).destroy( m_pPipelineLayout );
+}
+
+void CatGpuDrivenRenderSystem::createDescriptors()
+{
+	m_pSetLayout =
+		CatDescriptorSetLayout::Builder( *m_pDevice )
+			.addBinding( 0, vk::DescriptorType::eStorageBuffer,
+				vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eCompute )
+			.addBinding( 1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute )
+			.addBinding( 2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute )
+			.build();
+
+	m_pDescriptorPool = CatDescriptorPool::Builder( *m_pDevice )
+							.setMaxSets( CatSwapChain::MAX_FRAMES_IN_FLIGHT )
+							.addPoolSize( vk::DescriptorType::eStorageBuffer, 3 * CatSwapChain::MAX_FRAMES_IN_FLIGHT )
+							.build();
+
+	// A draw count per geometry page. Host visible, so they can be read back once the frame's fence was waited on.
+	for ( auto& frame : m_aFrames )
+	{
+		frame.pCount = std::make_unique< CatBuffer >( m_pDevice, sizeof( uint32_t ), CatGeometryPool::MAX_PAGES,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer
+				| vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eHostVisible );
+		frame.pCount->map();
+	}
+}
+
+void CatGpuDrivenRenderSystem::createPipelineLayouts( vk::DescriptorSetLayout globalSetLayout )
+{
+	const vk::DescriptorSetLayout objectSetLayout = m_pSetLayout->getDescriptorSetLayout();
+
+	vk::PushConstantRange cullPushConstantRange{
+		.stageFlags = vk::ShaderStageFlagBits::eCompute,
+		.offset = 0,
+		.size = sizeof( CatCullPushConstantData ),
+	};
+
+	vk::PipelineLayoutCreateInfo cullPipelineLayoutInfo{
+		.setLayoutCount = 1,
+		.pSetLayouts = &objectSetLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &cullPushConstantRange,
+	};
+
+	if ( ( **m_pDevice ).createPipelineLayout( &cullPipelineLayoutInfo, nullptr, &m_pCullPipelineLayout ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "failed to create pipeline layout!" );
+	}
+
+	vk::PushConstantRange pushConstantRange{
+		.stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+		.offset = 0,
+		.size = sizeof( CatPushConstantData ),
+	};
+
+	std::vector< vk::DescriptorSetLayout > descriptorSetLayouts{ globalSetLayout, objectSetLayout };
+
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo{
+		.setLayoutCount = static_cast< uint32_t >( descriptorSetLayouts.size() ),
+		.pSetLayouts = descriptorSetLayouts.data(),
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushConstantRange,
+	};
+
+	if ( ( **m_pDevice ).createPipelineLayout( &pipelineLayoutInfo, nullptr, &m_pPipelineLayout ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "failed to create pipeline layout!" );
+	}
+}
+
+void CatGpuDrivenRenderSystem::createPipelines( vk::RenderPass renderPass )
+{
+	assert( !!m_pPipelineLayout && "Cannot create pipeline before pipeline layout" );
+
+	m_pCullPipeline = std::make_unique< CatPipeline >( m_pDevice, "assets/shaders/gpu_cull.comp.spv", m_pCullPipelineLayout );
+
+	PipelineConfigInfo pipelineConfig{};
+	CatPipeline::defaultPipelineConfigInfo( pipelineConfig );
+	pipelineConfig.m_pRenderPass = renderPass;
+	pipelineConfig.m_pPipelineLayout = m_pPipelineLayout;
+	m_pPipeline = std::make_unique< CatPipeline >( m_pDevice, "assets/shaders/simple_shader_2_indirect.vert.spv",
+		"assets/shaders/simple_shader_2.frag.spv", pipelineConfig );
+}
+
+void CatGpuDrivenRenderSystem::reserveObjects( const int nFrameIndex, const size_t nCount )
+{
+	auto& frame = m_aFrames[nFrameIndex];
+	if ( frame.pObjects && frame.pObjects->getInstanceCount() >= nCount ) return;
+
+	if ( frame.pObjects )
+	{
+		m_pDevice->deferRelease( std::shared_ptr< CatBuffer >( std::move( frame.pObjects ) ) );
+		m_pDevice->deferRelease( std::shared_ptr< CatBuffer >( std::move( frame.pCommands ) ) );
+	}
+	// Grown in powers of two, so a level streaming in doesn't reallocate every frame.
+	size_t nCapacity = 1024;
+	while ( nCapacity < nCount )
+	{
+		nCapacity *= 2;
+	}
+	frame.pObjects = std::make_unique< CatBuffer >( m_pDevice, sizeof( ObjectData ), static_cast< uint32_t >( nCapacity ),
+		vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible );
+	frame.pObjects->map();
+	frame.pCommands = std::make_unique< CatBuffer >( m_pDevice, sizeof( vk::DrawIndexedIndirectCommand ),
+		static_cast< uint32_t >( nCapacity ),
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+		vk::MemoryPropertyFlagBits::eDeviceLocal );
+
+	// Only this frame index uses the set and its fence was waited on, so it can be rewritten.
+	auto objectsInfo = frame.pObjects->descriptorInfo();
+	auto commandsInfo = frame.pCommands->descriptorInfo();
+	auto countInfo = frame.pCount->descriptorInfo();
+	CatDescriptorWriter writer( *m_pSetLayout, *m_pDescriptorPool );
+	writer.writeBuffer( 0, &objectsInfo ).writeBuffer( 1, &commandsInfo ).writeBuffer( 2, &countInfo );
+	if ( !frame.descriptorSet )
+	{
+		if ( !writer.build( frame.descriptorSet ) )
+		{
+			throw std::runtime_error( "failed to allocate gpu driven descriptor set!" );
+		}
+	}
+	else
+	{
+		writer.overwrite( frame.descriptorSet );
+	}
+}
+
+bool CatGpuDrivenRenderSystem::isDrawn( const MeshComponent& mesh )
+{
+	// Only the visible game objects with a model have a mesh. Transparent ones have to be blended back to front after the
+	// opaque objects, and the indirect draws are indexed, models without indices stay on the CPU path.
+	return !mesh.isTransparent() && mesh.pModel->hasIndexBuffer();
+}
+
+void CatGpuDrivenRenderSystem::cull( const CatFrameInfo& frameInfo, const CatFrustum& frustum, CatWorld& world )
+{
+	auto& frame = m_aFrames[frameInfo.m_nFrameIndex];
+	const auto commandBuffer = frameInfo.m_pCommandBuffer;
+
+	if ( frame.nObjectCount > 0 )
+	{
+		frame.pCount->invalidate();
+		const auto* pCounts = static_cast< const uint32_t* >( frame.pCount->getMappedMemory() );
+		m_stats.nDrawn = 0;
+		for ( uint32_t i = 0; i < CatGeometryPool::MAX_PAGES; ++i )
+		{
+			m_stats.nDrawn += pCounts[i];
+		}
+	}
+
+	// The objects are grouped by geometry page, every page gets its own range of draws and its own count.
+	frame.aPageObjectCounts.fill( 0 );
+	world.each< const MeshComponent >(
+		[&]( Entity, const MeshComponent& mesh )
+		{
+			if ( isDrawn( mesh ) ) frame.aPageObjectCounts[mesh.pModel->getGeometryPage()]++;
+		} );
+	uint32_t nObjectCount = 0;
+	for ( uint32_t i = 0; i < CatGeometryPool::MAX_PAGES; ++i )
+	{
+		frame.aPageFirstObjects[i] = nObjectCount;
+		nObjectCount += frame.aPageObjectCounts[i];
+	}
+	frame.nObjectCount = nObjectCount;
+	m_stats.nObjects = nObjectCount;
+	if ( nObjectCount == 0 )
+	{
+		m_stats.nDrawn = 0;
+		return;
+	}
+
+	// Only the per object data is written here, the draws themselves are produced by the GPU.
+	reserveObjects( frameInfo.m_nFrameIndex, nObjectCount );
+	auto* pObjects = static_cast< ObjectData* >( frame.pObjects->getMappedMemory() );
+	auto aNextObjects = frame.aPageFirstObjects;
+	world.each< const MeshComponent >(
+		[&]( Entity, const MeshComponent& mesh )
+		{
+			if ( !isDrawn( mesh ) ) return;
+
+			const auto& model = *mesh.pModel;
+			auto& object = pObjects[aNextObjects[model.getGeometryPage()]++];
+			object.mxModel = mesh.pTransform->mat4();
+			object.mxNormal = mesh.pTransform->normalMatrix();
+			object.vSphere = glm::vec4( model.getBounds().vCenter, model.getBounds().fRadius );
+			object.nIndexCount = model.getIndexCount();
+			object.nFirstIndex = model.getFirstIndex();
+			object.nVertexOffset = model.getVertexOffset();
+			object.nPage = model.getGeometryPage();
+		} );
+	frame.pObjects->flush();
+
+	commandBuffer.fillBuffer( **frame.pCount, 0, VK_WHOLE_SIZE, 0 );
+
+	const vk::MemoryBarrier resetBarrier{
+		.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+		.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+	};
+	commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, 1,
+		&resetBarrier, 0, nullptr, 0, nullptr );
+
+	m_pCullPipeline->bind( commandBuffer );
+	commandBuffer.bindDescriptorSets(
+		vk::PipelineBindPoint::eCompute, m_pCullPipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr );
+
+	CatCullPushConstantData push{};
+	push.m_aPlanes = frustum.m_APlanes;
+	push.m_nObjectCount = nObjectCount;
+	push.m_aPageFirstObjects = frame.aPageFirstObjects;
+	commandBuffer.pushConstants(
+		m_pCullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof( CatCullPushConstantData ), &push );
+	commandBuffer.dispatch( ( nObjectCount + CULL_GROUP_SIZE - 1 ) / CULL_GROUP_SIZE, 1, 1 );
+
+	// The host reads the count back when this frame index comes around again.
+	const vk::MemoryBarrier cullBarrier{
+		.srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+		.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eHostRead,
+	};
+	commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eHost, {}, 1, &cullBarrier, 0, nullptr, 0,
+		nullptr );
+}
+
+void CatGpuDrivenRenderSystem::renderObjects( const CatFrameInfo& frameInfo )
+{
+	const auto& frame = m_aFrames[frameInfo.m_nFrameIndex];
+	if ( frame.nObjectCount == 0 ) return;
+
+	const auto commandBuffer = frameInfo.m_pCommandBuffer;
+	m_pPipeline->bind( commandBuffer );
+
+	const vk::DescriptorSet descriptorSets[] = { frameInfo.m_pGlobalDescriptorSet, frame.descriptorSet };
+	commandBuffer.bindDescriptorSets( vk::PipelineBindPoint::eGraphics, m_pPipelineLayout, 0, 2, descriptorSets, 0, nullptr );
+
+	// firstInstance of every command is the object's index, the vertex shader reads its matrices with it.
+	constexpr vk::DeviceSize nStride = sizeof( vk::DrawIndexedIndirectCommand );
+	uint32_t nBoundPage = CatGeometryPool::NO_PAGE;
+	for ( uint32_t i = 0; i < CatGeometryPool::MAX_PAGES; ++i )
+	{
+		if ( frame.aPageObjectCounts[i] == 0 ) continue;
+
+		m_pDevice->getGeometryPool().bind( commandBuffer, i, nBoundPage );
+		commandBuffer.drawIndexedIndirectCount( **frame.pCommands, frame.aPageFirstObjects[i] * nStride, **frame.pCount,
+			i * sizeof( uint32_t ), frame.aPageObjectCounts[i], static_cast< uint32_t >( nStride ) );
+	}
+}
+} // namespace cat
@@ -0,0 +1,95 @@
+#ifndef CATENGINE_CATGPUDRIVENRENDERSYSTEM_HPP
+#define CATENGINE_CATGPUDRIVENRENDERSYSTEM_HPP
+
+#include "Cat/VulkanRHI/CatDevice.hpp"
+#include "Cat/CatFrameInfo.hpp"
+#include "Cat/Objects/CatObject.hpp"
+#include "Cat/ECS/CatComponents.hpp"
+#include "Cat/ECS/CatWorld.hpp"
+#include "Cat/Rendering/CatFrustum.hpp"
+#include "Cat/VulkanRHI/CatBuffer.hpp"
+#include "Cat/VulkanRHI/CatDescriptors.hpp"
+#include "Cat/VulkanRHI/CatPipeline.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace cat
+{
+// Draws the game objects with one drawIndexedIndirectCount per geometry page.
+// A compute pass tests every object against the frustum and appends the draws of the visible ones,
+// recording the frame costs the same no matter how many objects there are.
+class CatGpuDrivenRenderSystem
+{
+public:
+	struct Stats
+	{
+		uint32_t nObjects = 0;
+		// Read back from the frame that last used this frame index.
+		uint32_t nDrawn = 0;
+	};
+
+	CatGpuDrivenRenderSystem( CatDevice* pDevice, vk::RenderPass renderPass, vk::DescriptorSetLayout globalSetLayout );
+	~CatGpuDrivenRenderSystem();
+
+	CatGpuDrivenRenderSystem( const CatGpuDrivenRenderSystem& ) = delete;
+	CatGpuDrivenRenderSystem& operator=( const CatGpuDrivenRenderSystem& ) = delete;
+
+	// Records the culling dispatch for the meshes of the world, has to be called outside of the render pass.
+	void cull( const CatFrameInfo& frameInfo, const CatFrustum& frustum, CatWorld& world );
+	void renderObjects( const CatFrameInfo& frameInfo );
+
+	[[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+	// Transparent objects and models without indices are left to CatSimpleRenderSystem.
+	[[nodiscard]] static bool isDrawn( const MeshComponent& mesh );
+
+private:
+	// std430 layout of ObjectData in gpu_cull.comp and simple_shader_2_indirect.vert.
+	struct ObjectData
+	{
+		glm::mat4 mxModel{ 1.f };
+		glm::mat4 mxNormal{ 1.f };
+		// Model space bounding sphere, scaled by the shader.
+		glm::vec4 vSphere{};
+		uint32_t nIndexCount = 0;
+		uint32_t nFirstIndex = 0;
+		int32_t nVertexOffset = 0;
+		uint32_t nPage = 0;
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr< CatBuffer > pObjects;
+		std::unique_ptr< CatBuffer > pCommands;
+		std::unique_ptr< CatBuffer > pCount;
+		vk::DescriptorSet descriptorSet;
+		uint32_t nObjectCount = 0;
+		std::array< uint32_t, CatGeometryPool::MAX_PAGES > aPageObjectCounts{};
+		std::array< uint32_t, CatGeometryPool::MAX_PAGES > aPageFirstObjects{};
+	};
+
+	void createDescriptors();
+	void createPipelineLayouts( vk::DescriptorSetLayout globalSetLayout );
+	void createPipelines( vk::RenderPass renderPass );
+	// Grows the frame's object and command buffers, the old ones are released once the frames using them finished.
+	void reserveObjects( int nFrameIndex, size_t nCount );
+
+	CatDevice* m_pDevice;
+
+	std::unique_ptr< CatDescriptorSetLayout > m_pSetLayout;
+	std::unique_ptr< CatDescriptorPool > m_pDescriptorPool;
+	std::vector< FrameResources > m_aFrames;
+
+	vk::PipelineLayout m_pCullPipelineLayout;
+	std::unique_ptr< CatPipeline > m_pCullPipeline;
+	vk::PipelineLayout m_pPipelineLayout;
+	std::unique_ptr< CatPipeline > m_pPipeline;
+
+	Stats m_stats;
+};
+} // namespace cat
+
+
+#endif // CATENGINE_CATGPUDRIVENRENDERSYSTEM_HPP
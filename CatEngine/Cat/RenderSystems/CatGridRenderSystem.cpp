@@ -7,8 +7,10 @@
 
 #include <array>
 #include <cassert>
+#include <limits>
 #include <stdexcept>
 
+#include "Cat/ECS/CatComponents.hpp"
 #include "Cat/Objects/CatVolume.hpp"
 
 namespace cat
@@ -73,30 +75,24 @@ void CatGridRenderSystem::createPipeline( vk::RenderPass renderPass )
 		m_pDevice, "assets/shaders/grid.vert.spv", "assets/shaders/grid.frag.spv", pipelineConfig );
 }
 
-void CatGridRenderSystem::renderObjects( const CatFrameInfo& frameInfo )
+void CatGridRenderSystem::submitObjects( const CatFrameInfo& frameInfo, CatRenderQueue& renderQueue )
 {
-	m_pPipeline->bind( frameInfo.m_pCommandBuffer );
-
-	frameInfo.m_pCommandBuffer.bindDescriptorSets(
-		vk::PipelineBindPoint::eGraphics, m_pPipelineLayout, 0, 1, &frameInfo.m_pGlobalDescriptorSet, 0, nullptr );
-
-	for ( auto& [key, obj] : frameInfo.m_pLevel->getAllObjects() )
-	{
-		if ( !obj ) continue;
-		if ( !obj->m_BVisible ) continue;
-
-		if ( obj->getType() >= ObjectType::eGrid )
+	frameInfo.m_pLevel->getWorld().each< const GridComponent >(
+		[&]( Entity, const GridComponent& grid )
 		{
 			CatPushConstantData push{};
-			push.m_mxModel = obj->m_transform.mat4();
-			push.m_mxNormal = obj->m_transform.normalMatrix();
-
-			frameInfo.m_pCommandBuffer.pushConstants( m_pPipelineLayout,
-				vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof( CatPushConstantData ),
-				&push );
-
-			frameInfo.m_pCommandBuffer.draw( 6, 1, 0, 0 );
-		}
-	}
+			push.m_mxModel = grid.pTransform->mat4();
+			push.m_mxNormal = grid.pTransform->normalMatrix();
+
+			// The grid spans the view, drawn last in its pass.
+			renderQueue.submit( CatRenderQueue::Pass::eOverlay, std::numeric_limits< float >::max(),
+				{
+					.pPipeline = m_pPipeline.get(),
+					.pipelineLayout = m_pPipelineLayout,
+					.descriptorSet = frameInfo.m_pGlobalDescriptorSet,
+					.nVertexCount = 6,
+				},
+				&push, sizeof( CatPushConstantData ), vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment );
+		} );
 }
 } // namespace cat
@@ -5,6 +5,7 @@
 #include "Cat/Controller/CatCamera.hpp"
 #include "Cat/CatFrameInfo.hpp"
 #include "Cat/Objects/CatObject.hpp"
+#include "Cat/Rendering/CatRenderQueue.hpp"
 #include "Cat/VulkanRHI/CatPipeline.hpp"
 
 #include <memory>
@@ -21,7 +22,7 @@ public:
 	CatGridRenderSystem( const CatGridRenderSystem& ) = delete;
 	CatGridRenderSystem& operator=( const CatGridRenderSystem& ) = delete;
 
-	void renderObjects( const CatFrameInfo& frameInfo );
+	void submitObjects( const CatFrameInfo& frameInfo, CatRenderQueue& renderQueue );
 
 private:
 	void createPipelineLayout( vk::DescriptorSetLayout globalSetLayout );
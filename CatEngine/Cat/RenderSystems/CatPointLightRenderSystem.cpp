@@ -7,27 +7,39 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
-#include <map>
 #include <stdexcept>
 
 #include "loguru.hpp"
-#include "Cat/Objects/CatLight.hpp"
+#include "Cat/ECS/CatComponents.hpp"
+#include "Cat/Rendering/CatLightClusters.hpp"
+#include "Cat/VulkanRHI/CatSwapChain.hpp"
 
 namespace cat
 {
-struct PointLightPushConstants
+vk::VertexInputBindingDescription CatPointLightRenderSystem::Instance::getBindingDescription()
 {
-	glm::vec4 position{};
-	glm::vec4 color{};
-	float radius;
-};
+	return {
+		.binding = 0,
+		.stride = sizeof( Instance ),
+		.inputRate = vk::VertexInputRate::eInstance,
+	};
+}
+
+std::vector< vk::VertexInputAttributeDescription > CatPointLightRenderSystem::Instance::getAttributeDescriptions()
+{
+	return {
+		{ 0, 0, vk::Format::eR32G32B32A32Sfloat, static_cast< uint32_t >( offsetof( Instance, vPosition ) ) },
+		{ 1, 0, vk::Format::eR32G32B32A32Sfloat, static_cast< uint32_t >( offsetof( Instance, vColor ) ) },
+	};
+}
 
 CatPointLightRenderSystem::CatPointLightRenderSystem( CatDevice* pDevice,
 	vk::RenderPass pRenderPass,
 	vk::DescriptorSetLayout pGlobalSetLayout )
-	: m_pDevice{ pDevice }
+	: m_pDevice{ pDevice }, m_aInstanceBuffers( CatSwapChain::MAX_FRAMES_IN_FLIGHT )
 {
 	createPipelineLayout( pGlobalSetLayout );
 	createPipeline( pRenderPass );
@@ -40,18 +52,13 @@ CatPointLightRenderSystem::~CatPointLightRenderSystem()
 
 void CatPointLightRenderSystem::createPipelineLayout( vk::DescriptorSetLayout pGlobalSetLayout )
 {
-	vk::PushConstantRange pushConstantRange{};
-	pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
-	pushConstantRange.offset = 0;
-	pushConstantRange.size = sizeof( PointLightPushConstants );
-
 	std::vector< vk::DescriptorSetLayout > descriptorSetLayouts{ pGlobalSetLayout };
 
 	vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.setLayoutCount = static_cast< uint32_t >( descriptorSetLayouts.size() );
 	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-	pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
 	if ( ( **m_pDevice ).createPipelineLayout( &pipelineLayoutInfo, nullptr, &m_pPipelineLayout ) != vk::Result::eSuccess )
 	{
 		throw std::runtime_error( "failed to create pipeline layout!" );
@@ -67,86 +74,96 @@ void CatPointLightRenderSystem::createPipeline( vk::RenderPass pRenderPass )
 	CatPipeline::enableAlphaBlending( pipelineConfig );
 	CatPipeline::disableBackFaceCulling( pipelineConfig );
 	CatPipeline::disableDepthWrite( pipelineConfig );
-	pipelineConfig.m_aAttributeDescriptions.clear();
-	pipelineConfig.m_aBindingDescriptions.clear();
+	// The billboard corners come from the vertex index, only the lights are read from a buffer.
+	pipelineConfig.m_aBindingDescriptions = { Instance::getBindingDescription() };
+	pipelineConfig.m_aAttributeDescriptions = Instance::getAttributeDescriptions();
 	pipelineConfig.m_pRenderPass = pRenderPass;
 	pipelineConfig.m_pPipelineLayout = m_pPipelineLayout;
 	m_pPipeline = std::make_unique< CatPipeline >(
 		m_pDevice, "assets/shaders/point_light.vert.spv", "assets/shaders/point_light.frag.spv", pipelineConfig );
 }
 
-void CatPointLightRenderSystem::update( const CatFrameInfo& rFrameInfo, GlobalUbo& ubo, const bool bIsRotating ) const
+void CatPointLightRenderSystem::reserveInstances( const int nFrameIndex, const size_t nCount )
+{
+	auto& pBuffer = m_aInstanceBuffers[nFrameIndex];
+	if ( pBuffer && pBuffer->getInstanceCount() >= nCount ) return;
+
+	if ( pBuffer )
+	{
+		m_pDevice->deferRelease( std::shared_ptr< CatBuffer >( std::move( pBuffer ) ) );
+	}
+	size_t nCapacity = 64;
+	while ( nCapacity < nCount )
+	{
+		nCapacity *= 2;
+	}
+	pBuffer = std::make_unique< CatBuffer >( m_pDevice, sizeof( Instance ), static_cast< uint32_t >( nCapacity ),
+		vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible );
+	pBuffer->map();
+}
+
+void CatPointLightRenderSystem::update( const CatFrameInfo& rFrameInfo,
+	std::vector< PointLight >& aLights,
+	const bool bIsRotating ) const
 {
 	const auto rotateLight =
 		glm::rotate( glm::mat4( 1.f ), 0.5f * static_cast< float >( rFrameInfo.m_dFrameTime ), { 0.f, -1.f, 0.f } );
-	int lightIndex = 0;
-	for ( auto& [key, obj] : rFrameInfo.m_pLevel->getAllObjects() )
-	{
-		if ( obj->getType() >= ObjectType::eLight )
+	aLights.clear();
+	rFrameInfo.m_pLevel->getWorld().each< const LightComponent >(
+		[&]( Entity, const LightComponent& light )
 		{
-			const auto light = static_cast< CatLight* >( obj.get() );
-
-			CHECK_F( lightIndex < MAX_LIGHTS, "Point lights exceed maximum specified" );
-
+			auto& transform = *light.pTransform;
 			// update light position
 			if ( bIsRotating )
 			{
-				light->m_transform.translation = glm::vec3( rotateLight * glm::vec4( light->m_transform.translation, 1.f ) );
+				transform.translation = glm::vec3( rotateLight * glm::vec4( transform.translation, 1.f ) );
+				transform.markDirty();
 			}
 
-			// copy light to ubo
-			ubo.pointLights[lightIndex].position = glm::vec4( light->m_transform.translation, 1.f );
-			ubo.pointLights[lightIndex].color = glm::vec4( light->m_vColor, light->m_transform.scale.x );
-
-			lightIndex += 1;
-		}
-	}
-	ubo.numLights = lightIndex;
+			// copy light to the cluster input
+			const auto vColor = glm::vec4( light.vColor, light.fIntensity );
+			aLights.push_back(
+				{ .position = glm::vec4( transform.translation, CatLightClusters::getLightRange( vColor ) ), .color = vColor } );
+		} );
 }
 
-void CatPointLightRenderSystem::render( const CatFrameInfo& rFrameInfo ) const
+void CatPointLightRenderSystem::render( const CatFrameInfo& rFrameInfo )
 {
-	std::map< float, id_t > sorted;
-	for ( auto& [key, obj] : rFrameInfo.m_pLevel->getAllObjects() )
-	{
-		if ( !obj ) continue;
-		if ( obj->getType() >= ObjectType::eLight )
+	// Lights at the same distance are all kept, unlike with a map keyed on the distance.
+	m_aSortedLights.clear();
+	// The lights of the render view are the visible ones.
+	rFrameInfo.m_pLevel->getWorld().each< const LightComponent >(
+		[&]( Entity, const LightComponent& light )
 		{
-			const auto light = static_cast< CatLight* >( obj.get() );
-
 			// calculate distance
-			auto offset = rFrameInfo.m_rCamera.getPosition() - light->m_transform.translation;
-			float disSquared = glm::dot( offset, offset );
-			sorted[disSquared] = light->getId();
-		}
+			const auto offset = rFrameInfo.m_rCamera.getPosition() - light.pTransform->translation;
+			m_aSortedLights.emplace_back( glm::dot( offset, offset ), &light );
+		} );
+	if ( m_aSortedLights.empty() ) return;
+
+	// Back to front for the blending.
+	std::sort( m_aSortedLights.begin(), m_aSortedLights.end(),
+		[]( const auto& a, const auto& b ) { return a.first > b.first; } );
+
+	reserveInstances( rFrameInfo.m_nFrameIndex, m_aSortedLights.size() );
+	auto& pInstanceBuffer = m_aInstanceBuffers[rFrameInfo.m_nFrameIndex];
+	auto* pInstances = static_cast< Instance* >( pInstanceBuffer->getMappedMemory() );
+	for ( size_t i = 0; i < m_aSortedLights.size(); ++i )
+	{
+		const auto* light = m_aSortedLights[i].second;
+		pInstances[i].vPosition = glm::vec4( light->pTransform->translation, light->fRadius );
+		pInstances[i].vColor = glm::vec4( light->vColor, light->fIntensity );
 	}
+	pInstanceBuffer->flush();
 
 	m_pPipeline->bind( rFrameInfo.m_pCommandBuffer );
 
 	rFrameInfo.m_pCommandBuffer.bindDescriptorSets(
 		vk::PipelineBindPoint::eGraphics, m_pPipelineLayout, 0, 1, &rFrameInfo.m_pGlobalDescriptorSet, 0, nullptr );
 
-	// iterate through sorted lights in reverse order
-	for ( auto it = sorted.rbegin(); it != sorted.rend(); ++it )
-	{
-		const auto& object = rFrameInfo.m_pLevel->getAllObjects()[it->second].get();
-
-		if ( !object->m_BVisible ) continue;
-
-		if ( object->getType() >= ObjectType::eLight )
-		{
-			const auto light = static_cast< CatLight* >( object );
-
-			PointLightPushConstants push{};
-			push.position = glm::vec4( light->m_transform.translation, 1.f );
-			push.color = glm::vec4( light->m_vColor, light->m_transform.scale.x );
-			push.radius = light->m_transform.scale.y;
-
-			rFrameInfo.m_pCommandBuffer.pushConstants( m_pPipelineLayout,
-				vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof( PointLightPushConstants ),
-				&push );
-			rFrameInfo.m_pCommandBuffer.draw( 6, 1, 0, 0 );
-		}
-	}
+	const vk::Buffer instanceBuffer = pInstanceBuffer->getBuffer();
+	const vk::DeviceSize nInstanceOffset = 0;
+	rFrameInfo.m_pCommandBuffer.bindVertexBuffers( 0, 1, &instanceBuffer, &nInstanceOffset );
+	rFrameInfo.m_pCommandBuffer.draw( 6, static_cast< uint32_t >( m_aSortedLights.size() ), 0, 0 );
 }
 } // namespace cat
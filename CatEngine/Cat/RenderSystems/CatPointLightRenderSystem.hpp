@@ -6,11 +6,14 @@
 #include "Cat/Controller/CatCamera.hpp"
 #include "Cat/VulkanRHI/CatDevice.hpp"
 #include "Cat/CatFrameInfo.hpp"
+#include "Cat/ECS/CatComponents.hpp"
 #include "Cat/Objects/CatObject.hpp"
+#include "Cat/VulkanRHI/CatBuffer.hpp"
 #include "Cat/VulkanRHI/CatPipeline.hpp"
 
 // std
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace cat
@@ -24,17 +27,35 @@ public:
 	CatPointLightRenderSystem( const CatPointLightRenderSystem& ) = delete;
 	CatPointLightRenderSystem& operator=( const CatPointLightRenderSystem& ) = delete;
 
-	void update( const CatFrameInfo& rFrameInfo, GlobalUbo& ubo, bool bIsRotating ) const;
-	void render( const CatFrameInfo& rFrameInfo ) const;
+	// Collects the level's lights for CatLightClusters.
+	void update( const CatFrameInfo& rFrameInfo, std::vector< PointLight >& aLights, bool bIsRotating ) const;
+	// Draws every light billboard with one instanced draw.
+	void render( const CatFrameInfo& rFrameInfo );
 
 private:
+	// Per instance vertex input of point_light.vert.
+	struct Instance
+	{
+		glm::vec4 vPosition{}; // w is the billboard radius
+		glm::vec4 vColor{};	   // w is intensity
+
+		static vk::VertexInputBindingDescription getBindingDescription();
+		static std::vector< vk::VertexInputAttributeDescription > getAttributeDescriptions();
+	};
+
 	void createPipelineLayout( vk::DescriptorSetLayout pGlobalSetLayout );
 	void createPipeline( vk::RenderPass pRenderPass );
+	// Grows the frame's instance buffer, the old one is released once the frames using it finished.
+	void reserveInstances( int nFrameIndex, size_t nCount );
 
 	CatDevice* m_pDevice;
 
 	std::unique_ptr< CatPipeline > m_pPipeline;
 	vk::PipelineLayout m_pPipelineLayout;
+
+	std::vector< std::unique_ptr< CatBuffer > > m_aInstanceBuffers;
+	// Squared camera distance and light, reused every frame.
+	std::vector< std::pair< float, const LightComponent* > > m_aSortedLights;
 };
 } // namespace cat
 
@@ -5,8 +5,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <limits>
 #include <stdexcept>
 
 #include "Cat/Objects/CatVolume.hpp"
@@ -22,7 +24,7 @@ struct CatPushConstantData
 CatSimpleRenderSystem::CatSimpleRenderSystem( CatDevice* pDevice,
 	vk::RenderPass renderPass,
 	vk::DescriptorSetLayout globalSetLayout )
-	: m_pDevice{ pDevice }
+	: m_pDevice{ pDevice }, m_aInstanceBuffers( CatSwapChain::MAX_FRAMES_IN_FLIGHT )
 {
 	createPipelineLayout( globalSetLayout );
 	createPipeline( renderPass );
@@ -62,39 +64,144 @@ void CatSimpleRenderSystem::createPipeline( vk::RenderPass renderPass )
 
 	PipelineConfigInfo pipelineConfig{};
 	CatPipeline::defaultPipelineConfigInfo( pipelineConfig );
-	CatPipeline::enableAlphaBlending( pipelineConfig );
 	pipelineConfig.m_pRenderPass = renderPass;
 	pipelineConfig.m_pPipelineLayout = m_pPipelineLayout;
-	m_pPipeline = std::make_unique< CatPipeline >(
-		m_pDevice, "assets/shaders/simple_shader_2.vert.spv", "assets/shaders/simple_shader_2.frag.spv", pipelineConfig );
+	pipelineConfig.m_aBindingDescriptions.push_back( CatModel::Instance::getBindingDescription() );
+	const auto instanceAttributes = CatModel::Instance::getAttributeDescriptions();
+	pipelineConfig.m_aAttributeDescriptions.insert(
+		pipelineConfig.m_aAttributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end() );
+	m_pPipeline = std::make_unique< CatPipeline >( m_pDevice, "assets/shaders/simple_shader_2_instanced.vert.spv",
+		"assets/shaders/simple_shader_2.frag.spv", pipelineConfig );
+
+	// After a depth prepass only the visible fragments are shaded, the depth is already written.
+	CatPipeline::enableEqualDepthTest( pipelineConfig );
+	m_pEqualDepthPipeline = std::make_unique< CatPipeline >( m_pDevice,
+		"assets/shaders/simple_shader_2_instanced.vert.spv", "assets/shaders/simple_shader_2.frag.spv", pipelineConfig );
+	pipelineConfig.m_pDepthStencilInfo.depthCompareOp = vk::CompareOp::eLess;
+
+	// Transparent objects blend over the opaque ones and don't occlude each other.
+	CatPipeline::enableAlphaBlending( pipelineConfig );
+	CatPipeline::disableDepthWrite( pipelineConfig );
+	m_pTransparentPipeline = std::make_unique< CatPipeline >( m_pDevice,
+		"assets/shaders/simple_shader_2_instanced.vert.spv", "assets/shaders/simple_shader_2.frag.spv", pipelineConfig );
+
+	// The depth prepass only reads the positions of the vertices and the model matrices of the instances.
+	PipelineConfigInfo depthConfig{};
+	CatPipeline::defaultPipelineConfigInfo( depthConfig );
+	CatPipeline::disableColorWrite( depthConfig );
+	depthConfig.m_pRenderPass = renderPass;
+	depthConfig.m_pPipelineLayout = m_pPipelineLayout;
+	depthConfig.m_aBindingDescriptions.push_back( CatModel::Instance::getBindingDescription() );
+	depthConfig.m_aAttributeDescriptions.resize( 1 );
+	depthConfig.m_aAttributeDescriptions.insert(
+		depthConfig.m_aAttributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.begin() + 4 );
+	m_pDepthPrepassPipeline = std::make_unique< CatPipeline >(
+		m_pDevice, "assets/shaders/depth_prepass.vert.spv", "assets/shaders/depth_prepass.frag.spv", depthConfig );
 }
 
-void CatSimpleRenderSystem::renderObjects( const CatFrameInfo& frameInfo )
+void CatSimpleRenderSystem::reserveInstances( const int nFrameIndex, const size_t nCount )
 {
-	m_pPipeline->bind( frameInfo.m_pCommandBuffer );
+	auto& pBuffer = m_aInstanceBuffers[nFrameIndex];
+	if ( pBuffer && pBuffer->getInstanceCount() >= nCount ) return;
+
+	if ( pBuffer )
+	{
+		m_pDevice->deferRelease( std::shared_ptr< CatBuffer >( std::move( pBuffer ) ) );
+	}
+	// Grown in powers of two, so a level streaming in doesn't reallocate every frame.
+	size_t nCapacity = 256;
+	while ( nCapacity < nCount )
+	{
+		nCapacity *= 2;
+	}
+	pBuffer = std::make_unique< CatBuffer >( m_pDevice, sizeof( CatModel::Instance ), static_cast< uint32_t >( nCapacity ),
+		vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible );
+	pBuffer->map();
+}
 
-	frameInfo.m_pCommandBuffer.bindDescriptorSets(
-		vk::PipelineBindPoint::eGraphics, m_pPipelineLayout, 0, 1, &frameInfo.m_pGlobalDescriptorSet, 0, nullptr );
+void CatSimpleRenderSystem::submitObjects( const CatFrameInfo& frameInfo,
+	CatRenderQueue& renderQueue,
+	const CatGpuDrivenRenderSystem* pGpuDriven,
+	const bool bDepthPrepass )
+{
+	const auto vCameraPosition = frameInfo.m_rCamera.getPosition();
 
-	for ( auto& [key, obj] : frameInfo.m_pLevel->getAllObjects() )
+	// Only the visible game objects with a model have a mesh.
+	m_aBatches.clear();
+	frameInfo.m_pLevel->getWorld().each< const MeshComponent >(
+		[&]( Entity, const MeshComponent& mesh )
+		{
+			if ( mesh.bCulled ) return;
+			if ( pGpuDriven && CatGpuDrivenRenderSystem::isDrawn( mesh ) ) return;
+
+			m_aBatches.push_back( {
+				.pModel = mesh.pModel,
+				.pMesh = &mesh,
+				.fDepth = glm::distance( vCameraPosition, mesh.pTransform->translation ),
+				.bTransparent = mesh.isTransparent(),
+			} );
+		} );
+	if ( m_aBatches.empty() ) return;
+
+	// Opaque objects of the same model end up next to each other and become the instances of one packet,
+	// front to back inside it. Transparent ones are sorted by the render queue one by one.
+	std::sort( m_aBatches.begin(), m_aBatches.end(),
+		[]( const Batch& a, const Batch& b )
+		{
+			if ( a.bTransparent != b.bTransparent ) return b.bTransparent;
+			if ( a.pModel != b.pModel ) return std::less<>{}( a.pModel, b.pModel );
+			return a.fDepth < b.fDepth;
+		} );
+
+	reserveInstances( frameInfo.m_nFrameIndex, m_aBatches.size() );
+	auto& pInstanceBuffer = m_aInstanceBuffers[frameInfo.m_nFrameIndex];
+	auto* pInstances = static_cast< CatModel::Instance* >( pInstanceBuffer->getMappedMemory() );
+	for ( size_t i = 0; i < m_aBatches.size(); ++i )
 	{
-		if ( !obj ) continue;
-		if ( !obj->m_BVisible ) continue;
+		const auto* pMesh = m_aBatches[i].pMesh;
+		pInstances[i].mxModel = pMesh->pTransform->mat4();
+		pInstances[i].mxNormal = pMesh->pTransform->normalMatrix();
+		pInstances[i].fOpacity = pMesh->fOpacity;
+	}
+	pInstanceBuffer->flush();
 
-		if ( !obj->m_pModel ) continue;
+	CatRenderQueue::Packet packet{
+		.pipelineLayout = m_pPipelineLayout,
+		.descriptorSet = frameInfo.m_pGlobalDescriptorSet,
+		.instanceBuffer = pInstanceBuffer->getBuffer(),
+	};
+	for ( size_t nFirst = 0; nFirst < m_aBatches.size(); )
+	{
+		const auto& first = m_aBatches[nFirst];
+		size_t nLast = nFirst + 1;
+		while ( !first.bTransparent && nLast < m_aBatches.size() && !m_aBatches[nLast].bTransparent
+				&& m_aBatches[nLast].pModel == first.pModel )
+		{
+			++nLast;
+		}
 
-		if ( obj->getType() >= ObjectType::eGameObject )
+		packet.pModel = first.pModel;
+		packet.nInstanceCount = static_cast< uint32_t >( nLast - nFirst );
+		packet.nFirstInstance = static_cast< uint32_t >( nFirst );
+		// The batch is sorted by its nearest instance.
+		if ( first.bTransparent )
+		{
+			packet.pPipeline = m_pTransparentPipeline.get();
+			renderQueue.submit( CatRenderQueue::Pass::eTransparent, first.fDepth, packet );
+		}
+		else if ( bDepthPrepass )
+		{
+			packet.pPipeline = m_pDepthPrepassPipeline.get();
+			renderQueue.submit( CatRenderQueue::Pass::eDepthPrepass, first.fDepth, packet );
+			packet.pPipeline = m_pEqualDepthPipeline.get();
+			renderQueue.submit( CatRenderQueue::Pass::eOpaque, first.fDepth, packet );
+		}
+		else
 		{
-			CatPushConstantData push{};
-			push.m_mxModel = obj->m_transform.mat4();
-			push.m_mxNormal = obj->m_transform.normalMatrix();
-
-			frameInfo.m_pCommandBuffer.pushConstants( m_pPipelineLayout,
-				vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof( CatPushConstantData ),
-				&push );
-			obj->m_pModel->bind( frameInfo.m_pCommandBuffer );
-			obj->m_pModel->draw( frameInfo.m_pCommandBuffer );
+			packet.pPipeline = m_pPipeline.get();
+			renderQueue.submit( CatRenderQueue::Pass::eOpaque, first.fDepth, packet );
 		}
+		nFirst = nLast;
 	}
 }
 } // namespace cat
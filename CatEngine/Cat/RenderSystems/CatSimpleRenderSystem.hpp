@@ -4,8 +4,12 @@
 #include "Cat/VulkanRHI/CatDevice.hpp"
 #include "Cat/Controller/CatCamera.hpp"
 #include "Cat/CatFrameInfo.hpp"
+#include "Cat/ECS/CatComponents.hpp"
 #include "Cat/Objects/CatObject.hpp"
+#include "Cat/Rendering/CatRenderQueue.hpp"
+#include "Cat/RenderSystems/CatGpuDrivenRenderSystem.hpp"
 #include "Cat/VulkanRHI/CatPipeline.hpp"
+#include "Cat/VulkanRHI/CatSwapChain.hpp"
 
 #include <memory>
 #include <vector>
@@ -21,16 +25,40 @@ public:
 	CatSimpleRenderSystem( const CatSimpleRenderSystem& ) = delete;
 	CatSimpleRenderSystem& operator=( const CatSimpleRenderSystem& ) = delete;
 
-	void renderObjects( const CatFrameInfo& frameInfo );
+	// Opaque game objects become one packet per model drawn with their instances, transparent ones a packet each.
+	// With pGpuDriven set the objects that system draws are skipped.
+	// With bDepthPrepass the opaque objects lay down their depth first and are shaded with an equal depth test.
+	void submitObjects( const CatFrameInfo& frameInfo,
+		CatRenderQueue& renderQueue,
+		const CatGpuDrivenRenderSystem* pGpuDriven = nullptr,
+		bool bDepthPrepass = false );
 
 private:
 	void createPipelineLayout( vk::DescriptorSetLayout globalSetLayout );
 	void createPipeline( vk::RenderPass renderPass );
+	// Grows the frame's instance buffer, the old one is released once the frames using it finished.
+	void reserveInstances( int nFrameIndex, size_t nCount );
 
 	CatDevice* m_pDevice;
 
+	struct Batch
+	{
+		const CatModel* pModel;
+		// Valid until the world's structure changes, the batches are rebuilt every frame.
+		const MeshComponent* pMesh;
+		float fDepth;
+		bool bTransparent;
+	};
+
 	std::unique_ptr< CatPipeline > m_pPipeline;
+	std::unique_ptr< CatPipeline > m_pEqualDepthPipeline;
+	std::unique_ptr< CatPipeline > m_pDepthPrepassPipeline;
+	std::unique_ptr< CatPipeline > m_pTransparentPipeline;
 	vk::PipelineLayout m_pPipelineLayout;
+
+	// Objects sharing a model are drawn with one instanced draw, their matrices are written here every frame.
+	std::vector< std::unique_ptr< CatBuffer > > m_aInstanceBuffers;
+	std::vector< Batch > m_aBatches;
 };
 } // namespace cat
 
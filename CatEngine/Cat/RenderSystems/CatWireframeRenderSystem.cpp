@@ -9,6 +9,7 @@
 #include <cassert>
 #include <stdexcept>
 
+#include "Cat/ECS/CatComponents.hpp"
 #include "Cat/Objects/CatVolume.hpp"
 
 namespace cat
@@ -71,33 +72,29 @@ void CatWireframeRenderSystem::createPipeline( vk::RenderPass renderPass )
 		m_pDevice, "assets/shaders/wireframe.vert.spv", "assets/shaders/wireframe.frag.spv", pipelineConfig );
 }
 
-void CatWireframeRenderSystem::renderObjects( const CatFrameInfo& frameInfo )
+void CatWireframeRenderSystem::submitObjects( const CatFrameInfo& frameInfo, CatRenderQueue& renderQueue )
 {
-	m_pPipeline->bind( frameInfo.m_pCommandBuffer );
-
-	frameInfo.m_pCommandBuffer.bindDescriptorSets(
-		vk::PipelineBindPoint::eGraphics, m_pPipelineLayout, 0, 1, &frameInfo.m_pGlobalDescriptorSet, 0, nullptr );
-
-	for ( auto& [key, obj] : frameInfo.m_pLevel->getAllObjects() )
-	{
-		if ( !obj ) continue;
-		if ( !obj->m_BVisible ) continue;
-
-		if ( !obj->m_pModel ) continue;
-
-		if ( obj->getType() >= ObjectType::eVolume )
+	const auto vCameraPosition = frameInfo.m_rCamera.getPosition();
+	// Volumes without a model are culled as well.
+	frameInfo.m_pLevel->getWorld().each< const VolumeComponent >(
+		[&]( Entity, const VolumeComponent& volume )
 		{
-			CatPushConstantData push{};
-			push.m_mxModel = obj->m_transform.mat4();
-			push.m_mxNormal = obj->m_transform.normalMatrix();
-			push.m_vColor = obj->m_vColor;
+			if ( volume.bCulled ) return;
 
-			frameInfo.m_pCommandBuffer.pushConstants( m_pPipelineLayout,
-				vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof( CatPushConstantData ),
-				&push );
-			obj->m_pModel->bind( frameInfo.m_pCommandBuffer );
-			obj->m_pModel->draw( frameInfo.m_pCommandBuffer );
-		}
-	}
+			CatPushConstantData push{};
+			push.m_mxModel = volume.pTransform->mat4();
+			push.m_mxNormal = volume.pTransform->normalMatrix();
+			push.m_vColor = volume.vColor;
+
+			renderQueue.submit( CatRenderQueue::Pass::eOverlay,
+				glm::distance( vCameraPosition, volume.pTransform->translation ),
+				{
+					.pPipeline = m_pPipeline.get(),
+					.pipelineLayout = m_pPipelineLayout,
+					.descriptorSet = frameInfo.m_pGlobalDescriptorSet,
+					.pModel = volume.pModel,
+				},
+				&push, sizeof( CatPushConstantData ), vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment );
+		} );
 }
 } // namespace cat
@@ -7,6 +7,7 @@
 #include "Cat/Controller/CatCamera.hpp"
 #include "Cat/CatFrameInfo.hpp"
 #include "Cat/Objects/CatObject.hpp"
+#include "Cat/Rendering/CatRenderQueue.hpp"
 #include "Cat/VulkanRHI/CatPipeline.hpp"
 
 #include <memory>
@@ -23,7 +24,7 @@ public:
 	CatWireframeRenderSystem( const CatWireframeRenderSystem& ) = delete;
 	CatWireframeRenderSystem& operator=( const CatWireframeRenderSystem& ) = delete;
 
-	void renderObjects( const CatFrameInfo& frameInfo );
+	void submitObjects( const CatFrameInfo& frameInfo, CatRenderQueue& renderQueue );
 
 private:
 	void createPipelineLayout( vk::DescriptorSetLayout globalSetLayout );
@@ -0,0 +1,95 @@
+#include "CatCulling.hpp"
+
+#include "Cat/ECS/CatComponents.hpp"
+#include "Cat/Objects/CatObject.hpp"
+
+namespace cat
+{
+void CatCulling::BoundsSoA::clear()
+{
+	for ( auto* pArray : { &aX, &aY, &aZ, &aRadius, &aExtentX, &aExtentY, &aExtentZ } )
+	{
+		pArray->clear();
+	}
+}
+
+void CatCulling::BoundsSoA::push( const glm::vec3& vCenter, const float fRadius, const glm::vec3& vExtent )
+{
+	aX.push_back( vCenter.x );
+	aY.push_back( vCenter.y );
+	aZ.push_back( vCenter.z );
+	aRadius.push_back( fRadius );
+	aExtentX.push_back( vExtent.x );
+	aExtentY.push_back( vExtent.y );
+	aExtentZ.push_back( vExtent.z );
+}
+
+void CatCulling::cull( const CatFrustum& frustum, CatWorld& world )
+{
+	m_aCandidates.clear();
+	m_bounds.clear();
+	m_stats = {};
+
+	// The objects cache their world bounds until their transform or model changes.
+	const auto fnAdd = [this]( const ObjectComponent& object, bool& bCulled )
+	{
+		bCulled = false;
+		if ( !m_bEnabled ) return;
+
+		const auto& bounds = object.pObject->getWorldBounds();
+		m_aCandidates.push_back( &bCulled );
+		m_bounds.push( bounds.vCenter, bounds.fRadius, ( bounds.vMax - bounds.vMin ) * 0.5f );
+	};
+	world.each< const ObjectComponent, MeshComponent >(
+		[&]( Entity, const ObjectComponent& object, MeshComponent& mesh ) { fnAdd( object, mesh.bCulled ); } );
+	world.each< const ObjectComponent, VolumeComponent >(
+		[&]( Entity, const ObjectComponent& object, VolumeComponent& volume )
+		{
+			if ( volume.pModel )
+			{
+				fnAdd( object, volume.bCulled );
+			}
+			else
+			{
+				volume.bCulled = true;
+			}
+		} );
+	m_stats.nTested = static_cast< uint32_t >( m_aCandidates.size() );
+	if ( m_aCandidates.empty() ) return;
+
+	// The sphere test is cheaper and rejects most of the objects, the box is tighter for long and flat meshes.
+	m_aVisible.resize( m_aCandidates.size() );
+	frustum.checkSpheres( m_bounds.aX.data(), m_bounds.aY.data(), m_bounds.aZ.data(), m_bounds.aRadius.data(),
+		m_aCandidates.size(), m_aVisible.data() );
+
+	// Compacted in place, the box test only runs on the spheres that passed.
+	size_t nPassed = 0;
+	for ( size_t i = 0; i < m_aCandidates.size(); ++i )
+	{
+		if ( !m_aVisible[i] )
+		{
+			*m_aCandidates[i] = true;
+			continue;
+		}
+
+		m_aCandidates[nPassed] = m_aCandidates[i];
+		for ( auto* pArray : { &m_bounds.aX, &m_bounds.aY, &m_bounds.aZ, &m_bounds.aExtentX, &m_bounds.aExtentY,
+				  &m_bounds.aExtentZ } )
+		{
+			( *pArray )[nPassed] = ( *pArray )[i];
+		}
+		++nPassed;
+	}
+	m_stats.nCulledBySphere = m_stats.nTested - static_cast< uint32_t >( nPassed );
+
+	frustum.checkAABBs( m_bounds.aX.data(), m_bounds.aY.data(), m_bounds.aZ.data(), m_bounds.aExtentX.data(),
+		m_bounds.aExtentY.data(), m_bounds.aExtentZ.data(), nPassed, m_aVisible.data() );
+	uint32_t nVisible = 0;
+	for ( size_t i = 0; i < nPassed; ++i )
+	{
+		*m_aCandidates[i] = !m_aVisible[i];
+		nVisible += m_aVisible[i];
+	}
+	m_stats.nCulled = m_stats.nTested - nVisible;
+}
+} // namespace cat
@@ -0,0 +1,50 @@
+#ifndef CATENGINE_CATCULLING_HPP
+#define CATENGINE_CATCULLING_HPP
+
+#include "Cat/ECS/CatWorld.hpp"
+#include "Cat/Rendering/CatFrustum.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cat
+{
+// Marks the meshes and volumes of the level's world whose model bounds are outside of the frustum, the render systems
+// querying them skip the culled ones.
+class CatCulling
+{
+public:
+	struct Stats
+	{
+		uint32_t nTested = 0;
+		uint32_t nCulled = 0;
+		// Culled by the bounding sphere alone, the rest needed the box test.
+		uint32_t nCulledBySphere = 0;
+	};
+
+	void cull( const CatFrustum& frustum, CatWorld& world );
+
+	[[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+	// Draw everything that has a model, for debugging the bounds.
+	bool m_bEnabled = true;
+
+private:
+	// SoA copy of the candidates' world bounds for the batched frustum tests.
+	struct BoundsSoA
+	{
+		std::vector< float > aX, aY, aZ, aRadius, aExtentX, aExtentY, aExtentZ;
+
+		void clear();
+		void push( const glm::vec3& vCenter, float fRadius, const glm::vec3& vExtent );
+	};
+
+	// The culled flags of the tested components, only valid during cull().
+	std::vector< bool* > m_aCandidates;
+	BoundsSoA m_bounds;
+	std::vector< uint8_t > m_aVisible;
+	Stats m_stats;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATCULLING_HPP
@@ -0,0 +1,242 @@
+#include "CatFrustum.hpp"
+
+#include <cmath>
+
+namespace cat
+{
+// A bound is outside if it is completely behind any of the planes.
+static void CheckSpheresScalar( const std::array< glm::vec4, 6 >& aPlanes,
+	const float* pX,
+	const float* pY,
+	const float* pZ,
+	const float* pRadius,
+	const size_t nBegin,
+	const size_t nCount,
+	uint8_t* pVisible )
+{
+	for ( size_t i = nBegin; i < nCount; ++i )
+	{
+		bool bVisible = true;
+		for ( const auto& vPlane : aPlanes )
+		{
+			bVisible &= vPlane.x * pX[i] + vPlane.y * pY[i] + vPlane.z * pZ[i] + vPlane.w + pRadius[i] >= 0.0f;
+		}
+		pVisible[i] = bVisible;
+	}
+}
+
+static void CheckAABBsScalar( const std::array< glm::vec4, 6 >& aPlanes,
+	const float* pCenterX,
+	const float* pCenterY,
+	const float* pCenterZ,
+	const float* pExtentX,
+	const float* pExtentY,
+	const float* pExtentZ,
+	const size_t nBegin,
+	const size_t nCount,
+	uint8_t* pVisible )
+{
+	for ( size_t i = nBegin; i < nCount; ++i )
+	{
+		bool bVisible = true;
+		for ( const auto& vPlane : aPlanes )
+		{
+			const float fDistance = vPlane.x * pCenterX[i] + vPlane.y * pCenterY[i] + vPlane.z * pCenterZ[i] + vPlane.w;
+			const float fProjectedExtent =
+				std::abs( vPlane.x ) * pExtentX[i] + std::abs( vPlane.y ) * pExtentY[i] + std::abs( vPlane.z ) * pExtentZ[i];
+			bVisible &= fDistance + fProjectedExtent >= 0.0f;
+		}
+		pVisible[i] = bVisible;
+	}
+}
+
+#ifdef CAT_SIMD_X86
+static void StoreMask( const int nMask, const int nLanes, uint8_t* pVisible )
+{
+	for ( int i = 0; i < nLanes; ++i )
+	{
+		pVisible[i] = static_cast< uint8_t >( ( nMask >> i ) & 1 );
+	}
+}
+
+// Four bounds per iteration, every plane is broadcast to all lanes.
+static size_t CheckSpheresSSE( const std::array< glm::vec4, 6 >& aPlanes,
+	const float* pX,
+	const float* pY,
+	const float* pZ,
+	const float* pRadius,
+	const size_t nCount,
+	uint8_t* pVisible )
+{
+	const __m128 zero = _mm_setzero_ps();
+	size_t i = 0;
+	for ( ; i + 4 <= nCount; i += 4 )
+	{
+		const __m128 x = _mm_loadu_ps( pX + i );
+		const __m128 y = _mm_loadu_ps( pY + i );
+		const __m128 z = _mm_loadu_ps( pZ + i );
+		const __m128 r = _mm_loadu_ps( pRadius + i );
+
+		__m128 outside = zero;
+		for ( const auto& vPlane : aPlanes )
+		{
+			__m128 d = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( vPlane.x ) ), _mm_set1_ps( vPlane.w ) );
+			d = _mm_add_ps( d, _mm_mul_ps( y, _mm_set1_ps( vPlane.y ) ) );
+			d = _mm_add_ps( d, _mm_mul_ps( z, _mm_set1_ps( vPlane.z ) ) );
+			d = _mm_add_ps( d, r );
+			outside = _mm_or_ps( outside, _mm_cmplt_ps( d, zero ) );
+		}
+		StoreMask( ~_mm_movemask_ps( outside ), 4, pVisible + i );
+	}
+	return i;
+}
+
+static size_t CheckAABBsSSE( const std::array< glm::vec4, 6 >& aPlanes,
+	const float* pCenterX,
+	const float* pCenterY,
+	const float* pCenterZ,
+	const float* pExtentX,
+	const float* pExtentY,
+	const float* pExtentZ,
+	const size_t nCount,
+	uint8_t* pVisible )
+{
+	const __m128 zero = _mm_setzero_ps();
+	size_t i = 0;
+	for ( ; i + 4 <= nCount; i += 4 )
+	{
+		const __m128 cx = _mm_loadu_ps( pCenterX + i );
+		const __m128 cy = _mm_loadu_ps( pCenterY + i );
+		const __m128 cz = _mm_loadu_ps( pCenterZ + i );
+		const __m128 ex = _mm_loadu_ps( pExtentX + i );
+		const __m128 ey = _mm_loadu_ps( pExtentY + i );
+		const __m128 ez = _mm_loadu_ps( pExtentZ + i );
+
+		__m128 outside = zero;
+		for ( const auto& vPlane : aPlanes )
+		{
+			__m128 d = _mm_add_ps( _mm_mul_ps( cx, _mm_set1_ps( vPlane.x ) ), _mm_set1_ps( vPlane.w ) );
+			d = _mm_add_ps( d, _mm_mul_ps( cy, _mm_set1_ps( vPlane.y ) ) );
+			d = _mm_add_ps( d, _mm_mul_ps( cz, _mm_set1_ps( vPlane.z ) ) );
+			d = _mm_add_ps( d, _mm_mul_ps( ex, _mm_set1_ps( std::abs( vPlane.x ) ) ) );
+			d = _mm_add_ps( d, _mm_mul_ps( ey, _mm_set1_ps( std::abs( vPlane.y ) ) ) );
+			d = _mm_add_ps( d, _mm_mul_ps( ez, _mm_set1_ps( std::abs( vPlane.z ) ) ) );
+			outside = _mm_or_ps( outside, _mm_cmplt_ps( d, zero ) );
+		}
+		StoreMask( ~_mm_movemask_ps( outside ), 4, pVisible + i );
+	}
+	return i;
+}
+
+CAT_TARGET_AVX2 static size_t CheckSpheresAVX2( const std::array< glm::vec4, 6 >& aPlanes,
+	const float* pX,
+	const float* pY,
+	const float* pZ,
+	const float* pRadius,
+	const size_t nCount,
+	uint8_t* pVisible )
+{
+	const __m256 zero = _mm256_setzero_ps();
+	size_t i = 0;
+	for ( ; i + 8 <= nCount; i += 8 )
+	{
+		const __m256 x = _mm256_loadu_ps( pX + i );
+		const __m256 y = _mm256_loadu_ps( pY + i );
+		const __m256 z = _mm256_loadu_ps( pZ + i );
+		const __m256 r = _mm256_loadu_ps( pRadius + i );
+
+		__m256 outside = zero;
+		for ( const auto& vPlane : aPlanes )
+		{
+			__m256 d = _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( vPlane.x ) ), _mm256_set1_ps( vPlane.w ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( y, _mm256_set1_ps( vPlane.y ) ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( z, _mm256_set1_ps( vPlane.z ) ) );
+			d = _mm256_add_ps( d, r );
+			outside = _mm256_or_ps( outside, _mm256_cmp_ps( d, zero, _CMP_LT_OQ ) );
+		}
+		StoreMask( ~_mm256_movemask_ps( outside ), 8, pVisible + i );
+	}
+	return i;
+}
+
+CAT_TARGET_AVX2 static size_t CheckAABBsAVX2( const std::array< glm::vec4, 6 >& aPlanes,
+	const float* pCenterX,
+	const float* pCenterY,
+	const float* pCenterZ,
+	const float* pExtentX,
+	const float* pExtentY,
+	const float* pExtentZ,
+	const size_t nCount,
+	uint8_t* pVisible )
+{
+	const __m256 zero = _mm256_setzero_ps();
+	size_t i = 0;
+	for ( ; i + 8 <= nCount; i += 8 )
+	{
+		const __m256 cx = _mm256_loadu_ps( pCenterX + i );
+		const __m256 cy = _mm256_loadu_ps( pCenterY + i );
+		const __m256 cz = _mm256_loadu_ps( pCenterZ + i );
+		const __m256 ex = _mm256_loadu_ps( pExtentX + i );
+		const __m256 ey = _mm256_loadu_ps( pExtentY + i );
+		const __m256 ez = _mm256_loadu_ps( pExtentZ + i );
+
+		__m256 outside = zero;
+		for ( const auto& vPlane : aPlanes )
+		{
+			__m256 d = _mm256_add_ps( _mm256_mul_ps( cx, _mm256_set1_ps( vPlane.x ) ), _mm256_set1_ps( vPlane.w ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( cy, _mm256_set1_ps( vPlane.y ) ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( cz, _mm256_set1_ps( vPlane.z ) ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( ex, _mm256_set1_ps( std::abs( vPlane.x ) ) ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( ey, _mm256_set1_ps( std::abs( vPlane.y ) ) ) );
+			d = _mm256_add_ps( d, _mm256_mul_ps( ez, _mm256_set1_ps( std::abs( vPlane.z ) ) ) );
+			outside = _mm256_or_ps( outside, _mm256_cmp_ps( d, zero, _CMP_LT_OQ ) );
+		}
+		StoreMask( ~_mm256_movemask_ps( outside ), 8, pVisible + i );
+	}
+	return i;
+}
+
+#endif // CAT_SIMD_X86
+
+void CatFrustum::checkSpheres(
+	const float* pX, const float* pY, const float* pZ, const float* pRadius, const size_t nCount, uint8_t* pVisible ) const
+{
+	size_t nDone = 0;
+#ifdef CAT_SIMD_X86
+	switch ( m_eSimdLevel )
+	{
+	case SimdLevel::eAVX2: nDone = CheckSpheresAVX2( m_aPlanes, pX, pY, pZ, pRadius, nCount, pVisible ); break;
+	case SimdLevel::eSSE: nDone = CheckSpheresSSE( m_aPlanes, pX, pY, pZ, pRadius, nCount, pVisible ); break;
+	case SimdLevel::eScalar: break;
+	}
+#endif
+	// The remainder that doesn't fill a register.
+	CheckSpheresScalar( m_aPlanes, pX, pY, pZ, pRadius, nDone, nCount, pVisible );
+}
+
+void CatFrustum::checkAABBs( const float* pCenterX,
+	const float* pCenterY,
+	const float* pCenterZ,
+	const float* pExtentX,
+	const float* pExtentY,
+	const float* pExtentZ,
+	const size_t nCount,
+	uint8_t* pVisible ) const
+{
+	size_t nDone = 0;
+#ifdef CAT_SIMD_X86
+	switch ( m_eSimdLevel )
+	{
+	case SimdLevel::eAVX2:
+		nDone = CheckAABBsAVX2( m_aPlanes, pCenterX, pCenterY, pCenterZ, pExtentX, pExtentY, pExtentZ, nCount, pVisible );
+		break;
+	case SimdLevel::eSSE:
+		nDone = CheckAABBsSSE( m_aPlanes, pCenterX, pCenterY, pCenterZ, pExtentX, pExtentY, pExtentZ, nCount, pVisible );
+		break;
+	case SimdLevel::eScalar: break;
+	}
+#endif
+	CheckAABBsScalar( m_aPlanes, pCenterX, pCenterY, pCenterZ, pExtentX, pExtentY, pExtentZ, nDone, nCount, pVisible );
+}
+
+} // namespace cat
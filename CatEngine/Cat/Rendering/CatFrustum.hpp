@@ -2,18 +2,33 @@
 #define CATENGINE_CATFRUSTUM_HPP
 
 #include "Globals.hpp"
+#include "Cat/Utils/CatSimd.hpp"
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 namespace cat
 {
 
 class CatFrustum
 {
+public:
+	using SimdLevel = cat::SimdLevel;
+
 protected:
 	std::array< glm::vec4, 6 > m_aPlanes;
+	SimdLevel m_eSimdLevel = getSupportedSimdLevel();
 
 public:
+	[[nodiscard]] static SimdLevel getSupportedSimdLevel() { return GetSupportedSimdLevel(); }
+	// Clamped to the supported level, for comparing the implementations.
+	void setSimdLevel( const SimdLevel eLevel ) { m_eSimdLevel = std::min( eLevel, GetSupportedSimdLevel() ); }
+	[[nodiscard]] SimdLevel getSimdLevel() const { return m_eSimdLevel; }
+
 	void update( const glm::mat4 mxPV )
 	{
 		m_aPlanes[0].x = mxPV[0].w + mxPV[0].x;
@@ -52,7 +67,7 @@ public:
 		}
 	}
 
-	bool checkSphere( glm::vec3 vPosition, float fRadius )
+	bool checkSphere( glm::vec3 vPosition, float fRadius ) const
 	{
 		for ( auto& vPlane : m_aPlanes )
 		{
@@ -61,6 +76,30 @@ public:
 		return true;
 	}
 
+	// The box is outside if its corner furthest along a plane's normal is behind it.
+	bool checkAABB( glm::vec3 vMin, glm::vec3 vMax ) const
+	{
+		const auto vCenter = ( vMin + vMax ) * 0.5f;
+		const auto vExtent = ( vMax - vMin ) * 0.5f;
+		for ( auto& vPlane : m_aPlanes )
+		{
+			const auto vNormal = glm::vec3( vPlane );
+			if ( glm::dot( vNormal, vCenter ) + vPlane.w + glm::dot( glm::abs( vNormal ), vExtent ) < 0.0f ) return false;
+		}
+		return true;
+	}
+
+	// Batched versions of the tests above over SoA arrays, pVisible[i] is set to 1 if bound i is at least partially inside.
+	void checkSpheres( const float* pX, const float* pY, const float* pZ, const float* pRadius, size_t nCount, uint8_t* pVisible )
+		const;
+	void checkAABBs( const float* pCenterX,
+		const float* pCenterY,
+		const float* pCenterZ,
+		const float* pExtentX,
+		const float* pExtentY,
+		const float* pExtentZ,
+		size_t nCount,
+		uint8_t* pVisible ) const;
 
 	CAT_READONLY_PROPERTY( m_aPlanes, getPlanes, m_APlanes );
 };
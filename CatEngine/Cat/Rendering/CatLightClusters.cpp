@@ -0,0 +1,192 @@
+#include "CatLightClusters.hpp"
+
+#include "Cat/VulkanRHI/CatSwapChain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace cat
+{
+CatLightClusters::CatLightClusters( CatDevice* pDevice )
+	: m_pDevice{ pDevice }, m_aFrames( CatSwapChain::MAX_FRAMES_IN_FLIGHT )
+{
+	// The descriptor sets are written before the first frame, so every buffer has to exist up front.
+	for ( auto& frame : m_aFrames )
+	{
+		reserve( frame.pLights, sizeof( PointLight ), 0, 256 );
+		reserve( frame.pClusters, sizeof( glm::uvec2 ), CLUSTER_COUNT, CLUSTER_COUNT );
+		reserve( frame.pLightIndices, sizeof( uint32_t ), 0, 4096 );
+	}
+}
+
+float CatLightClusters::getLightRange( const glm::vec4& vColor )
+{
+	const float fIntensity = std::max( { vColor.r, vColor.g, vColor.b } ) * vColor.w;
+	return std::sqrt( std::max( fIntensity, 0.0f ) / LIGHT_CUTOFF );
+}
+
+bool CatLightClusters::reserve( std::unique_ptr< CatBuffer >& pBuffer,
+	const vk::DeviceSize nInstanceSize,
+	const size_t nCount,
+	const size_t nMinimum )
+{
+	if ( pBuffer && pBuffer->getInstanceCount() >= nCount ) return false;
+
+	if ( pBuffer )
+	{
+		m_pDevice->deferRelease( std::shared_ptr< CatBuffer >( std::move( pBuffer ) ) );
+	}
+	size_t nCapacity = nMinimum;
+	while ( nCapacity < nCount )
+	{
+		nCapacity *= 2;
+	}
+	pBuffer = std::make_unique< CatBuffer >( m_pDevice, nInstanceSize, static_cast< uint32_t >( nCapacity ),
+		vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible );
+	pBuffer->map();
+	return true;
+}
+
+bool CatLightClusters::update( const int nFrameIndex,
+	std::span< const PointLight > aLights,
+	const glm::mat4& mxView,
+	const glm::mat4& mxProjection,
+	const float fNear,
+	const float fFar,
+	const vk::Extent2D extent,
+	GlobalUbo& ubo )
+{
+	m_stats = {};
+	m_stats.nLights = static_cast< uint32_t >( aLights.size() );
+	m_aVisibleLights.clear();
+	m_aLightBounds.clear();
+	m_aClusters.assign( CLUSTER_COUNT, glm::uvec2( 0 ) );
+
+	// Depth slices grow exponentially, slice = log( depth ) * scale + bias.
+	const float fLogScale = static_cast< float >( CLUSTERS_Z ) / std::log( fFar / fNear );
+	const float fLogBias = -std::log( fNear ) * fLogScale;
+	const auto getSlice = [&]( const float fDepth )
+	{
+		const float fSlice = std::floor( std::log( std::max( fDepth, fNear ) ) * fLogScale + fLogBias );
+		return static_cast< uint32_t >( std::clamp( fSlice, 0.0f, static_cast< float >( CLUSTERS_Z - 1 ) ) );
+	};
+	const auto getTile = []( const float fNdc, const uint32_t nTiles )
+	{
+		const float fTile = std::floor( ( fNdc * 0.5f + 0.5f ) * static_cast< float >( nTiles ) );
+		return static_cast< uint32_t >( std::clamp( fTile, 0.0f, static_cast< float >( nTiles - 1 ) ) );
+	};
+
+	// Depth is the clip space w, the same the fragment shader gets back from gl_FragCoord.w.
+	const float fDepthScale = mxProjection[2][3];
+	const float fDepthBias = mxProjection[3][3];
+
+	for ( const auto& light : aLights )
+	{
+		const float fRange = light.position.w;
+		const auto vView = glm::vec3( mxView * glm::vec4( glm::vec3( light.position ), 1.0f ) );
+		const float fDepth = fDepthScale * vView.z + fDepthBias;
+		if ( fDepth + fRange < fNear || fDepth - fRange > fFar ) continue;
+
+		// The screen bounds of the view space box around the light's sphere, clamped to the near plane.
+		const float fMinDepth = std::max( fDepth - fRange, fNear );
+		const float fMaxDepth = std::min( fDepth + fRange, fFar );
+		glm::vec2 vNdcMin( std::numeric_limits< float >::max() );
+		glm::vec2 vNdcMax( std::numeric_limits< float >::lowest() );
+		for ( const float fCornerDepth : { fMinDepth, fMaxDepth } )
+		{
+			const float fZ = ( fCornerDepth - fDepthBias ) / fDepthScale;
+			for ( const float fX : { vView.x - fRange, vView.x + fRange } )
+			{
+				for ( const float fY : { vView.y - fRange, vView.y + fRange } )
+				{
+					const auto vClip = mxProjection * glm::vec4( fX, fY, fZ, 1.0f );
+					const auto vNdc = glm::vec2( vClip ) / vClip.w;
+					vNdcMin = glm::min( vNdcMin, vNdc );
+					vNdcMax = glm::max( vNdcMax, vNdc );
+				}
+			}
+		}
+		if ( vNdcMax.x < -1.0f || vNdcMin.x > 1.0f || vNdcMax.y < -1.0f || vNdcMin.y > 1.0f ) continue;
+
+		const LightBounds bounds{
+			.nLight = static_cast< uint32_t >( m_aVisibleLights.size() ),
+			.vMin = { getTile( vNdcMin.x, CLUSTERS_X ), getTile( vNdcMin.y, CLUSTERS_Y ), getSlice( fMinDepth ) },
+			.vMax = { getTile( vNdcMax.x, CLUSTERS_X ), getTile( vNdcMax.y, CLUSTERS_Y ), getSlice( fMaxDepth ) },
+		};
+		for ( uint32_t z = bounds.vMin.z; z <= bounds.vMax.z; ++z )
+		{
+			for ( uint32_t y = bounds.vMin.y; y <= bounds.vMax.y; ++y )
+			{
+				for ( uint32_t x = bounds.vMin.x; x <= bounds.vMax.x; ++x )
+				{
+					m_aClusters[x + CLUSTERS_X * ( y + CLUSTERS_Y * z )].y++;
+				}
+			}
+		}
+		m_aLightBounds.push_back( bounds );
+		m_aVisibleLights.push_back( light );
+	}
+
+	// Counts to offsets, then the second pass fills every cluster's range of the index list.
+	uint32_t nIndexCount = 0;
+	for ( auto& cluster : m_aClusters )
+	{
+		cluster.x = nIndexCount;
+		nIndexCount += cluster.y;
+		m_stats.nMaxClusterLights = std::max( m_stats.nMaxClusterLights, cluster.y );
+		cluster.y = 0;
+	}
+	m_aLightIndices.resize( nIndexCount );
+	for ( const auto& bounds : m_aLightBounds )
+	{
+		for ( uint32_t z = bounds.vMin.z; z <= bounds.vMax.z; ++z )
+		{
+			for ( uint32_t y = bounds.vMin.y; y <= bounds.vMax.y; ++y )
+			{
+				for ( uint32_t x = bounds.vMin.x; x <= bounds.vMax.x; ++x )
+				{
+					auto& cluster = m_aClusters[x + CLUSTERS_X * ( y + CLUSTERS_Y * z )];
+					m_aLightIndices[cluster.x + cluster.y++] = bounds.nLight;
+				}
+			}
+		}
+	}
+	m_stats.nVisibleLights = static_cast< uint32_t >( m_aVisibleLights.size() );
+	m_stats.nIndices = nIndexCount;
+
+	auto& frame = m_aFrames[nFrameIndex];
+	bool bReallocated = reserve( frame.pLights, sizeof( PointLight ), m_aVisibleLights.size(), 256 );
+	bReallocated |= reserve( frame.pLightIndices, sizeof( uint32_t ), m_aLightIndices.size(), 4096 );
+
+	std::memcpy( frame.pLights->getMappedMemory(), m_aVisibleLights.data(), m_aVisibleLights.size() * sizeof( PointLight ) );
+	std::memcpy( frame.pClusters->getMappedMemory(), m_aClusters.data(), m_aClusters.size() * sizeof( glm::uvec2 ) );
+	std::memcpy( frame.pLightIndices->getMappedMemory(), m_aLightIndices.data(), m_aLightIndices.size() * sizeof( uint32_t ) );
+	frame.pLights->flush();
+	frame.pClusters->flush();
+	frame.pLightIndices->flush();
+
+	ubo.clusterGrid = { CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z, m_stats.nVisibleLights };
+	ubo.clusterDepth = { fNear, fFar, fLogScale, fLogBias };
+	ubo.viewportSize = { static_cast< float >( extent.width ), static_cast< float >( extent.height ) };
+
+	return bReallocated;
+}
+
+void CatLightClusters::writeDescriptorSet( const int nFrameIndex,
+	CatDescriptorSetLayout& setLayout,
+	CatDescriptorPool& pool,
+	vk::DescriptorSet& descriptorSet )
+{
+	auto& frame = m_aFrames[nFrameIndex];
+	auto lightsInfo = frame.pLights->descriptorInfo();
+	auto clustersInfo = frame.pClusters->descriptorInfo();
+	auto lightIndicesInfo = frame.pLightIndices->descriptorInfo();
+	CatDescriptorWriter( setLayout, pool )
+		.writeBuffer( 1, &lightsInfo )
+		.writeBuffer( 2, &clustersInfo )
+		.writeBuffer( 3, &lightIndicesInfo )
+		.overwrite( descriptorSet );
+}
+} // namespace cat
@@ -0,0 +1,94 @@
+#ifndef CATENGINE_CATLIGHTCLUSTERS_HPP
+#define CATENGINE_CATLIGHTCLUSTERS_HPP
+
+#include "Cat/CatFrameInfo.hpp"
+#include "Cat/VulkanRHI/CatBuffer.hpp"
+#include "Cat/VulkanRHI/CatDescriptors.hpp"
+
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace cat
+{
+// Bins the point lights into a froxel grid, screen tiles split into exponential depth slices.
+// The fragment shader only iterates the lights of its own cluster, so its cost doesn't grow with the level's lights.
+class CatLightClusters
+{
+public:
+	static constexpr uint32_t CLUSTERS_X = 16;
+	static constexpr uint32_t CLUSTERS_Y = 9;
+	static constexpr uint32_t CLUSTERS_Z = 24;
+	static constexpr uint32_t CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+	// Light contribution below which a light is cut off, decides how far its cluster range reaches.
+	static constexpr float LIGHT_CUTOFF = 0.01f;
+
+	struct Stats
+	{
+		uint32_t nLights = 0;
+		uint32_t nVisibleLights = 0;
+		uint32_t nIndices = 0;
+		uint32_t nMaxClusterLights = 0;
+	};
+
+	explicit CatLightClusters( CatDevice* pDevice );
+
+	CatLightClusters( const CatLightClusters& ) = delete;
+	CatLightClusters& operator=( const CatLightClusters& ) = delete;
+
+	// Distance where the 1 / d^2 falloff of the light drops below LIGHT_CUTOFF.
+	[[nodiscard]] static float getLightRange( const glm::vec4& vColor );
+
+	// Bins the lights for the view and fills the frame's buffers and the cluster parameters of the UBO.
+	// Returns true if the buffers were reallocated, the frame's descriptor set has to be rewritten then.
+	bool update( int nFrameIndex,
+		std::span< const PointLight > aLights,
+		const glm::mat4& mxView,
+		const glm::mat4& mxProjection,
+		float fNear,
+		float fFar,
+		vk::Extent2D extent,
+		GlobalUbo& ubo );
+
+	// Writes bindings 1 to 3 of the global descriptor set: lights, clusters and light indices.
+	void writeDescriptorSet( int nFrameIndex,
+		CatDescriptorSetLayout& setLayout,
+		CatDescriptorPool& pool,
+		vk::DescriptorSet& descriptorSet );
+
+	[[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+private:
+	// Froxel index range a light touches, inclusive.
+	struct LightBounds
+	{
+		uint32_t nLight;
+		glm::uvec3 vMin;
+		glm::uvec3 vMax;
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr< CatBuffer > pLights;
+		// Offset and count into the light indices per cluster.
+		std::unique_ptr< CatBuffer > pClusters;
+		std::unique_ptr< CatBuffer > pLightIndices;
+	};
+
+	// Grows to a power of two, the old buffer is released once the frames using it finished.
+	bool reserve( std::unique_ptr< CatBuffer >& pBuffer, vk::DeviceSize nInstanceSize, size_t nCount, size_t nMinimum );
+
+	CatDevice* m_pDevice;
+	std::vector< FrameResources > m_aFrames;
+
+	std::vector< PointLight > m_aVisibleLights;
+	std::vector< LightBounds > m_aLightBounds;
+	std::vector< glm::uvec2 > m_aClusters;
+	std::vector< uint32_t > m_aLightIndices;
+
+	Stats m_stats;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATLIGHTCLUSTERS_HPP
@@ -0,0 +1,234 @@
+#include "CatRenderQueue.hpp"
+
+#include "Cat/Objects/CatModel.hpp"
+#include "Cat/VulkanRHI/CatGeometryPool.hpp"
+#include "Cat/VulkanRHI/CatPipeline.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace cat
+{
+namespace
+{
+constexpr uint32_t PIPELINE_BITS = 8;
+constexpr uint32_t DESCRIPTOR_SET_BITS = 8;
+constexpr uint32_t MODEL_BITS = 20;
+constexpr uint32_t DEPTH_BITS = 24;
+
+constexpr uint32_t PASS_SHIFT = PIPELINE_BITS + DESCRIPTOR_SET_BITS + MODEL_BITS + DEPTH_BITS;
+
+// The geometry page is the top of the model bits, so the models of a page are next to each other.
+constexpr uint32_t PAGE_BITS = std::bit_width( CatGeometryPool::MAX_PAGES - 1 );
+constexpr uint32_t MODEL_ID_BITS = MODEL_BITS - PAGE_BITS;
+
+constexpr uint64_t mask( const uint32_t nBits )
+{
+	return ( uint64_t( 1 ) << nBits ) - 1;
+}
+} // namespace
+
+uint64_t CatRenderQueue::makeKey( const Pass ePass,
+	const uint32_t nPipeline,
+	const uint32_t nDescriptorSet,
+	const uint32_t nModel,
+	const float fDepth )
+{
+	// Positive floats sort the same as their bits, the highest 24 below the sign bit are kept.
+	const uint64_t nDepth = std::bit_cast< uint32_t >( std::max( fDepth, 0.0f ) ) >> ( 31 - DEPTH_BITS );
+	// Pipeline and descriptor set, then the model.
+	const uint64_t nBinds =
+		( ( nPipeline & mask( PIPELINE_BITS ) ) << DESCRIPTOR_SET_BITS ) | ( nDescriptorSet & mask( DESCRIPTOR_SET_BITS ) );
+	const uint64_t nState = ( nBinds << MODEL_BITS ) | ( nModel & mask( MODEL_BITS ) );
+	const uint64_t nPass = static_cast< uint64_t >( ePass ) << PASS_SHIFT;
+
+	switch ( ePass )
+	{
+		case Pass::eDepthPrepass:
+		case Pass::eOpaque:
+		{
+			// Front to back inside a geometry page, so early depth testing rejects the hidden fragments
+			// while the page is still bound once.
+			const uint64_t nPage = ( nModel >> MODEL_ID_BITS ) & mask( PAGE_BITS );
+			const uint64_t nModelId = nModel & mask( MODEL_ID_BITS );
+			return nPass | ( nBinds << ( MODEL_BITS + DEPTH_BITS ) ) | ( nPage << ( MODEL_ID_BITS + DEPTH_BITS ) )
+				   | ( nDepth << MODEL_ID_BITS ) | nModelId;
+		}
+		case Pass::eTransparent:
+			// Strictly back to front for the blending, the state only breaks ties.
+			return nPass | ( ( ~nDepth & mask( DEPTH_BITS ) ) << ( PASS_SHIFT - DEPTH_BITS ) ) | nState;
+		default:
+			return nPass | ( nState << DEPTH_BITS ) | nDepth;
+	}
+}
+
+template < typename T >
+uint32_t CatRenderQueue::getId( std::unordered_map< T, uint32_t >& mIds, T key )
+{
+	return mIds.try_emplace( key, static_cast< uint32_t >( mIds.size() ) ).first->second;
+}
+
+void CatRenderQueue::begin()
+{
+	m_aEntries.clear();
+	m_aPushConstants.clear();
+	m_aItems.clear();
+	m_mPipelineIds.clear();
+	m_mDescriptorSetIds.clear();
+	m_mModelIds.clear();
+}
+
+void CatRenderQueue::submit( const Pass ePass,
+	const float fDepth,
+	const Packet& packet,
+	const void* pPushConstants,
+	const uint32_t nPushConstantSize,
+	const vk::ShaderStageFlags pushConstantStages )
+{
+	Entry entry{
+		.packet = packet,
+		.nPushConstantOffset = static_cast< uint32_t >( m_aPushConstants.size() ),
+		.nPushConstantSize = pPushConstants ? nPushConstantSize : 0,
+		.pushConstantStages = pushConstantStages,
+	};
+	if ( entry.nPushConstantSize > 0 )
+	{
+		m_aPushConstants.resize( m_aPushConstants.size() + entry.nPushConstantSize );
+		std::memcpy( m_aPushConstants.data() + entry.nPushConstantOffset, pPushConstants, entry.nPushConstantSize );
+	}
+
+	uint32_t nModel = 0;
+	if ( packet.pModel )
+	{
+		const auto nPage = std::min( packet.pModel->getGeometryPage(), CatGeometryPool::MAX_PAGES - 1 );
+		nModel = ( nPage << MODEL_ID_BITS ) | ( getId( m_mModelIds, packet.pModel ) & mask( MODEL_ID_BITS ) );
+	}
+	const auto nKey = makeKey( ePass, getId( m_mPipelineIds, static_cast< const CatPipeline* >( packet.pPipeline ) ),
+		getId( m_mDescriptorSetIds, static_cast< VkDescriptorSet >( packet.descriptorSet ) ), nModel, fDepth );
+
+	m_aItems.push_back( { nKey, static_cast< uint32_t >( m_aEntries.size() ) } );
+	m_aEntries.push_back( entry );
+}
+
+void CatRenderQueue::radixSort()
+{
+	// LSD radix sort a byte at a time, stable so equal keys keep their submission order.
+	m_aScratch.resize( m_aItems.size() );
+	for ( uint32_t nShift = 0; nShift < 64; nShift += 8 )
+	{
+		std::array< uint32_t, 256 > aCounts{};
+		for ( const auto& item : m_aItems )
+		{
+			aCounts[( item.nKey >> nShift ) & 0xFF]++;
+		}
+		// Every key has the same byte here, the pass wouldn't move anything.
+		if ( aCounts[( m_aItems.front().nKey >> nShift ) & 0xFF] == m_aItems.size() ) continue;
+
+		uint32_t nOffset = 0;
+		for ( auto& nCount : aCounts )
+		{
+			const auto nBucket = nCount;
+			nCount = nOffset;
+			nOffset += nBucket;
+		}
+		for ( const auto& item : m_aItems )
+		{
+			m_aScratch[aCounts[( item.nKey >> nShift ) & 0xFF]++] = item;
+		}
+		m_aItems.swap( m_aScratch );
+	}
+}
+
+void CatRenderQueue::sort()
+{
+	m_stats = { .nPackets = static_cast< uint32_t >( m_aItems.size() ) };
+	m_pBoundPipeline = nullptr;
+	m_boundLayout = nullptr;
+	m_boundDescriptorSet = nullptr;
+	m_boundInstanceBuffer = nullptr;
+	m_nBoundPage = CatGeometryPool::NO_PAGE;
+
+	if ( !m_aItems.empty() )
+	{
+		radixSort();
+	}
+}
+
+void CatRenderQueue::record( const vk::CommandBuffer commandBuffer, const Pass ePass )
+{
+	// The pass is the highest bits, its packets are one contiguous range after sorting.
+	const auto nPass = static_cast< uint64_t >( ePass );
+	const auto itBegin = std::lower_bound( m_aItems.begin(), m_aItems.end(), nPass,
+		[]( const SortItem& item, const uint64_t nValue ) { return ( item.nKey >> PASS_SHIFT ) < nValue; } );
+	const auto itEnd = std::upper_bound( itBegin, m_aItems.end(), nPass,
+		[]( const uint64_t nValue, const SortItem& item ) { return nValue < ( item.nKey >> PASS_SHIFT ); } );
+
+	for ( auto it = itBegin; it != itEnd; ++it )
+	{
+		const auto& entry = m_aEntries[it->nEntry];
+		const auto& packet = entry.packet;
+
+		if ( packet.pPipeline != m_pBoundPipeline )
+		{
+			packet.pPipeline->bind( commandBuffer );
+			m_pBoundPipeline = packet.pPipeline;
+			m_stats.nPipelineBinds++;
+		}
+		else
+		{
+			m_stats.nSkippedBinds++;
+		}
+
+		// Layouts with different push constant ranges aren't compatible, the set has to be bound again for those.
+		if ( packet.descriptorSet
+			 && ( packet.descriptorSet != m_boundDescriptorSet || packet.pipelineLayout != m_boundLayout ) )
+		{
+			commandBuffer.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics, packet.pipelineLayout, 0, 1, &packet.descriptorSet, 0, nullptr );
+			m_boundDescriptorSet = packet.descriptorSet;
+			m_boundLayout = packet.pipelineLayout;
+			m_stats.nDescriptorSetBinds++;
+		}
+		else if ( packet.descriptorSet )
+		{
+			m_stats.nSkippedBinds++;
+		}
+
+		if ( entry.nPushConstantSize > 0 )
+		{
+			commandBuffer.pushConstants( packet.pipelineLayout, entry.pushConstantStages, 0, entry.nPushConstantSize,
+				m_aPushConstants.data() + entry.nPushConstantOffset );
+		}
+
+		if ( packet.instanceBuffer && packet.instanceBuffer != m_boundInstanceBuffer )
+		{
+			const vk::DeviceSize nOffset = 0;
+			commandBuffer.bindVertexBuffers( CatModel::Instance::BINDING, 1, &packet.instanceBuffer, &nOffset );
+			m_boundInstanceBuffer = packet.instanceBuffer;
+			m_stats.nBufferBinds++;
+		}
+
+		if ( packet.pModel )
+		{
+			const auto nPreviousPage = m_nBoundPage;
+			packet.pModel->bind( commandBuffer, m_nBoundPage );
+			if ( m_nBoundPage != nPreviousPage )
+			{
+				m_stats.nBufferBinds++;
+			}
+			else
+			{
+				m_stats.nSkippedBinds++;
+			}
+			packet.pModel->draw( commandBuffer, packet.nInstanceCount, packet.nFirstInstance );
+		}
+		else
+		{
+			commandBuffer.draw( packet.nVertexCount, packet.nInstanceCount, 0, packet.nFirstInstance );
+		}
+		m_stats.nDraws++;
+	}
+}
+} // namespace cat
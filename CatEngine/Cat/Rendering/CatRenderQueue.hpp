@@ -0,0 +1,125 @@
+#ifndef CATENGINE_CATRENDERQUEUE_HPP
+#define CATENGINE_CATRENDERQUEUE_HPP
+
+#include "Cat/VulkanRHI/CatGeometryPool.hpp"
+
+#include "vulkan/vulkan.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace cat
+{
+class CatModel;
+class CatPipeline;
+
+// The render systems submit their draws here instead of recording them directly.
+// The packets are radix sorted on a 64 bit key once per frame and recorded in that order,
+// binds that would set the state that is already bound are skipped.
+class CatRenderQueue
+{
+public:
+	// Drawn in this order, the highest bits of the sort key.
+	enum class Pass : uint8_t
+	{
+		// Depth only, the opaque pass then only shades the visible fragments.
+		eDepthPrepass = 0,
+		eOpaque,
+		eTransparent,
+		eOverlay,
+	};
+
+	struct Packet
+	{
+		CatPipeline* pPipeline = nullptr;
+		vk::PipelineLayout pipelineLayout;
+		vk::DescriptorSet descriptorSet;
+		// Without a model nVertexCount vertices are drawn from no vertex buffer.
+		const CatModel* pModel = nullptr;
+		uint32_t nVertexCount = 0;
+		// Bound at CatModel::Instance::BINDING if set.
+		vk::Buffer instanceBuffer;
+		uint32_t nInstanceCount = 1;
+		uint32_t nFirstInstance = 0;
+	};
+
+	struct Stats
+	{
+		uint32_t nPackets = 0;
+		uint32_t nDraws = 0;
+		uint32_t nPipelineBinds = 0;
+		uint32_t nDescriptorSetBinds = 0;
+		// Geometry page and instance buffer binds.
+		uint32_t nBufferBinds = 0;
+		uint32_t nSkippedBinds = 0;
+	};
+
+	// The pass is in the highest bits. Overlays sort on pipeline, descriptor set, model and then depth, depth prepass and
+	// opaque packets go front to back below the descriptor set and transparent ones back to front right below the pass.
+	[[nodiscard]] static uint64_t makeKey( Pass ePass,
+		uint32_t nPipeline,
+		uint32_t nDescriptorSet,
+		uint32_t nModel,
+		float fDepth );
+
+	// Drops the packets of the previous frame.
+	void begin();
+	// fDepth is the distance from the camera, the push constants are copied.
+	void submit( Pass ePass,
+		float fDepth,
+		const Packet& packet,
+		const void* pPushConstants = nullptr,
+		uint32_t nPushConstantSize = 0,
+		vk::ShaderStageFlags pushConstantStages = {} );
+	// Sorts the submitted packets, called once before recording the passes.
+	void sort();
+	// Records the packets of one pass, has to be called inside the render pass.
+	void record( vk::CommandBuffer commandBuffer, Pass ePass );
+
+	// Counters of the last recorded frame.
+	[[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+private:
+	struct Entry
+	{
+		Packet packet;
+		uint32_t nPushConstantOffset = 0;
+		uint32_t nPushConstantSize = 0;
+		vk::ShaderStageFlags pushConstantStages;
+	};
+
+	struct SortItem
+	{
+		uint64_t nKey;
+		uint32_t nEntry;
+	};
+
+	// Small ids for the sort key, assigned in submission order every frame.
+	template < typename T >
+	static uint32_t getId( std::unordered_map< T, uint32_t >& mIds, T key );
+
+	void radixSort();
+
+	std::vector< Entry > m_aEntries;
+	std::vector< std::byte > m_aPushConstants;
+	std::vector< SortItem > m_aItems;
+	std::vector< SortItem > m_aScratch;
+
+	std::unordered_map< const CatPipeline*, uint32_t > m_mPipelineIds;
+	std::unordered_map< VkDescriptorSet, uint32_t > m_mDescriptorSetIds;
+	std::unordered_map< const CatModel*, uint32_t > m_mModelIds;
+
+	// Carried over between the passes of a frame, so they have to be recorded back to back.
+	// Nothing is known to be bound after sort(), the systems recording outside of the queue bind their own state.
+	CatPipeline* m_pBoundPipeline = nullptr;
+	vk::PipelineLayout m_boundLayout;
+	vk::DescriptorSet m_boundDescriptorSet;
+	vk::Buffer m_boundInstanceBuffer;
+	uint32_t m_nBoundPage = CatGeometryPool::NO_PAGE;
+
+	Stats m_stats;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATRENDERQUEUE_HPP
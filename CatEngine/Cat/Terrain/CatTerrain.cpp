@@ -100,22 +100,12 @@ void CatTerrain::generateTerrain()
 		}
 	}
 
-	CatBuffer vertexStagingBuffer{
-		m_pDevice,
-		sizeof( CatModel::Vertex ),
-		nVertexCount,
-		vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-	};
-	vertexStagingBuffer.map();
-	vertexStagingBuffer.writeToBuffer( pVertices );
-
 	uint32_t nVertexBufferSize = nVertexCount * sizeof( CatModel::Vertex );
 	m_pVertexBuffer = std::make_unique< CatBuffer >( m_pDevice, nVertexBufferSize, nVertexCount,
 		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
 		vk::MemoryPropertyFlagBits::eDeviceLocal );
 
-	m_pDevice->copyBuffer( *vertexStagingBuffer, **m_pVertexBuffer, nVertexBufferSize );
+	const auto fVerticesUploaded = m_pDevice->getUploader().uploadBuffer( **m_pVertexBuffer, pVertices, nVertexBufferSize );
 
 	delete[] pVertices;
 
@@ -136,24 +126,17 @@ void CatTerrain::generateTerrain()
 		}
 	}
 
-	CatBuffer indexStagingBuffer{
-		m_pDevice,
-		sizeof( uint32_t ),
-		m_nIndexCount,
-		vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-	};
-	indexStagingBuffer.map();
-	indexStagingBuffer.writeToBuffer( pIndices );
-
 	uint32_t nIndexBufferSize = m_nIndexCount * sizeof( uint32_t );
 	m_pIndexBuffer = std::make_unique< CatBuffer >( m_pDevice, nIndexBufferSize, m_nIndexCount,
 		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
 		vk::MemoryPropertyFlagBits::eDeviceLocal );
 
-	m_pDevice->copyBuffer( *indexStagingBuffer, **m_pIndexBuffer, nIndexBufferSize );
+	const auto fIndicesUploaded = m_pDevice->getUploader().uploadBuffer( **m_pIndexBuffer, pIndices, nIndexBufferSize );
 
 	delete[] pIndices;
+
+	fVerticesUploaded.wait();
+	fIndicesUploaded.wait();
 }
 
 float CatTerrain::getHeight( uint32_t x, uint32_t y ) const
@@ -17,9 +17,8 @@ CatTexture::CatTexture( CatDevice* pDevice,
 	vk::Flags< vk::ImageUsageFlagBits > usage )
 	: m_pDevice( pDevice )
 {
-	int texWidth, texHeight, texChannels;
+	int texWidth = 0, texHeight = 0, texChannels = 0;
 	m_pPixels = stbi_load( rFilename.c_str(), &texWidth, &texHeight, &texChannels, stbiFormat );
-	vk::DeviceSize imageSize = texWidth * texHeight * texChannels;
 
 	if ( !m_pPixels )
 	{
@@ -29,13 +28,9 @@ CatTexture::CatTexture( CatDevice* pDevice,
 	m_nWidth = static_cast< uint32_t >( texWidth );
 	m_nHeight = static_cast< uint32_t >( texHeight );
 
-	m_pStagingBuffer = new CatBuffer( m_pDevice, imageSize, 1, vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent );
-
-	m_pStagingBuffer->map();
-	m_pStagingBuffer->writeToBuffer( m_pPixels );
-
-	m_pStagingBuffer->unmap();
+	// The pixels are converted to the requested format, not the one in the file.
+	const int nChannels = stbiFormat != STBI_default ? stbiFormat : texChannels;
+	m_nImageSize = m_pPixels ? vk::DeviceSize( texWidth ) * texHeight * nChannels : 0;
 }
 
 CatTexture::CatTexture( cat::CatDevice* pDevice, const std::string& rFilename, vk::Flags< vk::ImageUsageFlagBits > usage )
@@ -56,13 +51,8 @@ CatTexture::CatTexture( cat::CatDevice* pDevice, const std::string& rFilename, v
 	m_rImageViewCreateInfo = dds::getVulkanImageViewCreateInfo( &image );
 	m_rImageViewCreateInfo.image = m_rImage;
 
-	m_pStagingBuffer = new CatBuffer( m_pDevice, image.arraySize, 1, vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent );
-
-	m_pStagingBuffer->map();
-	m_pStagingBuffer->writeToBuffer( image.data.data() );
-
-	m_pStagingBuffer->unmap();
+	m_nImageSize = image.data.size();
+	m_aImageData = std::move( image.data );
 }
 
 CatTexture::~CatTexture()
@@ -71,8 +61,7 @@ CatTexture::~CatTexture()
 	( **m_pDevice ).destroyImageView( m_rImageView );
 	( **m_pDevice ).destroyImage( m_rImage );
 	( **m_pDevice ).destroySampler( m_rSampler );
-	( **m_pDevice ).freeMemory( m_rImageMemory );
-	delete m_pStagingBuffer;
+	m_pDevice->getAllocator().free( m_rImageAllocation );
 }
 
 void CatTexture::updateDescriptor()
@@ -103,19 +92,17 @@ CatTexture2D::CatTexture2D( CatDevice* pDevice,
 		.initialLayout = vk::ImageLayout::eUndefined,
 	};
 
-	m_pDevice->createImageWithInfo( imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_rImage, m_rImageMemory );
-
-	m_pDevice->transitionImageLayout(
-		m_rImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, { aspectMask, 0, 1, 0, 1 } );
-
-	m_pDevice->copyBufferToImage(
-		m_pStagingBuffer->getBuffer(), m_rImage, { m_nWidth, m_nHeight, 1 }, { aspectMask, 0, 0, 1 } );
+	m_pDevice->createImageWithInfo( imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_rImage, m_rImageAllocation );
 
-	m_pDevice->transitionImageLayout(
-		m_rImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, { aspectMask, 0, 1, 0, 1 } );
-
-	delete m_pStagingBuffer;
-	m_pStagingBuffer = nullptr;
+	m_fUploaded = m_pDevice->getUploader().uploadImage( m_rImage, m_pPixels, m_nImageSize,
+		{
+			vk::BufferImageCopy{
+				.bufferOffset = 0,
+				.imageSubresource = { aspectMask, 0, 0, 1 },
+				.imageExtent = { m_nWidth, m_nHeight, 1 },
+			},
+		},
+		{ aspectMask, 0, 1, 0, 1 } );
 
 	vk::SamplerCreateInfo samplerCreateInfo{
 		.magFilter = vk::Filter::eLinear,
@@ -154,6 +141,9 @@ CatTexture2D::CatTexture2D( CatDevice* pDevice,
 	}
 
 	updateDescriptor();
+
+	// The descriptor may be used by the next frame.
+	m_fUploaded.wait();
 }
 
 CatTexture2D::CatTexture2D( CatDevice* pDevice,
@@ -161,24 +151,26 @@ CatTexture2D::CatTexture2D( CatDevice* pDevice,
 	vk::Flags< vk::ImageUsageFlagBits > usage /* = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled */ )
 	: CatTexture( pDevice, rFilename, usage )
 {
-	m_pDevice->createImageWithInfo( m_rImageCreateInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_rImage, m_rImageMemory );
+	m_pDevice->createImageWithInfo( m_rImageCreateInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_rImage, m_rImageAllocation );
 
-	m_pDevice->transitionImageLayout(
-		m_rImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, m_rImageViewCreateInfo.subresourceRange );
-
-	m_pDevice->copyBufferToImage( m_pStagingBuffer->getBuffer(), m_rImage, m_rImageCreateInfo.extent,
+	m_fUploaded = m_pDevice->getUploader().uploadImage( m_rImage, m_aImageData.data(), m_nImageSize,
 		{
-			m_rImageViewCreateInfo.subresourceRange.aspectMask,
-			0,
-			m_rImageViewCreateInfo.subresourceRange.baseArrayLayer,
-			m_rImageViewCreateInfo.subresourceRange.layerCount,
-		} );
-
-	m_pDevice->transitionImageLayout( m_rImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::BufferImageCopy{
+				.bufferOffset = 0,
+				.imageSubresource =
+					{
+						m_rImageViewCreateInfo.subresourceRange.aspectMask,
+						0,
+						m_rImageViewCreateInfo.subresourceRange.baseArrayLayer,
+						m_rImageViewCreateInfo.subresourceRange.layerCount,
+					},
+				.imageExtent = m_rImageCreateInfo.extent,
+			},
+		},
 		m_rImageViewCreateInfo.subresourceRange );
 
-	delete m_pStagingBuffer;
-	m_pStagingBuffer = nullptr;
+	// Already copied to the staging ring.
+	m_aImageData = {};
 
 	vk::SamplerCreateInfo samplerCreateInfo{
 		.magFilter = vk::Filter::eLinear,
@@ -209,5 +201,8 @@ CatTexture2D::CatTexture2D( CatDevice* pDevice,
 	}
 
 	updateDescriptor();
+
+	// The descriptor may be used by the next frame.
+	m_fUploaded.wait();
 }
 } // namespace cat
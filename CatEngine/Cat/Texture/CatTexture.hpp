@@ -27,8 +27,7 @@ protected:
 	vk::Image m_rImage;
 	vk::ImageLayout m_rImageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
 	vk::ImageView m_rImageView;
-	vk::DeviceMemory m_rImageMemory;
-	CatBuffer* m_pStagingBuffer;
+	CatAllocation m_rImageAllocation;
 	uint32_t m_nWidth, m_nHeight;
 	uint32_t m_nMipLevels;
 	uint32_t m_nLayerCount;
@@ -37,7 +36,11 @@ protected:
 	vk::ImageCreateInfo m_rImageCreateInfo;
 	vk::ImageViewCreateInfo m_rImageViewCreateInfo;
 	vk::Format m_rImageFormat;
-	stbi_uc* m_pPixels;
+	stbi_uc* m_pPixels = nullptr;
+	// DDS content, the STBI loader uploads m_pPixels.
+	std::vector< uint8_t > m_aImageData;
+	vk::DeviceSize m_nImageSize = 0;
+	std::shared_future< void > m_fUploaded;
 
 	void updateDescriptor();
 
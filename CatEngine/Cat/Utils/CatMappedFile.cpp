@@ -0,0 +1,135 @@
+#include "CatMappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cat
+{
+CatMappedFile::CatMappedFile( const std::string& sPath )
+{
+	open( sPath );
+}
+
+CatMappedFile::~CatMappedFile()
+{
+	close();
+}
+
+CatMappedFile::CatMappedFile( CatMappedFile&& other ) noexcept
+{
+	*this = std::move( other );
+}
+
+CatMappedFile& CatMappedFile::operator=( CatMappedFile&& other ) noexcept
+{
+	if ( this == &other ) return *this;
+
+	close();
+	m_pData = std::exchange( other.m_pData, nullptr );
+	m_nSize = std::exchange( other.m_nSize, 0 );
+#ifdef _WIN32
+	m_hFile = std::exchange( other.m_hFile, nullptr );
+	m_hMapping = std::exchange( other.m_hMapping, nullptr );
+#else
+	m_nFd = std::exchange( other.m_nFd, -1 );
+#endif
+	return *this;
+}
+
+bool CatMappedFile::open( const std::string& sPath )
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(
+		sPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( hFile == INVALID_HANDLE_VALUE ) return false;
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( hFile, &size ) || size.QuadPart == 0 )
+	{
+		CloseHandle( hFile );
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( !hMapping )
+	{
+		CloseHandle( hFile );
+		return false;
+	}
+
+	auto pView = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( !pView )
+	{
+		CloseHandle( hMapping );
+		CloseHandle( hFile );
+		return false;
+	}
+
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_pData = static_cast< const std::byte* >( pView );
+	m_nSize = static_cast< size_t >( size.QuadPart );
+#else
+	int nFd = ::open( sPath.c_str(), O_RDONLY );
+	if ( nFd < 0 ) return false;
+
+	struct stat info
+	{
+	};
+	if ( fstat( nFd, &info ) != 0 || info.st_size == 0 )
+	{
+		::close( nFd );
+		return false;
+	}
+
+	auto pView = mmap( nullptr, static_cast< size_t >( info.st_size ), PROT_READ, MAP_PRIVATE, nFd, 0 );
+	if ( pView == MAP_FAILED )
+	{
+		::close( nFd );
+		return false;
+	}
+
+	m_nFd = nFd;
+	m_pData = static_cast< const std::byte* >( pView );
+	m_nSize = static_cast< size_t >( info.st_size );
+#endif
+
+	return true;
+}
+
+void CatMappedFile::close()
+{
+	if ( !m_pData ) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile( m_pData );
+	CloseHandle( m_hMapping );
+	CloseHandle( m_hFile );
+	m_hMapping = nullptr;
+	m_hFile = nullptr;
+#else
+	munmap( const_cast< std::byte* >( m_pData ), m_nSize );
+	::close( m_nFd );
+	m_nFd = -1;
+#endif
+
+	m_pData = nullptr;
+	m_nSize = 0;
+}
+} // namespace cat
@@ -0,0 +1,43 @@
+#ifndef CATENGINE_CATMAPPEDFILE_HPP
+#define CATENGINE_CATMAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cat
+{
+// Read-only memory mapped view of a whole file.
+class CatMappedFile
+{
+public:
+	CatMappedFile() = default;
+	explicit CatMappedFile( const std::string& sPath );
+	~CatMappedFile();
+
+	CatMappedFile( const CatMappedFile& ) = delete;
+	CatMappedFile& operator=( const CatMappedFile& ) = delete;
+	CatMappedFile( CatMappedFile&& other ) noexcept;
+	CatMappedFile& operator=( CatMappedFile&& other ) noexcept;
+
+	bool open( const std::string& sPath );
+	void close();
+
+	[[nodiscard]] bool isOpen() const { return m_pData != nullptr; }
+	[[nodiscard]] const std::byte* data() const { return m_pData; }
+	[[nodiscard]] size_t size() const { return m_nSize; }
+
+private:
+	const std::byte* m_pData = nullptr;
+	size_t m_nSize = 0;
+
+#ifdef _WIN32
+	void* m_hFile = nullptr;
+	void* m_hMapping = nullptr;
+#else
+	int m_nFd = -1;
+#endif
+};
+} // namespace cat
+
+#endif // CATENGINE_CATMAPPEDFILE_HPP
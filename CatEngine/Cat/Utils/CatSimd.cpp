@@ -0,0 +1,40 @@
+#include "CatSimd.hpp"
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#endif
+
+namespace cat
+{
+#ifdef CAT_SIMD_X86
+static SimdLevel DetectSimdLevel()
+{
+#if defined( _MSC_VER ) && !defined( __clang__ )
+	int aInfo[4] = {};
+	__cpuid( aInfo, 1 );
+	const bool bSSE2 = aInfo[3] & ( 1 << 26 );
+	// The OS has to save the YMM registers on context switches as well.
+	const bool bOsAVX = ( aInfo[2] & ( 1 << 27 ) ) && ( aInfo[2] & ( 1 << 28 ) ) && ( _xgetbv( 0 ) & 6 ) == 6;
+	__cpuidex( aInfo, 7, 0 );
+	const bool bAVX2 = bOsAVX && ( aInfo[1] & ( 1 << 5 ) );
+#else
+	__builtin_cpu_init();
+	const bool bSSE2 = __builtin_cpu_supports( "sse2" );
+	const bool bAVX2 = __builtin_cpu_supports( "avx2" );
+#endif
+	if ( bAVX2 ) return SimdLevel::eAVX2;
+	if ( bSSE2 ) return SimdLevel::eSSE;
+	return SimdLevel::eScalar;
+}
+#endif // CAT_SIMD_X86
+
+SimdLevel GetSupportedSimdLevel()
+{
+#ifdef CAT_SIMD_X86
+	static const SimdLevel eLevel = DetectSimdLevel();
+	return eLevel;
+#else
+	return SimdLevel::eScalar;
+#endif
+}
+} // namespace cat
@@ -0,0 +1,31 @@
+#ifndef CATENGINE_CATSIMD_HPP
+#define CATENGINE_CATSIMD_HPP
+
+#include <cstdint>
+
+#if defined( _M_X64 ) || defined( __x86_64__ )
+#define CAT_SIMD_X86 1
+#include <immintrin.h>
+#if defined( _MSC_VER ) && !defined( __clang__ )
+// MSVC emits any instruction set without flags, the caller checks the CPU.
+#define CAT_TARGET_AVX2
+#else
+#define CAT_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+namespace cat
+{
+// Instruction sets the batched code paths are written for.
+enum class SimdLevel : uint8_t
+{
+	eScalar,
+	eSSE,
+	eAVX2,
+};
+
+// The best instruction set the CPU and OS support, detected once.
+[[nodiscard]] SimdLevel GetSupportedSimdLevel();
+} // namespace cat
+
+#endif // CATENGINE_CATSIMD_HPP
@@ -0,0 +1,507 @@
+#include "CatAllocator.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace cat
+{
+static vk::DeviceSize AlignUp( const vk::DeviceSize nValue, const vk::DeviceSize nAlignment )
+{
+	return ( nValue + nAlignment - 1 ) / nAlignment * nAlignment;
+}
+
+static vk::DeviceSize AlignDown( const vk::DeviceSize nValue, const vk::DeviceSize nAlignment )
+{
+	return nValue / nAlignment * nAlignment;
+}
+
+CatAllocator::CatAllocator( const vk::PhysicalDevice physicalDevice, const vk::Device device ) : m_device{ device }
+{
+	physicalDevice.getMemoryProperties( &m_memoryProperties );
+
+	const auto properties = physicalDevice.getProperties();
+	m_nNonCoherentAtomSize = std::max< vk::DeviceSize >( properties.limits.nonCoherentAtomSize, 1 );
+	m_nMaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+	m_aMemoryTypes.resize( m_memoryProperties.memoryTypeCount );
+}
+
+CatAllocator::~CatAllocator()
+{
+	for ( auto& memoryType : m_aMemoryTypes )
+	{
+		for ( auto& aBlocks : memoryType.aLists )
+		{
+			for ( auto& pBlock : aBlocks )
+			{
+				if ( pBlock->nAllocations )
+				{
+					LOG_F( WARNING, "Memory block %u destroyed with %u live allocations", pBlock->nId, pBlock->nAllocations );
+				}
+				destroyBlock( *pBlock );
+			}
+		}
+		if ( memoryType.nDedicated )
+		{
+			LOG_F( WARNING, "%u dedicated allocations were not freed", memoryType.nDedicated );
+		}
+	}
+}
+
+uint32_t CatAllocator::findMemoryType( const uint32_t nTypeFilter, const vk::MemoryPropertyFlags properties ) const
+{
+	for ( uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++ )
+	{
+		if ( ( nTypeFilter & ( 1 << i ) ) && ( m_memoryProperties.memoryTypes[i].propertyFlags & properties ) == properties )
+		{
+			return i;
+		}
+	}
+
+	throw std::runtime_error( "failed to find suitable memory type!" );
+}
+
+vk::DeviceSize CatAllocator::getBlockSize( const uint32_t nMemoryType ) const
+{
+	const auto nHeapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[nMemoryType].heapIndex].size;
+	return nHeapSize < SMALL_HEAP_SIZE ? AlignUp( nHeapSize / 8, m_nNonCoherentAtomSize ) : BLOCK_SIZE;
+}
+
+bool CatAllocator::isHostVisible( const uint32_t nMemoryType ) const
+{
+	return bool( m_memoryProperties.memoryTypes[nMemoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible );
+}
+
+bool CatAllocator::isCoherent( const uint32_t nMemoryType ) const
+{
+	return bool( m_memoryProperties.memoryTypes[nMemoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent );
+}
+
+size_t CatAllocator::getListIndex( const ResourceKind eKind, const AllocationStrategy eStrategy )
+{
+	if ( eStrategy == AllocationStrategy::eLinear ) return 2;
+	return eKind == ResourceKind::eImage ? 1 : 0;
+}
+
+vk::DeviceMemory CatAllocator::allocateMemory( const vk::DeviceSize nSize, const uint32_t nMemoryType, std::byte*& pMapped )
+{
+	const vk::MemoryAllocateInfo allocInfo{
+		.allocationSize = nSize,
+		.memoryTypeIndex = nMemoryType,
+	};
+
+	vk::DeviceMemory memory;
+	if ( m_device.allocateMemory( &allocInfo, nullptr, &memory ) != vk::Result::eSuccess )
+	{
+		return nullptr;
+	}
+	++m_nDeviceAllocations;
+
+	pMapped = nullptr;
+	if ( isHostVisible( nMemoryType ) )
+	{
+		void* pData = nullptr;
+		if ( m_device.mapMemory( memory, 0, VK_WHOLE_SIZE, {}, &pData ) != vk::Result::eSuccess )
+		{
+			m_device.freeMemory( memory );
+			--m_nDeviceAllocations;
+			throw std::runtime_error( "failed to map device memory!" );
+		}
+		pMapped = static_cast< std::byte* >( pData );
+	}
+	return memory;
+}
+
+CatAllocation CatAllocator::allocateDedicated( const vk::DeviceSize nSize,
+	const uint32_t nMemoryType,
+	const ResourceKind eKind )
+{
+	std::byte* pMapped = nullptr;
+	const auto memory = allocateMemory( nSize, nMemoryType, pMapped );
+	if ( !memory )
+	{
+		throw std::runtime_error( "failed to allocate device memory!" );
+	}
+
+	auto& memoryType = m_aMemoryTypes[nMemoryType];
+	memoryType.nDedicated++;
+	memoryType.nDedicatedSize += nSize;
+
+	return CatAllocation{
+		.memory = memory,
+		.nOffset = 0,
+		.nSize = nSize,
+		.pMapped = pMapped,
+		.nMemoryType = nMemoryType,
+		.nBlockId = 0,
+		.eStrategy = AllocationStrategy::eDedicated,
+		.eKind = eKind,
+	};
+}
+
+bool CatAllocator::allocateFromBlock( Block& block,
+	const vk::DeviceSize nSize,
+	const vk::DeviceSize nAlignment,
+	const AllocationStrategy eStrategy,
+	vk::DeviceSize& nOffset )
+{
+	if ( eStrategy == AllocationStrategy::eLinear )
+	{
+		nOffset = AlignUp( block.nHead, nAlignment );
+		if ( nOffset + nSize > block.nSize ) return false;
+
+		block.nHead = nOffset + nSize;
+		return true;
+	}
+
+	// Best fit keeps the large ranges for large resources.
+	auto itBest = block.mFreeRanges.end();
+	for ( auto it = block.mFreeRanges.begin(); it != block.mFreeRanges.end(); ++it )
+	{
+		const auto nAligned = AlignUp( it->first, nAlignment );
+		if ( nAligned + nSize > it->first + it->second ) continue;
+		if ( itBest == block.mFreeRanges.end() || it->second < itBest->second )
+		{
+			itBest = it;
+		}
+	}
+	if ( itBest == block.mFreeRanges.end() ) return false;
+
+	const auto [nRangeOffset, nRangeSize] = *itBest;
+	block.mFreeRanges.erase( itBest );
+
+	nOffset = AlignUp( nRangeOffset, nAlignment );
+	// The padding in front stays free and merges back once the neighbour is freed.
+	if ( nOffset > nRangeOffset )
+	{
+		block.mFreeRanges.emplace( nRangeOffset, nOffset - nRangeOffset );
+	}
+	const auto nEnd = nOffset + nSize;
+	if ( nEnd < nRangeOffset + nRangeSize )
+	{
+		block.mFreeRanges.emplace( nEnd, nRangeOffset + nRangeSize - nEnd );
+	}
+	return true;
+}
+
+std::unique_ptr< CatAllocator::Block > CatAllocator::createBlock( const uint32_t nMemoryType,
+	const vk::DeviceSize nMinSize,
+	const bool bLinear )
+{
+	auto pBlock = std::make_unique< Block >();
+
+	// Retry with smaller blocks if the heap is nearly full.
+	auto nSize = getBlockSize( nMemoryType );
+	while ( !pBlock->memory && nSize >= nMinSize )
+	{
+		pBlock->memory = allocateMemory( nSize, nMemoryType, pBlock->pMapped );
+		if ( !pBlock->memory ) nSize /= 2;
+	}
+	if ( !pBlock->memory ) return nullptr;
+
+	pBlock->nId = m_nNextBlockId++;
+	pBlock->nSize = nSize;
+	if ( !bLinear )
+	{
+		pBlock->mFreeRanges.emplace( 0, nSize );
+	}
+
+	DLOG_F( INFO, "Allocated memory block %u: %.1f MB of memory type %u", pBlock->nId, double( nSize ) / ( 1024.0 * 1024.0 ),
+		nMemoryType );
+	return pBlock;
+}
+
+void CatAllocator::destroyBlock( Block& block )
+{
+	// Freeing implicitly unmaps.
+	m_device.freeMemory( block.memory );
+	--m_nDeviceAllocations;
+	block.memory = nullptr;
+	block.pMapped = nullptr;
+}
+
+CatAllocation CatAllocator::allocate( const vk::MemoryRequirements& requirements,
+	const vk::MemoryPropertyFlags properties,
+	const ResourceKind eKind,
+	AllocationStrategy eStrategy )
+{
+	const auto nMemoryType = findMemoryType( requirements.memoryTypeBits, properties );
+
+	// Non coherent ranges are flushed in whole atoms, allocations never share one.
+	auto nAlignment = std::max< vk::DeviceSize >( requirements.alignment, 1 );
+	auto nSize = requirements.size;
+	if ( isHostVisible( nMemoryType ) && !isCoherent( nMemoryType ) )
+	{
+		nAlignment = std::max( nAlignment, m_nNonCoherentAtomSize );
+		nSize = AlignUp( nSize, m_nNonCoherentAtomSize );
+	}
+
+	if ( eKind == ResourceKind::eImage && eStrategy == AllocationStrategy::eLinear )
+	{
+		eStrategy = AllocationStrategy::eFreeList;
+	}
+
+	const std::lock_guard lock( m_mutex );
+
+	if ( eStrategy == AllocationStrategy::eDedicated || nSize > getBlockSize( nMemoryType ) / 2 )
+	{
+		return allocateDedicated( nSize, nMemoryType, eKind );
+	}
+
+	auto& aBlocks = m_aMemoryTypes[nMemoryType].aLists[getListIndex( eKind, eStrategy )];
+
+	Block* pBlock = nullptr;
+	vk::DeviceSize nOffset = 0;
+	for ( auto& pCandidate : aBlocks )
+	{
+		if ( std::ranges::find( m_aExcludedBlocks, pCandidate->nId ) != m_aExcludedBlocks.end() ) continue;
+		if ( allocateFromBlock( *pCandidate, nSize, nAlignment, eStrategy, nOffset ) )
+		{
+			pBlock = pCandidate.get();
+			break;
+		}
+	}
+
+	if ( !pBlock )
+	{
+		auto pNewBlock = createBlock( nMemoryType, nSize, eStrategy == AllocationStrategy::eLinear );
+		if ( !pNewBlock )
+		{
+			// Nothing fits in the heap, a dedicated allocation of the exact size is the last resort.
+			LOG_F( WARNING, "Out of memory for a new block of memory type %u, falling back to a dedicated allocation",
+				nMemoryType );
+			return allocateDedicated( nSize, nMemoryType, eKind );
+		}
+		pBlock = pNewBlock.get();
+		aBlocks.push_back( std::move( pNewBlock ) );
+
+		const bool bAllocated = allocateFromBlock( *pBlock, nSize, nAlignment, eStrategy, nOffset );
+		CHECK_F( bAllocated, "Allocation doesn't fit in a new block" );
+	}
+
+	pBlock->nUsed += nSize;
+	pBlock->nAllocations++;
+
+	return CatAllocation{
+		.memory = pBlock->memory,
+		.nOffset = nOffset,
+		.nSize = nSize,
+		.pMapped = pBlock->pMapped ? pBlock->pMapped + nOffset : nullptr,
+		.nMemoryType = nMemoryType,
+		.nBlockId = pBlock->nId,
+		.eStrategy = eStrategy,
+		.eKind = eKind,
+	};
+}
+
+void CatAllocator::free( CatAllocation& allocation )
+{
+	if ( !allocation ) return;
+
+	const std::lock_guard lock( m_mutex );
+	auto& memoryType = m_aMemoryTypes[allocation.nMemoryType];
+
+	if ( allocation.eStrategy == AllocationStrategy::eDedicated )
+	{
+		m_device.freeMemory( allocation.memory );
+		--m_nDeviceAllocations;
+		memoryType.nDedicated--;
+		memoryType.nDedicatedSize -= allocation.nSize;
+		allocation = {};
+		return;
+	}
+
+	auto& aBlocks = memoryType.aLists[getListIndex( allocation.eKind, allocation.eStrategy )];
+	const auto it = std::ranges::find_if( aBlocks, [&]( const auto& pBlock ) { return pBlock->nId == allocation.nBlockId; } );
+	CHECK_F( it != aBlocks.end(), "Freeing an allocation from unknown block %u", allocation.nBlockId );
+
+	auto& block = **it;
+	block.nUsed -= allocation.nSize;
+	block.nAllocations--;
+
+	if ( allocation.eStrategy == AllocationStrategy::eLinear )
+	{
+		if ( block.nAllocations == 0 ) block.nHead = 0;
+	}
+	else
+	{
+		auto nOffset = allocation.nOffset;
+		auto nSize = allocation.nSize;
+
+		// Merge with the free ranges on both sides.
+		auto itNext = block.mFreeRanges.lower_bound( nOffset );
+		if ( itNext != block.mFreeRanges.begin() )
+		{
+			const auto itPrev = std::prev( itNext );
+			if ( itPrev->first + itPrev->second == nOffset )
+			{
+				nOffset = itPrev->first;
+				nSize += itPrev->second;
+				block.mFreeRanges.erase( itPrev );
+			}
+		}
+		if ( itNext != block.mFreeRanges.end() && nOffset + nSize == itNext->first )
+		{
+			nSize += itNext->second;
+			block.mFreeRanges.erase( itNext );
+		}
+		block.mFreeRanges.emplace( nOffset, nSize );
+	}
+
+	allocation = {};
+}
+
+vk::Result CatAllocator::flush( const CatAllocation& allocation, const vk::DeviceSize nOffset, const vk::DeviceSize nSize )
+{
+	if ( isCoherent( allocation.nMemoryType ) ) return vk::Result::eSuccess;
+
+	const auto nBegin = AlignDown( allocation.nOffset + nOffset, m_nNonCoherentAtomSize );
+	const auto nEnd = nSize == VK_WHOLE_SIZE
+		? allocation.nOffset + allocation.nSize
+		: std::min(
+			AlignUp( allocation.nOffset + nOffset + nSize, m_nNonCoherentAtomSize ), allocation.nOffset + allocation.nSize );
+
+	const vk::MappedMemoryRange mappedRange{
+		.memory = allocation.memory,
+		.offset = nBegin,
+		.size = nEnd - nBegin,
+	};
+	return m_device.flushMappedMemoryRanges( 1, &mappedRange );
+}
+
+vk::Result CatAllocator::invalidate( const CatAllocation& allocation, const vk::DeviceSize nOffset, const vk::DeviceSize nSize )
+{
+	if ( isCoherent( allocation.nMemoryType ) ) return vk::Result::eSuccess;
+
+	const auto nBegin = AlignDown( allocation.nOffset + nOffset, m_nNonCoherentAtomSize );
+	const auto nEnd = nSize == VK_WHOLE_SIZE
+		? allocation.nOffset + allocation.nSize
+		: std::min(
+			AlignUp( allocation.nOffset + nOffset + nSize, m_nNonCoherentAtomSize ), allocation.nOffset + allocation.nSize );
+
+	const vk::MappedMemoryRange mappedRange{
+		.memory = allocation.memory,
+		.offset = nBegin,
+		.size = nEnd - nBegin,
+	};
+	return m_device.invalidateMappedMemoryRanges( 1, &mappedRange );
+}
+
+void CatAllocator::releaseEmptyBlocks()
+{
+	const std::lock_guard lock( m_mutex );
+	for ( auto& memoryType : m_aMemoryTypes )
+	{
+		for ( auto& aBlocks : memoryType.aLists )
+		{
+			bool bKeptOne = false;
+			std::erase_if( aBlocks,
+				[&]( const std::unique_ptr< Block >& pBlock )
+				{
+					if ( pBlock->nAllocations ) return false;
+					if ( !bKeptOne && std::ranges::find( m_aExcludedBlocks, pBlock->nId ) == m_aExcludedBlocks.end() )
+					{
+						bKeptOne = true;
+						return false;
+					}
+					DLOG_F( INFO, "Released memory block %u", pBlock->nId );
+					destroyBlock( *pBlock );
+					return true;
+				} );
+		}
+	}
+}
+
+std::vector< uint32_t > CatAllocator::getDefragmentationCandidates( const float fMaxUsage )
+{
+	const std::lock_guard lock( m_mutex );
+	std::vector< uint32_t > aBlockIds;
+	for ( auto& memoryType : m_aMemoryTypes )
+	{
+		// Linear blocks empty themselves.
+		for ( const auto eKind : { ResourceKind::eBuffer, ResourceKind::eImage } )
+		{
+			const auto& aBlocks = memoryType.aLists[getListIndex( eKind, AllocationStrategy::eFreeList )];
+			// The resources need somewhere else to go.
+			if ( aBlocks.size() < 2 ) continue;
+
+			for ( const auto& pBlock : aBlocks )
+			{
+				if ( pBlock->nAllocations && float( pBlock->nUsed ) < fMaxUsage * float( pBlock->nSize ) )
+				{
+					aBlockIds.push_back( pBlock->nId );
+				}
+			}
+		}
+	}
+	return aBlockIds;
+}
+
+void CatAllocator::setExcludedBlocks( std::vector< uint32_t > aBlockIds )
+{
+	const std::lock_guard lock( m_mutex );
+	m_aExcludedBlocks = std::move( aBlockIds );
+}
+
+bool CatAllocator::isInBlocks( const CatAllocation& allocation, const std::vector< uint32_t >& aBlockIds )
+{
+	return allocation.nBlockId && std::ranges::find( aBlockIds, allocation.nBlockId ) != aBlockIds.end();
+}
+
+std::vector< CatAllocator::HeapStats > CatAllocator::getHeapStats()
+{
+	std::vector< HeapStats > aStats( m_memoryProperties.memoryHeapCount );
+	for ( uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; ++i )
+	{
+		aStats[i].nHeapSize = m_memoryProperties.memoryHeaps[i].size;
+		aStats[i].flags = m_memoryProperties.memoryHeaps[i].flags;
+	}
+
+	const std::lock_guard lock( m_mutex );
+	for ( uint32_t nType = 0; nType < m_aMemoryTypes.size(); ++nType )
+	{
+		const auto& memoryType = m_aMemoryTypes[nType];
+		auto& stats = aStats[m_memoryProperties.memoryTypes[nType].heapIndex];
+
+		stats.nReserved += memoryType.nDedicatedSize;
+		stats.nUsed += memoryType.nDedicatedSize;
+		stats.nDedicated += memoryType.nDedicated;
+		stats.nAllocations += memoryType.nDedicated;
+
+		for ( size_t i = 0; i < LIST_COUNT; ++i )
+		{
+			for ( const auto& pBlock : memoryType.aLists[i] )
+			{
+				stats.nBlocks++;
+				stats.nReserved += pBlock->nSize;
+				stats.nUsed += pBlock->nUsed;
+				stats.nAllocations += pBlock->nAllocations;
+
+				if ( i == getListIndex( ResourceKind::eBuffer, AllocationStrategy::eLinear ) )
+				{
+					// Freed space behind the head is only reusable once the block is empty.
+					stats.nFreeRanges++;
+					stats.nLargestFreeRange = std::max( stats.nLargestFreeRange, pBlock->nSize - pBlock->nHead );
+					continue;
+				}
+
+				stats.nFreeRanges += static_cast< uint32_t >( pBlock->mFreeRanges.size() );
+				for ( const auto& [nOffset, nSize] : pBlock->mFreeRanges )
+				{
+					stats.nLargestFreeRange = std::max( stats.nLargestFreeRange, nSize );
+				}
+			}
+		}
+	}
+	return aStats;
+}
+
+uint32_t CatAllocator::getDeviceAllocationCount()
+{
+	const std::lock_guard lock( m_mutex );
+	return m_nDeviceAllocations;
+}
+
+} // namespace cat
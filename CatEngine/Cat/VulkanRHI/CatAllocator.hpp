@@ -0,0 +1,162 @@
+#ifndef CATENGINE_CATALLOCATOR_HPP
+#define CATENGINE_CATALLOCATOR_HPP
+
+#include "Globals.hpp"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cat
+{
+enum class AllocationStrategy : uint8_t
+{
+	// Best fit from a free list, for resources with unrelated lifetimes.
+	eFreeList,
+	// Bump allocation, the block is reused once everything in it was freed. For short lived staging memory.
+	eLinear,
+	// Own vkDeviceMemory, for render targets and anything larger than half a block.
+	eDedicated,
+};
+
+enum class ResourceKind : uint8_t
+{
+	eBuffer,
+	// Optimal tiling images, kept in separate blocks from buffers so bufferImageGranularity never applies.
+	eImage,
+};
+
+struct CatAllocation
+{
+	vk::DeviceMemory memory = nullptr;
+	vk::DeviceSize nOffset = 0;
+	vk::DeviceSize nSize = 0;
+	// Start of the allocation in the persistently mapped memory, nullptr if it is not host visible.
+	void* pMapped = nullptr;
+	uint32_t nMemoryType = 0;
+	// 0 for dedicated allocations.
+	uint32_t nBlockId = 0;
+	AllocationStrategy eStrategy = AllocationStrategy::eFreeList;
+	ResourceKind eKind = ResourceKind::eBuffer;
+
+	explicit operator bool() const { return static_cast< bool >( memory ); }
+};
+
+// Sub-allocates buffers and images from large vkDeviceMemory blocks, one list of blocks per memory type and kind of use.
+// Host visible blocks stay mapped for their whole life, vkMapMemory can't be called on memory that is already mapped.
+class CatAllocator
+{
+public:
+	static constexpr vk::DeviceSize BLOCK_SIZE = vk::DeviceSize( 64 ) << 20;
+	// Heaps smaller than this get blocks of an eighth of the heap.
+	static constexpr vk::DeviceSize SMALL_HEAP_SIZE = vk::DeviceSize( 1 ) << 30;
+
+	struct HeapStats
+	{
+		vk::DeviceSize nHeapSize = 0;
+		vk::MemoryHeapFlags flags;
+		// Bytes in blocks and dedicated allocations, and the part of it handed out.
+		vk::DeviceSize nReserved = 0;
+		vk::DeviceSize nUsed = 0;
+		vk::DeviceSize nLargestFreeRange = 0;
+		uint32_t nBlocks = 0;
+		uint32_t nDedicated = 0;
+		uint32_t nAllocations = 0;
+		uint32_t nFreeRanges = 0;
+
+		// 0 if all free space is in one range, close to 1 if it is scattered in small ranges.
+		[[nodiscard]] float getFragmentation() const
+		{
+			const auto nFree = nReserved - nUsed;
+			return nFree ? 1.0f - float( nLargestFreeRange ) / float( nFree ) : 0.0f;
+		}
+	};
+
+	CatAllocator( vk::PhysicalDevice physicalDevice, vk::Device device );
+	~CatAllocator();
+
+	CatAllocator( const CatAllocator& ) = delete;
+	CatAllocator& operator=( const CatAllocator& ) = delete;
+
+	[[nodiscard]] CatAllocation allocate( const vk::MemoryRequirements& requirements,
+		vk::MemoryPropertyFlags properties,
+		ResourceKind eKind,
+		AllocationStrategy eStrategy = AllocationStrategy::eFreeList );
+	void free( CatAllocation& allocation );
+
+	// Ranges are relative to the allocation, VK_WHOLE_SIZE covers the rest of it.
+	vk::Result flush( const CatAllocation& allocation, vk::DeviceSize nOffset = 0, vk::DeviceSize nSize = VK_WHOLE_SIZE );
+	vk::Result invalidate( const CatAllocation& allocation, vk::DeviceSize nOffset = 0, vk::DeviceSize nSize = VK_WHOLE_SIZE );
+
+	// Frees blocks nothing is allocated from anymore, keeping one per list so a burst of loads doesn't reallocate them.
+	void releaseEmptyBlocks();
+
+	// Defragmentation hooks. The allocator can't move resources, their owners have to recreate them:
+	// get the sparsely used blocks, exclude them, reallocate the resources that live in them and release the emptied blocks.
+	[[nodiscard]] std::vector< uint32_t > getDefragmentationCandidates( float fMaxUsage = 0.25f );
+	void setExcludedBlocks( std::vector< uint32_t > aBlockIds );
+	[[nodiscard]] static bool isInBlocks( const CatAllocation& allocation, const std::vector< uint32_t >& aBlockIds );
+
+	[[nodiscard]] std::vector< HeapStats > getHeapStats();
+	// Live vkAllocateMemory calls, the device allows maxMemoryAllocationCount of them.
+	[[nodiscard]] uint32_t getDeviceAllocationCount();
+	[[nodiscard]] uint32_t getMaxDeviceAllocationCount() const { return m_nMaxAllocationCount; }
+
+private:
+	static constexpr size_t LIST_COUNT = 3;
+
+	struct Block
+	{
+		uint32_t nId = 0;
+		vk::DeviceMemory memory = nullptr;
+		vk::DeviceSize nSize = 0;
+		vk::DeviceSize nUsed = 0;
+		uint32_t nAllocations = 0;
+		std::byte* pMapped = nullptr;
+		// Free list: offset -> size, neighbouring ranges are merged.
+		std::map< vk::DeviceSize, vk::DeviceSize > mFreeRanges;
+		// Linear blocks only.
+		vk::DeviceSize nHead = 0;
+	};
+
+	struct MemoryType
+	{
+		// Free list buffers, free list images and linear buffers.
+		std::array< std::vector< std::unique_ptr< Block > >, LIST_COUNT > aLists;
+		vk::DeviceSize nDedicatedSize = 0;
+		uint32_t nDedicated = 0;
+	};
+
+	[[nodiscard]] uint32_t findMemoryType( uint32_t nTypeFilter, vk::MemoryPropertyFlags properties ) const;
+	[[nodiscard]] vk::DeviceSize getBlockSize( uint32_t nMemoryType ) const;
+	[[nodiscard]] bool isHostVisible( uint32_t nMemoryType ) const;
+	[[nodiscard]] bool isCoherent( uint32_t nMemoryType ) const;
+	[[nodiscard]] static size_t getListIndex( ResourceKind eKind, AllocationStrategy eStrategy );
+
+	// Without the lock, throws if the device is out of memory.
+	[[nodiscard]] vk::DeviceMemory allocateMemory( vk::DeviceSize nSize, uint32_t nMemoryType, std::byte*& pMapped );
+	[[nodiscard]] CatAllocation allocateDedicated( vk::DeviceSize nSize, uint32_t nMemoryType, ResourceKind eKind );
+	[[nodiscard]] static bool allocateFromBlock( Block& block,
+		vk::DeviceSize nSize,
+		vk::DeviceSize nAlignment,
+		AllocationStrategy eStrategy,
+		vk::DeviceSize& nOffset );
+	[[nodiscard]] std::unique_ptr< Block > createBlock( uint32_t nMemoryType, vk::DeviceSize nMinSize, bool bLinear );
+	void destroyBlock( Block& block );
+
+	vk::Device m_device;
+	vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+	vk::DeviceSize m_nNonCoherentAtomSize;
+	uint32_t m_nMaxAllocationCount;
+
+	std::mutex m_mutex;
+	std::vector< MemoryType > m_aMemoryTypes;
+	std::vector< uint32_t > m_aExcludedBlocks;
+	uint32_t m_nNextBlockId = 1;
+	uint32_t m_nDeviceAllocations = 0;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATALLOCATOR_HPP
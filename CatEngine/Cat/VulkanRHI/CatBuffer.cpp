@@ -47,14 +47,17 @@ CatBuffer::CatBuffer( CatDevice* pDevice,
 {
 	m_pAlignmentSize = getAlignment( instanceSize, minOffsetAlignment );
 	m_pBufferSize = m_pAlignmentSize * instanceCount;
-	pDevice->createBuffer( m_pBufferSize, usageFlags, memoryPropertyFlags, m_pBuffer, m_pMemory );
+	// Staging buffers only live until their copy finished.
+	const auto eStrategy =
+		usageFlags == vk::BufferUsageFlagBits::eTransferSrc ? AllocationStrategy::eLinear : AllocationStrategy::eFreeList;
+	pDevice->createBuffer( m_pBufferSize, usageFlags, memoryPropertyFlags, m_pBuffer, m_allocation, eStrategy );
 }
 
 CatBuffer::~CatBuffer()
 {
 	unmap();
 	( **m_pDevice ).destroy( m_pBuffer );
-	( **m_pDevice ).free( m_pMemory );
+	m_pDevice->getAllocator().free( m_allocation );
 }
 
 /**
@@ -68,22 +71,24 @@ CatBuffer::~CatBuffer()
  */
 vk::Result CatBuffer::map( vk::DeviceSize size, vk::DeviceSize offset )
 {
-	CHECK_F( m_pBuffer && m_pMemory, "Called map on buffer before create" );
-	return ( **m_pDevice ).mapMemory( m_pMemory, offset, size, {}, &m_pMapped );
+	CHECK_F( m_pBuffer && m_allocation, "Called map on buffer before create" );
+	// The allocator keeps host visible memory mapped, the buffer shares it with others.
+	if ( !m_allocation.pMapped )
+	{
+		return vk::Result::eErrorMemoryMapFailed;
+	}
+	m_pMapped = static_cast< char* >( m_allocation.pMapped ) + offset;
+	return vk::Result::eSuccess;
 }
 
 /**
  * Unmap a mapped memory range
  *
- * @note Does not return a result as vkUnmapMemory can't fail
+ * @note The memory stays mapped by the allocator, this only forgets the pointer
  */
 void CatBuffer::unmap()
 {
-	if ( m_pMapped )
-	{
-		( **m_pDevice ).unmapMemory( m_pMemory );
-		m_pMapped = nullptr;
-	}
+	m_pMapped = nullptr;
 }
 
 /**
@@ -124,12 +129,7 @@ void CatBuffer::writeToBuffer( void* data, vk::DeviceSize size, vk::DeviceSize o
  */
 vk::Result CatBuffer::flush( vk::DeviceSize size, vk::DeviceSize offset )
 {
-	vk::MappedMemoryRange mappedRange = {
-		.memory = m_pMemory,
-		.offset = offset,
-		.size = size,
-	};
-	return ( **m_pDevice ).flushMappedMemoryRanges( 1, &mappedRange );
+	return m_pDevice->getAllocator().flush( m_allocation, offset, size );
 }
 
 /**
@@ -145,12 +145,7 @@ vk::Result CatBuffer::flush( vk::DeviceSize size, vk::DeviceSize offset )
  */
 vk::Result CatBuffer::invalidate( vk::DeviceSize size, vk::DeviceSize offset )
 {
-	vk::MappedMemoryRange mappedRange = {
-		.memory = m_pMemory,
-		.offset = offset,
-		.size = size,
-	};
-	return ( **m_pDevice ).invalidateMappedMemoryRanges( 1, &mappedRange );
+	return m_pDevice->getAllocator().invalidate( m_allocation, offset, size );
 }
 
 /**
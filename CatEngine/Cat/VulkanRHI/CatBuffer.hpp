@@ -42,6 +42,7 @@ public:
 	[[nodiscard]] vk::BufferUsageFlags getUsageFlags() const { return m_pUsageFlags; }
 	[[nodiscard]] vk::MemoryPropertyFlags getMemoryPropertyFlags() const { return m_pMemoryPropertyFlags; }
 	[[nodiscard]] vk::DeviceSize getBufferSize() const { return m_pBufferSize; }
+	[[nodiscard]] const CatAllocation& getAllocation() const { return m_allocation; }
 
 private:
 	static vk::DeviceSize getAlignment( vk::DeviceSize instanceSize, vk::DeviceSize minOffsetAlignment );
@@ -49,7 +50,7 @@ private:
 	CatDevice* m_pDevice;
 	void* m_pMapped = nullptr;
 	vk::Buffer m_pBuffer = nullptr;
-	vk::DeviceMemory m_pMemory = nullptr;
+	CatAllocation m_allocation;
 
 	vk::DeviceSize m_pBufferSize;
 	uint32_t m_nInstanceCount;
@@ -1,4 +1,6 @@
 #include "CatDevice.hpp"
+#include "CatSwapChain.hpp"
+#include "Cat/Objects/CatModel.hpp"
 
 #include <loguru.hpp>
 
@@ -67,10 +69,20 @@ CatDevice::CatDevice( CatWindow* pWindow ) : m_pWindow{ pWindow }
 	pickPhysicalDevice();
 	createLogicalDevice();
 	createCommandPool();
+	m_pAllocator = std::make_unique< CatAllocator >( m_physicalDevice, m_device );
+	m_pUploader = std::make_unique< CatUploader >( this );
+	m_pPipelineCache = std::make_unique< CatPipelineCache >( m_physicalDevice, m_device );
+	m_pGeometryPool = std::make_unique< CatGeometryPool >( this, sizeof( CatModel::Vertex ) );
 }
 
 CatDevice::~CatDevice()
 {
+	m_aDeferredReleases.clear();
+	m_pGeometryPool.reset();
+	m_pPipelineCache.reset();
+	m_pUploader.reset();
+	m_pAllocator.reset();
+
 	m_device.destroyCommandPool( m_pDrawCommandPool, nullptr );
 	m_device.destroy( nullptr );
 
@@ -245,7 +257,8 @@ void CatDevice::pickPhysicalDevice()
 	if ( candidates.rbegin()->first > 0 )
 	{
 		m_physicalDevice = candidates.rbegin()->second;
-		LOG_F( INFO, "%s", m_physicalDevice.getProperties().deviceName );
+		m_properties = m_physicalDevice.getProperties();
+		LOG_F( INFO, "%s", m_properties.deviceName.data() );
 	}
 	else
 	{
@@ -288,7 +301,26 @@ void CatDevice::createLogicalDevice()
 		.variableMultisampleRate = true,
 	};
 
+	// The GPU driven path needs indirect draws with a count buffer, enable them where the device has them.
+	vk::PhysicalDeviceFeatures supportedFeatures;
+	m_physicalDevice.getFeatures( &supportedFeatures );
+	vk::PhysicalDeviceVulkan12Features supportedFeatures12;
+	if ( m_properties.apiVersion >= VK_API_VERSION_1_2 )
+	{
+		vk::PhysicalDeviceFeatures2 supportedFeatures2 = { .pNext = &supportedFeatures12 };
+		m_physicalDevice.getFeatures2( &supportedFeatures2 );
+	}
+	m_bGpuDrivenSupported = supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance
+							&& supportedFeatures12.drawIndirectCount;
+	deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+	vk::PhysicalDeviceVulkan12Features deviceFeatures12 = {
+		.drawIndirectCount = supportedFeatures12.drawIndirectCount,
+	};
+
 	vk::DeviceCreateInfo createInfo = {
+		.pNext = m_properties.apiVersion >= VK_API_VERSION_1_2 ? &deviceFeatures12 : nullptr,
 		.queueCreateInfoCount = static_cast< uint32_t >( queueCreateInfos.size() ),
 		.pQueueCreateInfos = queueCreateInfos.data(),
 		.enabledExtensionCount = static_cast< uint32_t >( m_aDeviceExtensions.size() ),
@@ -582,7 +614,8 @@ void CatDevice::createBuffer( vk::DeviceSize size,
 	vk::BufferUsageFlags usage,
 	vk::MemoryPropertyFlags properties,
 	vk::Buffer& buffer,
-	vk::DeviceMemory& bufferMemory )
+	CatAllocation& bufferAllocation,
+	AllocationStrategy eStrategy /* = AllocationStrategy::eFreeList */ )
 {
 	vk::BufferCreateInfo bufferInfo{
 		.size = size,
@@ -599,17 +632,9 @@ void CatDevice::createBuffer( vk::DeviceSize size,
 	vk::MemoryRequirements memRequirements;
 	m_device.getBufferMemoryRequirements( buffer, &memRequirements );
 
-	vk::MemoryAllocateInfo allocInfo{
-		.allocationSize = memRequirements.size,
-		.memoryTypeIndex = findMemoryType( memRequirements.memoryTypeBits, properties ),
-	};
+	bufferAllocation = m_pAllocator->allocate( memRequirements, properties, ResourceKind::eBuffer, eStrategy );
 
-	if ( m_device.allocateMemory( &allocInfo, VK_NULL_HANDLE, &bufferMemory ) != vk::Result::eSuccess )
-	{
-		throw std::runtime_error( "failed to allocate buffer device memory!" );
-	}
-
-	m_device.bindBufferMemory( buffer, bufferMemory, 0 );
+	m_device.bindBufferMemory( buffer, bufferAllocation.memory, bufferAllocation.nOffset );
 }
 
 vk::CommandBuffer CatDevice::beginSingleTimeCommands()
@@ -687,7 +712,8 @@ void CatDevice::copyBufferToImage( vk::Buffer buffer,
 void CatDevice::createImageWithInfo( const vk::ImageCreateInfo& imageInfo,
 	vk::MemoryPropertyFlags properties,
 	vk::Image& image,
-	vk::DeviceMemory& imageMemory )
+	CatAllocation& imageAllocation,
+	AllocationStrategy eStrategy /* = AllocationStrategy::eFreeList */ )
 {
 	if ( m_device.createImage( &imageInfo, nullptr, &image ) != vk::Result::eSuccess )
 	{
@@ -697,18 +723,9 @@ void CatDevice::createImageWithInfo( const vk::ImageCreateInfo& imageInfo,
 	vk::MemoryRequirements memRequirements;
 	m_device.getImageMemoryRequirements( image, &memRequirements );
 
-	vk::MemoryAllocateInfo allocInfo{
-		.allocationSize = memRequirements.size,
-		.memoryTypeIndex = findMemoryType( memRequirements.memoryTypeBits, properties ),
-	};
-
-
-	if ( m_device.allocateMemory( &allocInfo, nullptr, &imageMemory ) != vk::Result::eSuccess )
-	{
-		throw std::runtime_error( "failed to allocate image m_pMemory!" );
-	}
+	imageAllocation = m_pAllocator->allocate( memRequirements, properties, ResourceKind::eImage, eStrategy );
 
-	m_device.bindImageMemory( image, imageMemory, 0 );
+	m_device.bindImageMemory( image, imageAllocation.memory, imageAllocation.nOffset );
 }
 
 void CatDevice::transitionImageLayout( vk::Image image,
@@ -759,4 +776,40 @@ void CatDevice::transitionImageLayout( vk::Image image,
 	endSingleTimeCommands( commandBuffer );
 }
 
+void CatDevice::deferRelease( std::shared_ptr< void > pResource )
+{
+	const std::lock_guard lock( m_mutexDeferredReleases );
+	m_aDeferredReleases.emplace_back( m_nFrameNumber, std::move( pResource ) );
+}
+
+void CatDevice::releaseDeferred( const uint64_t nFrameNumber )
+{
+	std::vector< std::shared_ptr< void > > aReleased;
+	{
+		const std::lock_guard lock( m_mutexDeferredReleases );
+		m_nFrameNumber = nFrameNumber;
+
+		// A resource queued during frame N can be used by that frame at the latest, it is done once we waited on its fence.
+		std::erase_if( m_aDeferredReleases,
+			[&]( auto& pair )
+			{
+				if ( pair.first + CatSwapChain::MAX_FRAMES_IN_FLIGHT > nFrameNumber ) return false;
+				aReleased.push_back( std::move( pair.second ) );
+				return true;
+			} );
+	}
+	// Destroy outside of the lock, destructors may queue more releases.
+	if ( !aReleased.empty() )
+	{
+		aReleased.clear();
+		m_pAllocator->releaseEmptyBlocks();
+	}
+}
+
+size_t CatDevice::getDeferredReleaseCount()
+{
+	const std::lock_guard lock( m_mutexDeferredReleases );
+	return m_aDeferredReleases.size();
+}
+
 } // namespace cat
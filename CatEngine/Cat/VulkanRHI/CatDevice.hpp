@@ -4,10 +4,15 @@
 #include <mutex>
 
 #include "Cat/CatWindow.hpp"
+#include "Cat/VulkanRHI/CatAllocator.hpp"
+#include "Cat/VulkanRHI/CatGeometryPool.hpp"
+#include "Cat/VulkanRHI/CatPipelineCache.hpp"
+#include "Cat/VulkanRHI/CatUploader.hpp"
 
 #include <string>
 #include <vector>
 #include <optional>
+#include <memory>
 
 
 namespace cat
@@ -64,13 +69,20 @@ public:
 		vk::ImageTiling tiling,
 		vk::FormatFeatureFlags features );
 	[[nodiscard]] auto getMSAA() { return m_msaaSamples; }
+	[[nodiscard]] CatAllocator& getAllocator() { return *m_pAllocator; }
+	[[nodiscard]] CatUploader& getUploader() { return *m_pUploader; }
+	[[nodiscard]] CatPipelineCache& getPipelineCache() { return *m_pPipelineCache; }
+	[[nodiscard]] CatGeometryPool& getGeometryPool() { return *m_pGeometryPool; }
+	// multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount are enabled.
+	[[nodiscard]] bool supportsGpuDriven() const { return m_bGpuDrivenSupported; }
 
 	// Buffer Helper Functions
 	void createBuffer( vk::DeviceSize size,
 		vk::BufferUsageFlags usage,
 		vk::MemoryPropertyFlags properties,
 		vk::Buffer& buffer,
-		vk::DeviceMemory& bufferMemory );
+		CatAllocation& bufferAllocation,
+		AllocationStrategy eStrategy = AllocationStrategy::eFreeList );
 	[[nodiscard]] vk::CommandBuffer beginSingleTimeCommands();
 	void endSingleTimeCommands( vk::CommandBuffer commandBuffer ) const;
 	void copyBuffer( vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size );
@@ -87,13 +99,20 @@ public:
 	void createImageWithInfo( const vk::ImageCreateInfo& imageInfo,
 		vk::MemoryPropertyFlags properties,
 		vk::Image& image,
-		vk::DeviceMemory& imageMemory );
+		CatAllocation& imageAllocation,
+		AllocationStrategy eStrategy = AllocationStrategy::eFreeList );
 
 	void transitionImageLayout( vk::Image image,
 		vk::ImageLayout oldLayout,
 		vk::ImageLayout newLayout,
 		vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } );
 
+	// Keeps a resource alive until the frames that may still reference it have finished on the GPU.
+	void deferRelease( std::shared_ptr< void > pResource );
+	// Called after the frame's fence was waited on, releases everything that is no longer in flight.
+	void releaseDeferred( uint64_t nFrameNumber );
+	[[nodiscard]] size_t getDeferredReleaseCount();
+
 	vk::PhysicalDeviceProperties m_properties;
 
 	inline static std::mutex m_mutex{};
@@ -134,6 +153,16 @@ private:
 	vk::Queue m_transferQueue;
 	vk::SampleCountFlagBits m_msaaSamples;
 
+	std::unique_ptr< CatAllocator > m_pAllocator;
+	std::unique_ptr< CatUploader > m_pUploader;
+	std::unique_ptr< CatPipelineCache > m_pPipelineCache;
+	std::unique_ptr< CatGeometryPool > m_pGeometryPool;
+	bool m_bGpuDrivenSupported = false;
+
+	std::mutex m_mutexDeferredReleases;
+	std::vector< std::pair< uint64_t, std::shared_ptr< void > > > m_aDeferredReleases;
+	uint64_t m_nFrameNumber = 0;
+
 	std::vector< const char* > m_aDeviceExtensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		// Only works if vulkan configurator is running
@@ -0,0 +1,205 @@
+#include "CatGeometryPool.hpp"
+
+#include "Cat/VulkanRHI/CatDevice.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace cat
+{
+CatGeometryPool::RangeAllocator::RangeAllocator( const uint32_t nCapacity )
+{
+	m_mFreeRanges.emplace( 0, nCapacity );
+}
+
+bool CatGeometryPool::RangeAllocator::allocate( const uint32_t nCount, uint32_t& nOffset )
+{
+	auto best = m_mFreeRanges.end();
+	for ( auto it = m_mFreeRanges.begin(); it != m_mFreeRanges.end(); ++it )
+	{
+		if ( it->second >= nCount && ( best == m_mFreeRanges.end() || it->second < best->second ) )
+		{
+			best = it;
+			if ( it->second == nCount ) break;
+		}
+	}
+	if ( best == m_mFreeRanges.end() ) return false;
+
+	nOffset = best->first;
+	const auto nRemaining = best->second - nCount;
+	m_mFreeRanges.erase( best );
+	if ( nRemaining > 0 )
+	{
+		m_mFreeRanges.emplace( nOffset + nCount, nRemaining );
+	}
+	m_nUsed += nCount;
+	return true;
+}
+
+void CatGeometryPool::RangeAllocator::free( uint32_t nOffset, uint32_t nCount )
+{
+	m_nUsed -= nCount;
+
+	auto next = m_mFreeRanges.lower_bound( nOffset );
+	if ( next != m_mFreeRanges.end() && nOffset + nCount == next->first )
+	{
+		nCount += next->second;
+		next = m_mFreeRanges.erase( next );
+	}
+	if ( next != m_mFreeRanges.begin() )
+	{
+		auto previous = std::prev( next );
+		if ( previous->first + previous->second == nOffset )
+		{
+			previous->second += nCount;
+			return;
+		}
+	}
+	m_mFreeRanges.emplace( nOffset, nCount );
+}
+
+uint32_t CatGeometryPool::RangeAllocator::getLargestFreeRange() const
+{
+	uint32_t nLargest = 0;
+	for ( const auto& [nOffset, nCount] : m_mFreeRanges )
+	{
+		nLargest = std::max( nLargest, nCount );
+	}
+	return nLargest;
+}
+
+CatGeometryPool::CatGeometryPool( CatDevice* pDevice, const vk::DeviceSize nVertexSize )
+	: m_pDevice{ pDevice }, m_nVertexSize{ nVertexSize }
+{
+	createPage();
+}
+
+CatGeometryPool::~CatGeometryPool()
+{
+	for ( uint32_t i = 0; i < getPageCount(); ++i )
+	{
+		auto& page = *m_aPages[i];
+		( **m_pDevice ).destroy( page.vertexBuffer );
+		m_pDevice->getAllocator().free( page.vertexAllocation );
+		( **m_pDevice ).destroy( page.indexBuffer );
+		m_pDevice->getAllocator().free( page.indexAllocation );
+	}
+}
+
+void CatGeometryPool::createPage()
+{
+	auto pPage = std::make_unique< Page >();
+	// Storage buffer usage lets compute passes read the geometry as well.
+	m_pDevice->createBuffer( VERTEX_CAPACITY * m_nVertexSize,
+		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer
+			| vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, pPage->vertexBuffer, pPage->vertexAllocation,
+		AllocationStrategy::eDedicated );
+	m_pDevice->createBuffer( vk::DeviceSize( INDEX_CAPACITY ) * sizeof( uint32_t ),
+		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer
+			| vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, pPage->indexBuffer, pPage->indexAllocation, AllocationStrategy::eDedicated );
+
+	const auto nPage = m_nPageCount.load( std::memory_order_relaxed );
+	m_aPages[nPage] = std::move( pPage );
+	m_nPageCount.store( nPage + 1, std::memory_order_release );
+	LOG_F( INFO, "Created geometry page %u", nPage );
+}
+
+bool CatGeometryPool::allocateFromPage( Page& page,
+	const uint32_t nVertexCount,
+	const uint32_t nIndexCount,
+	Allocation& allocation )
+{
+	if ( !page.vertices.allocate( nVertexCount, allocation.nFirstVertex ) ) return false;
+
+	if ( nIndexCount > 0 && !page.indices.allocate( nIndexCount, allocation.nFirstIndex ) )
+	{
+		page.vertices.free( allocation.nFirstVertex, nVertexCount );
+		return false;
+	}
+	allocation.nVertexCount = nVertexCount;
+	allocation.nIndexCount = nIndexCount;
+	return true;
+}
+
+CatGeometryPool::Allocation CatGeometryPool::allocate( const uint32_t nVertexCount, const uint32_t nIndexCount )
+{
+	if ( nVertexCount > VERTEX_CAPACITY || nIndexCount > INDEX_CAPACITY )
+	{
+		throw std::runtime_error( "failed to allocate geometry, the model is larger than a geometry page!" );
+	}
+
+	const std::lock_guard lock( m_mutex );
+
+	// Earlier pages first, so freed ranges get reused before the newer pages fill up.
+	Allocation allocation{};
+	uint32_t nPage = 0;
+	while ( nPage < getPageCount() && !allocateFromPage( *m_aPages[nPage], nVertexCount, nIndexCount, allocation ) )
+	{
+		++nPage;
+	}
+	if ( nPage == getPageCount() )
+	{
+		if ( nPage == MAX_PAGES )
+		{
+			throw std::runtime_error( "failed to allocate geometry, the geometry pool is full!" );
+		}
+		createPage();
+		if ( !allocateFromPage( *m_aPages[nPage], nVertexCount, nIndexCount, allocation ) )
+		{
+			throw std::runtime_error( "failed to allocate geometry from a new page!" );
+		}
+	}
+	allocation.nPage = nPage;
+
+	m_nAllocations++;
+	return allocation;
+}
+
+void CatGeometryPool::free( Allocation& allocation )
+{
+	if ( !allocation ) return;
+
+	const std::lock_guard lock( m_mutex );
+	auto& page = *m_aPages[allocation.nPage];
+	page.vertices.free( allocation.nFirstVertex, allocation.nVertexCount );
+	if ( allocation.nIndexCount > 0 )
+	{
+		page.indices.free( allocation.nFirstIndex, allocation.nIndexCount );
+	}
+	m_nAllocations--;
+	allocation = {};
+}
+
+void CatGeometryPool::bind( const vk::CommandBuffer commandBuffer, const uint32_t nPage, uint32_t& nBoundPage ) const
+{
+	if ( nPage == nBoundPage ) return;
+
+	const auto& page = *m_aPages[nPage];
+	const vk::DeviceSize nOffset = 0;
+	commandBuffer.bindVertexBuffers( 0, 1, &page.vertexBuffer, &nOffset );
+	commandBuffer.bindIndexBuffer( page.indexBuffer, 0, vk::IndexType::eUint32 );
+	nBoundPage = nPage;
+}
+
+CatGeometryPool::Stats CatGeometryPool::getStats()
+{
+	const std::lock_guard lock( m_mutex );
+	Stats stats{
+		.nPages = getPageCount(),
+		.nAllocations = m_nAllocations,
+	};
+	for ( uint32_t i = 0; i < stats.nPages; ++i )
+	{
+		const auto& page = *m_aPages[i];
+		stats.nVertices += page.vertices.getUsed();
+		stats.nIndices += page.indices.getUsed();
+		stats.nFreeRanges += page.vertices.getFreeRangeCount() + page.indices.getFreeRangeCount();
+		stats.nLargestFreeVertices = std::max( stats.nLargestFreeVertices, page.vertices.getLargestFreeRange() );
+	}
+	return stats;
+}
+} // namespace cat
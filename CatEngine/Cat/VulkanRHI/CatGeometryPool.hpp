@@ -0,0 +1,116 @@
+#ifndef CATENGINE_CATGEOMETRYPOOL_HPP
+#define CATENGINE_CATGEOMETRYPOOL_HPP
+
+#include "Cat/VulkanRHI/CatAllocator.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace cat
+{
+class CatDevice;
+
+// Shared vertex and index buffers every model's geometry is sub-allocated from, in elements rather than bytes.
+// Draws address their model with vertexOffset and firstIndex, so all models on a page can use the same bound buffers.
+// A new page is only created once the geometry doesn't fit in the existing ones.
+class CatGeometryPool
+{
+public:
+	// CatModel::Vertex is 44 bytes, a page is 88 MiB of vertices and 32 MiB of indices.
+	static constexpr uint32_t VERTEX_CAPACITY = 1u << 21;
+	static constexpr uint32_t INDEX_CAPACITY = 1u << 23;
+	static constexpr uint32_t MAX_PAGES = 4;
+	static constexpr uint32_t NO_PAGE = ~0u;
+
+	struct Allocation
+	{
+		uint32_t nPage = NO_PAGE;
+		uint32_t nFirstVertex = 0;
+		uint32_t nVertexCount = 0;
+		uint32_t nFirstIndex = 0;
+		uint32_t nIndexCount = 0;
+
+		explicit operator bool() const { return nVertexCount > 0; }
+	};
+
+	struct Stats
+	{
+		uint32_t nPages = 0;
+		uint32_t nVertices = 0;
+		uint32_t nIndices = 0;
+		uint32_t nAllocations = 0;
+		uint32_t nFreeRanges = 0;
+		// Largest free vertex range of any page, the biggest model that still fits without a new page.
+		uint32_t nLargestFreeVertices = 0;
+	};
+
+	CatGeometryPool( CatDevice* pDevice, vk::DeviceSize nVertexSize );
+	~CatGeometryPool();
+
+	CatGeometryPool( const CatGeometryPool& ) = delete;
+	CatGeometryPool& operator=( const CatGeometryPool& ) = delete;
+
+	// Throws if all pages are full.
+	[[nodiscard]] Allocation allocate( uint32_t nVertexCount, uint32_t nIndexCount );
+	// The GPU must be done with the geometry, models are released through the device's deferred release.
+	void free( Allocation& allocation );
+
+	// Binds the page unless nBoundPage says it already is, render systems keep one per frame.
+	void bind( vk::CommandBuffer commandBuffer, uint32_t nPage, uint32_t& nBoundPage ) const;
+
+	[[nodiscard]] uint32_t getPageCount() const { return m_nPageCount.load( std::memory_order_acquire ); }
+	[[nodiscard]] vk::Buffer getVertexBuffer( const uint32_t nPage ) const { return m_aPages[nPage]->vertexBuffer; }
+	[[nodiscard]] vk::Buffer getIndexBuffer( const uint32_t nPage ) const { return m_aPages[nPage]->indexBuffer; }
+	[[nodiscard]] vk::DeviceSize getVertexSize() const { return m_nVertexSize; }
+	[[nodiscard]] Stats getStats();
+
+private:
+	// Best fit over offset -> size ranges, neighbouring free ranges are merged.
+	class RangeAllocator
+	{
+	public:
+		explicit RangeAllocator( uint32_t nCapacity );
+
+		[[nodiscard]] bool allocate( uint32_t nCount, uint32_t& nOffset );
+		void free( uint32_t nOffset, uint32_t nCount );
+
+		[[nodiscard]] uint32_t getUsed() const { return m_nUsed; }
+		[[nodiscard]] uint32_t getFreeRangeCount() const { return static_cast< uint32_t >( m_mFreeRanges.size() ); }
+		[[nodiscard]] uint32_t getLargestFreeRange() const;
+
+	private:
+		std::map< uint32_t, uint32_t > m_mFreeRanges;
+		uint32_t m_nUsed = 0;
+	};
+
+	struct Page
+	{
+		vk::Buffer vertexBuffer;
+		CatAllocation vertexAllocation;
+		vk::Buffer indexBuffer;
+		CatAllocation indexAllocation;
+
+		RangeAllocator vertices{ VERTEX_CAPACITY };
+		RangeAllocator indices{ INDEX_CAPACITY };
+	};
+
+	[[nodiscard]] bool allocateFromPage( Page& page, uint32_t nVertexCount, uint32_t nIndexCount, Allocation& allocation );
+	void createPage();
+
+	CatDevice* m_pDevice;
+	vk::DeviceSize m_nVertexSize;
+
+	// Published through the page count, so the render thread can bind pages while loader threads add new ones.
+	std::array< std::unique_ptr< Page >, MAX_PAGES > m_aPages;
+	std::atomic< uint32_t > m_nPageCount = 0;
+
+	std::mutex m_mutex;
+	uint32_t m_nAllocations = 0;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATGEOMETRYPOOL_HPP
@@ -0,0 +1,85 @@
+#include "CatGpuTimer.hpp"
+
+#include "Cat/VulkanRHI/CatSwapChain.hpp"
+
+#include <loguru.hpp>
+
+#include <stdexcept>
+
+namespace cat
+{
+CatGpuTimer::CatGpuTimer( CatDevice* pDevice, const uint32_t nTimestamps )
+	: m_pDevice{ pDevice },
+	  m_nTimestamps{ nTimestamps },
+	  m_aWritten( CatSwapChain::MAX_FRAMES_IN_FLIGHT, std::vector< bool >( nTimestamps, false ) ),
+	  m_aResults( nTimestamps, 0 ),
+	  m_aResultsValid( nTimestamps, false )
+{
+	const auto& limits = m_pDevice->m_properties.limits;
+	if ( !limits.timestampComputeAndGraphics || limits.timestampPeriod <= 0.0f )
+	{
+		LOG_F( WARNING, "Timestamp queries are not supported, the GPU timings are disabled" );
+		return;
+	}
+	m_dPeriod = static_cast< double >( limits.timestampPeriod );
+
+	vk::QueryPoolCreateInfo queryPoolInfo{
+		.queryType = vk::QueryType::eTimestamp,
+		.queryCount = nTimestamps * CatSwapChain::MAX_FRAMES_IN_FLIGHT,
+	};
+	if ( ( **m_pDevice ).createQueryPool( &queryPoolInfo, nullptr, &m_queryPool ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "failed to create timestamp query pool!" );
+	}
+}
+
+CatGpuTimer::~CatGpuTimer()
+{
+	if ( m_queryPool )
+	{
+		( **m_pDevice ).destroy( m_queryPool );
+	}
+}
+
+void CatGpuTimer::reset( const vk::CommandBuffer commandBuffer, const int nFrameIndex )
+{
+	if ( !m_queryPool ) return;
+
+	const uint32_t nFirstQuery = nFrameIndex * m_nTimestamps;
+	auto& aWritten = m_aWritten[nFrameIndex];
+	for ( uint32_t i = 0; i < m_nTimestamps; ++i )
+	{
+		m_aResultsValid[i] = aWritten[i];
+		if ( !aWritten[i] ) continue;
+
+		// The frame's fence was waited on, the result is available.
+		if ( ( **m_pDevice ).getQueryPoolResults( m_queryPool, nFirstQuery + i, 1, sizeof( uint64_t ), &m_aResults[i],
+				 sizeof( uint64_t ), vk::QueryResultFlagBits::e64 )
+			 != vk::Result::eSuccess )
+		{
+			m_aResultsValid[i] = false;
+		}
+		aWritten[i] = false;
+	}
+
+	commandBuffer.resetQueryPool( m_queryPool, nFirstQuery, m_nTimestamps );
+}
+
+void CatGpuTimer::writeTimestamp( const vk::CommandBuffer commandBuffer,
+	const int nFrameIndex,
+	const uint32_t nTimestamp,
+	const vk::PipelineStageFlagBits eStage )
+{
+	if ( !m_queryPool ) return;
+
+	commandBuffer.writeTimestamp( eStage, m_queryPool, nFrameIndex * m_nTimestamps + nTimestamp );
+	m_aWritten[nFrameIndex][nTimestamp] = true;
+}
+
+double CatGpuTimer::getMilliseconds( const uint32_t nBegin, const uint32_t nEnd ) const
+{
+	if ( !m_aResultsValid[nBegin] || !m_aResultsValid[nEnd] || m_aResults[nEnd] < m_aResults[nBegin] ) return 0.0;
+
+	return static_cast< double >( m_aResults[nEnd] - m_aResults[nBegin] ) * m_dPeriod / 1e6;
+}
+} // namespace cat
@@ -0,0 +1,47 @@
+#ifndef CATENGINE_CATGPUTIMER_HPP
+#define CATENGINE_CATGPUTIMER_HPP
+
+#include "Cat/VulkanRHI/CatDevice.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cat
+{
+// Timestamp queries per frame in flight. The results of a frame index are read back once its fence was waited on,
+// so they lag MAX_FRAMES_IN_FLIGHT frames behind and reading them never stalls.
+class CatGpuTimer
+{
+public:
+	CatGpuTimer( CatDevice* pDevice, uint32_t nTimestamps );
+	~CatGpuTimer();
+
+	CatGpuTimer( const CatGpuTimer& ) = delete;
+	CatGpuTimer& operator=( const CatGpuTimer& ) = delete;
+
+	// Reads the results of the frame that last used the frame index and resets its queries.
+	// Has to be recorded outside of a render pass.
+	void reset( vk::CommandBuffer commandBuffer, int nFrameIndex );
+	void writeTimestamp( vk::CommandBuffer commandBuffer,
+		int nFrameIndex,
+		uint32_t nTimestamp,
+		vk::PipelineStageFlagBits eStage = vk::PipelineStageFlagBits::eBottomOfPipe );
+
+	// Milliseconds between two timestamps of the last frame read back, 0 if they weren't both written.
+	[[nodiscard]] double getMilliseconds( uint32_t nBegin, uint32_t nEnd ) const;
+	[[nodiscard]] bool isSupported() const { return !!m_queryPool; }
+
+private:
+	CatDevice* m_pDevice;
+	uint32_t m_nTimestamps;
+	vk::QueryPool m_queryPool;
+	double m_dPeriod = 0.0;
+
+	// Which timestamps of every frame index were written since its last reset.
+	std::vector< std::vector< bool > > m_aWritten;
+	std::vector< uint64_t > m_aResults;
+	std::vector< bool > m_aResultsValid;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATGPUTIMER_HPP
@@ -35,10 +35,17 @@ CatPipeline::CatPipeline( CatDevice* pDevice,
 	createGraphicsPipeline( vertFilepath, fragFilepath, compFilePath, configInfo );
 }
 
+CatPipeline::CatPipeline( CatDevice* pDevice, const std::string& compFilepath, const vk::PipelineLayout pipelineLayout )
+	: m_pDevice{ pDevice }, m_eBindPoint{ vk::PipelineBindPoint::eCompute }
+{
+	createComputePipeline( compFilepath, pipelineLayout );
+}
+
 CatPipeline::~CatPipeline()
 {
 	( **m_pDevice ).destroy( m_pVertShaderModule );
 	( **m_pDevice ).destroy( m_pFragShaderModule );
+	( **m_pDevice ).destroy( m_pCompShaderModule );
 	( **m_pDevice ).destroy( m_pGraphicsPipeline );
 }
 
@@ -118,7 +125,7 @@ void CatPipeline::createGraphicsPipeline( const cat::PipelineConfigInfo& configI
 		.basePipelineIndex = -1,
 	};
 
-	if ( ( **m_pDevice ).createGraphicsPipelines( nullptr, 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
+	if ( ( **m_pDevice ).createGraphicsPipelines( *m_pDevice->getPipelineCache(), 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
 		 != vk::Result::eSuccess )
 	{
 		throw std::runtime_error( "failed to create graphics pipeline" );
@@ -181,7 +188,7 @@ void CatPipeline::createGraphicsPipeline( const std::string& vertFilepath,
 		.basePipelineIndex = -1,
 	};
 
-	if ( ( **m_pDevice ).createGraphicsPipelines( nullptr, 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
+	if ( ( **m_pDevice ).createGraphicsPipelines( *m_pDevice->getPipelineCache(), 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
 		 != vk::Result::eSuccess )
 	{
 		throw std::runtime_error( "failed to create graphics pipeline" );
@@ -254,13 +261,39 @@ void CatPipeline::createGraphicsPipeline( const std::string& vertFilepath,
 		.basePipelineIndex = -1,
 	};
 
-	if ( ( **m_pDevice ).createGraphicsPipelines( nullptr, 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
+	if ( ( **m_pDevice ).createGraphicsPipelines( *m_pDevice->getPipelineCache(), 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
 		 != vk::Result::eSuccess )
 	{
 		throw std::runtime_error( "failed to create graphics pipeline" );
 	}
 }
 
+void CatPipeline::createComputePipeline( const std::string& compFilepath, const vk::PipelineLayout pipelineLayout )
+{
+	assert( !!pipelineLayout && "Cannot create compute pipeline: no pipelineLayout provided" );
+
+	auto compCode = readFile( compFilepath );
+	createShaderModule( compCode, &m_pCompShaderModule );
+
+	vk::ComputePipelineCreateInfo pipelineInfo{
+		.stage =
+			vk::PipelineShaderStageCreateInfo{
+				.stage = vk::ShaderStageFlagBits::eCompute,
+				.module = m_pCompShaderModule,
+				.pName = "main",
+			},
+		.layout = pipelineLayout,
+		.basePipelineHandle = nullptr,
+		.basePipelineIndex = -1,
+	};
+
+	if ( ( **m_pDevice ).createComputePipelines( *m_pDevice->getPipelineCache(), 1, &pipelineInfo, nullptr, &m_pGraphicsPipeline )
+		 != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "failed to create compute pipeline" );
+	}
+}
+
 void CatPipeline::createShaderModule( const std::vector< char >& code, vk::ShaderModule* shaderModule )
 {
 	vk::ShaderModuleCreateInfo createInfo{
@@ -276,7 +309,7 @@ void CatPipeline::createShaderModule( const std::vector< char >& code, vk::Shade
 
 void CatPipeline::bind( vk::CommandBuffer commandBuffer )
 {
-	commandBuffer.bindPipeline( vk::PipelineBindPoint::eGraphics, m_pGraphicsPipeline );
+	commandBuffer.bindPipeline( m_eBindPoint, m_pGraphicsPipeline );
 }
 
 void CatPipeline::defaultPipelineConfigInfo( PipelineConfigInfo& configInfo )
@@ -381,6 +414,18 @@ void CatPipeline::disableDepthTest( PipelineConfigInfo& configInfo )
 	configInfo.m_pDepthStencilInfo.depthWriteEnable = false;
 }
 
+void CatPipeline::enableEqualDepthTest( PipelineConfigInfo& configInfo )
+{
+	configInfo.m_pDepthStencilInfo.depthWriteEnable = false;
+	configInfo.m_pDepthStencilInfo.depthCompareOp = vk::CompareOp::eEqual;
+}
+
+void CatPipeline::disableColorWrite( PipelineConfigInfo& configInfo )
+{
+	configInfo.m_pColorBlendAttachment.blendEnable = false;
+	configInfo.m_pColorBlendAttachment.colorWriteMask = {};
+}
+
 void CatPipeline::enableTessellation( PipelineConfigInfo& configInfo, uint32_t patchControlPoints /* = 4 */ )
 {
 	configInfo.m_pInputAssemblyInfo.topology = vk::PrimitiveTopology::ePatchList;
@@ -47,6 +47,8 @@ public:
 		const std::string& fragFilepath,
 		const std::string& compFilepath,
 		const PipelineConfigInfo& configInfo );
+	// Compute pipeline, bind() binds it to the compute bind point.
+	CatPipeline( CatDevice* pDevice, const std::string& compFilepath, vk::PipelineLayout pipelineLayout );
 	~CatPipeline();
 
 	CatPipeline( const CatPipeline& ) = delete;
@@ -60,6 +62,9 @@ public:
 	static void disableBackFaceCulling( PipelineConfigInfo& configInfo );
 	static void disableDepthWrite( PipelineConfigInfo& configInfo );
 	static void disableDepthTest( PipelineConfigInfo& configInfo );
+	// Only passes the fragments that a depth prepass left in the depth buffer.
+	static void enableEqualDepthTest( PipelineConfigInfo& configInfo );
+	static void disableColorWrite( PipelineConfigInfo& configInfo );
 	static void enableTessellation( PipelineConfigInfo& configInfo, uint32_t patchControlPoints = 4 );
 
 	static vk::PipelineShaderStageCreateInfo loadShader( CatDevice* pDevice,
@@ -79,11 +84,13 @@ private:
 		const std::string& compFilepath,
 		const PipelineConfigInfo& configInfo );
 
+	void createComputePipeline( const std::string& compFilepath, vk::PipelineLayout pipelineLayout );
 
 	void createShaderModule( const std::vector< char >& code, vk::ShaderModule* shaderModule );
 
 	CatDevice* m_pDevice;
 	vk::Pipeline m_pGraphicsPipeline;
+	vk::PipelineBindPoint m_eBindPoint = vk::PipelineBindPoint::eGraphics;
 	vk::ShaderModule m_pVertShaderModule;
 	vk::ShaderModule m_pFragShaderModule;
 	vk::ShaderModule m_pCompShaderModule;
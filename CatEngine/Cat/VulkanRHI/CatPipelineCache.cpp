@@ -0,0 +1,167 @@
+#include "CatPipelineCache.hpp"
+
+#include "loguru.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace cat
+{
+static constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325;
+static constexpr uint64_t FNV_PRIME = 0x100000001B3;
+
+static uint64_t HashBytes( const char* pData, const size_t nSize )
+{
+	uint64_t nHash = FNV_OFFSET;
+	for ( size_t i = 0; i < nSize; ++i )
+	{
+		nHash ^= static_cast< uint8_t >( pData[i] );
+		nHash *= FNV_PRIME;
+	}
+	return nHash;
+}
+
+CatPipelineCache::CatPipelineCache( const vk::PhysicalDevice physicalDevice, const vk::Device device )
+	: m_device{ device }, m_properties{ physicalDevice.getProperties() }
+{
+	const auto tStart = std::chrono::steady_clock::now();
+
+	auto aData = load();
+	vk::PipelineCacheCreateInfo createInfo{
+		.initialDataSize = aData.size(),
+		.pInitialData = aData.data(),
+	};
+
+	if ( m_device.createPipelineCache( &createInfo, nullptr, &m_pipelineCache ) != vk::Result::eSuccess )
+	{
+		// The driver may still reject data that passed our checks, start over with an empty cache then.
+		LOG_F( WARNING, "Pipeline cache data was rejected by the driver, starting with an empty cache" );
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		aData.clear();
+		if ( m_device.createPipelineCache( &createInfo, nullptr, &m_pipelineCache ) != vk::Result::eSuccess )
+		{
+			throw std::runtime_error( "failed to create pipeline cache!" );
+		}
+	}
+	m_nLoadedSize = aData.size();
+
+	const auto dLoadTime = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - tStart ).count();
+	LOG_F( INFO, "Pipeline cache: %s (%zu bytes) in %.2f ms", m_nLoadedSize ? "loaded" : "empty", m_nLoadedSize, dLoadTime );
+}
+
+CatPipelineCache::~CatPipelineCache()
+{
+	save();
+	m_device.destroyPipelineCache( m_pipelineCache );
+}
+
+CatPipelineCache::Header CatPipelineCache::makeHeader() const
+{
+	Header header{};
+	header.nMagic = MAGIC;
+	header.nVersion = VERSION;
+	header.nVendorId = m_properties.vendorID;
+	header.nDeviceId = m_properties.deviceID;
+	header.nDriverVersion = m_properties.driverVersion;
+	std::copy( m_properties.pipelineCacheUUID.begin(), m_properties.pipelineCacheUUID.end(), header.aCacheUuid.begin() );
+	return header;
+}
+
+std::vector< char > CatPipelineCache::load() const
+{
+	std::ifstream ifs( CACHE_PATH, std::ios::binary );
+	if ( !ifs ) return {};
+
+	Header header{};
+	ifs.read( reinterpret_cast< char* >( &header ), sizeof( Header ) );
+
+	const auto expected = makeHeader();
+	if ( !ifs || header.nMagic != expected.nMagic || header.nVersion != expected.nVersion
+		 || header.nVendorId != expected.nVendorId || header.nDeviceId != expected.nDeviceId
+		 || header.nDriverVersion != expected.nDriverVersion || header.aCacheUuid != expected.aCacheUuid )
+	{
+		LOG_F( INFO, "Pipeline cache was written by another device or driver, ignoring it" );
+		return {};
+	}
+
+	// The size comes from the file, check it against what is left before allocating for it.
+	const auto nDataStart = ifs.tellg();
+	ifs.seekg( 0, std::ios::end );
+	const auto nRemaining = static_cast< uint64_t >( ifs.tellg() - nDataStart );
+	ifs.seekg( nDataStart );
+	if ( !ifs || header.nDataSize != nRemaining )
+	{
+		LOG_F( WARNING, "Pipeline cache size doesn't match the file, ignoring it" );
+		return {};
+	}
+
+	std::vector< char > aData( header.nDataSize );
+	ifs.read( aData.data(), static_cast< std::streamsize >( aData.size() ) );
+	if ( !ifs || HashBytes( aData.data(), aData.size() ) != header.nDataHash )
+	{
+		LOG_F( WARNING, "Pipeline cache is corrupt, ignoring it" );
+		return {};
+	}
+
+	return aData;
+}
+
+bool CatPipelineCache::save() const
+{
+	size_t nDataSize = 0;
+	if ( m_device.getPipelineCacheData( m_pipelineCache, &nDataSize, nullptr ) != vk::Result::eSuccess )
+	{
+		return false;
+	}
+	std::vector< char > aData( nDataSize );
+	if ( m_device.getPipelineCacheData( m_pipelineCache, &nDataSize, aData.data() ) != vk::Result::eSuccess )
+	{
+		return false;
+	}
+	aData.resize( nDataSize );
+
+	auto header = makeHeader();
+	header.nDataSize = aData.size();
+	header.nDataHash = HashBytes( aData.data(), aData.size() );
+
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( CACHE_PATH ).parent_path(), error );
+
+	const auto sTempPath = std::string( CACHE_PATH ) + ".tmp";
+	std::ofstream ofs( sTempPath, std::ios::binary | std::ios::trunc );
+	if ( !ofs )
+	{
+		LOG_F( WARNING, "Failed to open pipeline cache for writing: %s", sTempPath.c_str() );
+		return false;
+	}
+	ofs.write( reinterpret_cast< const char* >( &header ), sizeof( Header ) );
+	ofs.write( aData.data(), static_cast< std::streamsize >( aData.size() ) );
+	ofs.close();
+
+	if ( !ofs )
+	{
+		LOG_F( WARNING, "Failed to write pipeline cache: %s", sTempPath.c_str() );
+		std::filesystem::remove( sTempPath, error );
+		return false;
+	}
+
+	// Renaming over an existing file fails on Windows.
+	std::filesystem::remove( CACHE_PATH, error );
+	std::filesystem::rename( sTempPath, CACHE_PATH, error );
+	if ( error )
+	{
+		LOG_F( WARNING, "Failed to move pipeline cache into place: %s (%s)", CACHE_PATH, error.message().c_str() );
+		std::filesystem::remove( sTempPath, error );
+		return false;
+	}
+
+	DLOG_F( INFO, "Saved pipeline cache: %s (%zu bytes)", CACHE_PATH, aData.size() );
+	return true;
+}
+
+} // namespace cat
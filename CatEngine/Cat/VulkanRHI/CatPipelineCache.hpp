@@ -0,0 +1,64 @@
+#ifndef CATENGINE_CATPIPELINECACHE_HPP
+#define CATENGINE_CATPIPELINECACHE_HPP
+
+#include "Globals.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cat
+{
+
+// Engine wide vkPipelineCache, loaded at startup and written back on shutdown.
+// Layout: [Header][Driver cache data]
+// The header pins the cache to a device and driver, a driver update or another GPU starts with an empty cache.
+class CatPipelineCache
+{
+public:
+	static constexpr uint32_t MAGIC = 0x50544143; // "CATP"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr char CACHE_PATH[] = "assets/cache/pipelines.catp";
+
+	struct Header
+	{
+		uint32_t nMagic;
+		uint32_t nVersion;
+		uint32_t nVendorId;
+		uint32_t nDeviceId;
+		uint32_t nDriverVersion;
+		uint32_t nReserved;
+		std::array< uint8_t, VK_UUID_SIZE > aCacheUuid;
+		uint64_t nDataSize;
+		uint64_t nDataHash;
+	};
+
+	CatPipelineCache( vk::PhysicalDevice physicalDevice, vk::Device device );
+	~CatPipelineCache();
+
+	CatPipelineCache( const CatPipelineCache& ) = delete;
+	CatPipelineCache& operator=( const CatPipelineCache& ) = delete;
+
+	[[nodiscard]] vk::PipelineCache operator*() const { return m_pipelineCache; }
+	[[nodiscard]] vk::PipelineCache getPipelineCache() const { return m_pipelineCache; }
+	// Whether the pipelines of the last run were found on disk.
+	[[nodiscard]] bool wasLoaded() const { return m_nLoadedSize > 0; }
+
+	// Written next to the final file and renamed, returns false if the cache couldn't be saved.
+	bool save() const;
+
+private:
+	[[nodiscard]] Header makeHeader() const;
+	// Empty if the file is missing, corrupt or was written by another device or driver.
+	[[nodiscard]] std::vector< char > load() const;
+
+	vk::Device m_device;
+	vk::PhysicalDeviceProperties m_properties;
+	vk::PipelineCache m_pipelineCache;
+	size_t m_nLoadedSize = 0;
+};
+
+} // namespace cat
+
+#endif // CATENGINE_CATPIPELINECACHE_HPP
@@ -24,6 +24,7 @@ public:
 
 	[[nodiscard]] vk::RenderPass getSwapChainRenderPass() const { return m_pSwapChain->getRenderPass(); }
 	[[nodiscard]] float getAspectRatio() const { return m_pSwapChain->extentAspectRatio(); }
+	[[nodiscard]] vk::Extent2D getExtent() const { return m_pSwapChain->getSwapChainExtent(); }
 	[[nodiscard]] size_t getImageCount() const { return m_pSwapChain->getImageCount(); }
 	[[nodiscard]] bool isFrameInProgress() const { return m_bIsFrameStarted; }
 
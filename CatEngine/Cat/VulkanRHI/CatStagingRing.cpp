@@ -0,0 +1,78 @@
+#include "CatStagingRing.hpp"
+
+namespace cat
+{
+static uint64_t AlignUp( const uint64_t nValue, const uint64_t nAlignment )
+{
+	return ( nValue + nAlignment - 1 ) / nAlignment * nAlignment;
+}
+
+CatStagingRing::CatStagingRing( const uint64_t nSize, const uint64_t nAlignment )
+	: m_nSize( nSize ), m_nAlignment( nAlignment )
+{
+}
+
+bool CatStagingRing::reserve( const uint64_t nSize, uint64_t& nOffset )
+{
+	const auto nAlignedSize = AlignUp( nSize, m_nAlignment );
+	// Only when nothing can still be read, batches without ring space don't move the tail but are in flight too.
+	if ( m_nUsed == 0 && m_nInFlight == 0 )
+	{
+		m_nHead = m_nTail = 0;
+	}
+
+	// The used part is [tail, head) unless it wrapped around the end of the ring.
+	uint64_t nReserved = 0;
+	const bool bWrapped = m_nHead < m_nTail || ( m_nHead == m_nTail && m_nUsed > 0 );
+	if ( !bWrapped )
+	{
+		if ( m_nHead + nAlignedSize <= m_nSize )
+		{
+			nOffset = m_nHead;
+			nReserved = nAlignedSize;
+		}
+		else if ( nAlignedSize < m_nTail )
+		{
+			// The end of the ring is skipped, it is given back with this reservation's batch.
+			nOffset = 0;
+			nReserved = m_nSize - m_nHead + nAlignedSize;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if ( m_nHead + nAlignedSize < m_nTail )
+	{
+		nOffset = m_nHead;
+		nReserved = nAlignedSize;
+	}
+	else
+	{
+		return false;
+	}
+
+	m_nHead = nOffset + nAlignedSize;
+	m_nUsed += nReserved;
+	m_nPending += nReserved;
+	return true;
+}
+
+CatStagingRing::Range CatStagingRing::submit()
+{
+	const Range range{ .nEnd = m_nHead, .nBytes = m_nPending };
+	m_nPending = 0;
+	++m_nInFlight;
+	return range;
+}
+
+void CatStagingRing::release( const Range& range )
+{
+	--m_nInFlight;
+	// The head of a batch without ring space can be from before the ring was last reset.
+	if ( range.nBytes == 0 ) return;
+
+	m_nTail = range.nEnd;
+	m_nUsed -= range.nBytes;
+}
+} // namespace cat
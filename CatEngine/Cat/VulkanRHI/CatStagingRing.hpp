@@ -0,0 +1,46 @@
+#ifndef CATENGINE_CATSTAGINGRING_HPP
+#define CATENGINE_CATSTAGINGRING_HPP
+
+#include <cstdint>
+
+namespace cat
+{
+// Bookkeeping of CatUploader's staging ring, without the memory itself. Reservations are grouped into batches, which are
+// released in the order they were submitted once the GPU finished reading them. Not thread safe.
+class CatStagingRing
+{
+public:
+	// What a submitted batch holds of the ring, the tail moves to nEnd once it is released.
+	struct Range
+	{
+		uint64_t nEnd = 0;
+		uint64_t nBytes = 0;
+	};
+
+	CatStagingRing( uint64_t nSize, uint64_t nAlignment );
+
+	// nOffset is where nSize bytes can be written. False if the ring is too full, until a batch is released.
+	[[nodiscard]] bool reserve( uint64_t nSize, uint64_t& nOffset );
+	// Closes the reservations made since the last call into a batch. Every batch has to be submitted and released,
+	// including the ones without ring space.
+	[[nodiscard]] Range submit();
+	void release( const Range& range );
+
+	// Including the skipped ends of wrapped reservations.
+	[[nodiscard]] uint64_t getUsed() const { return m_nUsed; }
+	[[nodiscard]] uint64_t getPending() const { return m_nPending; }
+	[[nodiscard]] uint64_t getSize() const { return m_nSize; }
+
+private:
+	uint64_t m_nSize;
+	uint64_t m_nAlignment;
+	uint64_t m_nHead = 0;
+	uint64_t m_nTail = 0;
+	uint64_t m_nUsed = 0;
+	// Reserved but not submitted yet.
+	uint64_t m_nPending = 0;
+	uint32_t m_nInFlight = 0;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATSTAGINGRING_HPP
@@ -50,14 +50,14 @@ CatSwapChain::~CatSwapChain()
 	{
 		(**m_pDevice).destroyImageView( m_aDepthImageViews[i] );
 		(**m_pDevice).destroyImage( m_aDepthImages[i] );
-		(**m_pDevice).freeMemory( m_aDepthImageMemorys[i] );
+		m_pDevice->getAllocator().free( m_aDepthImageAllocations[i] );
 	}
 
 	for ( int i = 0; i < m_aColorImages.size(); i++ )
 	{
 		(**m_pDevice).destroyImageView( m_aColorImageViews[i] );
 		(**m_pDevice).destroyImage( m_aColorImages[i] );
-		(**m_pDevice).freeMemory( m_aColorImageMemorys[i] );
+		m_pDevice->getAllocator().free( m_aColorImageAllocations[i] );
 	}
 
 
@@ -203,7 +203,7 @@ void CatSwapChain::createImageViews()
 
 	m_aColorImages.resize( m_aSwapChainImages.size() );
 	m_aColorImageViews.resize( m_aSwapChainImages.size() );
-	m_aColorImageMemorys.resize( m_aSwapChainImages.size() );
+	m_aColorImageAllocations.resize( m_aSwapChainImages.size() );
 
 	for ( size_t i = 0; i < m_aSwapChainImages.size(); i++ )
 	{
@@ -244,7 +244,8 @@ void CatSwapChain::createImageViews()
 		};
 
 		m_pDevice->createImageWithInfo(
-			imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_aColorImages[i], m_aColorImageMemorys[i] );
+			imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_aColorImages[i], m_aColorImageAllocations[i],
+			AllocationStrategy::eDedicated );
 
 		vk::ImageViewCreateInfo colorViewInfo{
 			.image = m_aColorImages[i],
@@ -379,7 +380,7 @@ void CatSwapChain::createDepthResources()
 	vk::Extent2D swapChainExtent = getSwapChainExtent();
 
 	m_aDepthImages.resize( getImageCount() );
-	m_aDepthImageMemorys.resize( getImageCount() );
+	m_aDepthImageAllocations.resize( getImageCount() );
 	m_aDepthImageViews.resize( getImageCount() );
 
 	for ( int i = 0; i < m_aDepthImages.size(); i++ )
@@ -403,7 +404,8 @@ void CatSwapChain::createDepthResources()
 		};
 
 		m_pDevice->createImageWithInfo(
-			imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_aDepthImages[i], m_aDepthImageMemorys[i] );
+			imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, m_aDepthImages[i], m_aDepthImageAllocations[i],
+			AllocationStrategy::eDedicated );
 
 		vk::ImageViewCreateInfo viewInfo{
 			.image = m_aDepthImages[i],
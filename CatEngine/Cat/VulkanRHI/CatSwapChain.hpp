@@ -64,10 +64,10 @@ private:
 	vk::RenderPass m_pRenderPass;
 
 	std::vector< vk::Image > m_aDepthImages;
-	std::vector< vk::DeviceMemory > m_aDepthImageMemorys;
+	std::vector< CatAllocation > m_aDepthImageAllocations;
 	std::vector< vk::ImageView > m_aDepthImageViews;
 	std::vector< vk::Image > m_aColorImages;
-	std::vector< vk::DeviceMemory > m_aColorImageMemorys;
+	std::vector< CatAllocation > m_aColorImageAllocations;
 	std::vector< vk::ImageView > m_aColorImageViews;
 	std::vector< vk::Image > m_aSwapChainImages;
 	std::vector< vk::ImageView > m_aSwapChainImageViews;
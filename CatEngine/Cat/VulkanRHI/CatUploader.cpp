@@ -0,0 +1,482 @@
+#include "CatUploader.hpp"
+
+#include "Cat/VulkanRHI/CatBuffer.hpp"
+#include "Cat/VulkanRHI/CatDevice.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace cat
+{
+static vk::DeviceSize GetRingAlignment( CatDevice* pDevice )
+{
+	const auto limits = pDevice->getPhysicalDevice().getProperties().limits;
+	return std::max< vk::DeviceSize >( 16, limits.optimalBufferCopyOffsetAlignment );
+}
+
+CatUploader::CatUploader( CatDevice* pDevice ) : m_pDevice{ pDevice }, m_ring( RING_SIZE, GetRingAlignment( pDevice ) )
+{
+	const auto queueFamilies = m_pDevice->findPhysicalQueueFamilies();
+	m_nTransferFamily = queueFamilies.nTransferFamily.value();
+	m_nGraphicsFamily = queueFamilies.nGraphicsFamily.value();
+
+	const vk::CommandPoolCreateInfo transferPoolInfo = {
+		.flags = vk::CommandPoolCreateFlagBits::eTransient,
+		.queueFamilyIndex = m_nTransferFamily,
+	};
+	const vk::CommandPoolCreateInfo graphicsPoolInfo = {
+		.flags = vk::CommandPoolCreateFlagBits::eTransient,
+		.queueFamilyIndex = m_nGraphicsFamily,
+	};
+	if ( ( **m_pDevice ).createCommandPool( &transferPoolInfo, nullptr, &m_transferCommandPool ) != vk::Result::eSuccess
+		 || ( **m_pDevice ).createCommandPool( &graphicsPoolInfo, nullptr, &m_graphicsCommandPool ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "failed to create upload command pools!" );
+	}
+
+	m_pDevice->createBuffer( RING_SIZE, vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, m_ringBuffer, m_ringAllocation,
+		AllocationStrategy::eDedicated );
+
+	if ( m_nTransferFamily != m_nGraphicsFamily )
+	{
+		LOG_F( INFO, "Uploads transfer ownership from queue family %u to %u", m_nTransferFamily, m_nGraphicsFamily );
+	}
+
+	m_worker = std::thread( [this] { run(); } );
+}
+
+CatUploader::~CatUploader()
+{
+	{
+		const std::lock_guard lock( m_mutex );
+		m_bStop = true;
+	}
+	m_cvWork.notify_one();
+	// The worker submits what is pending and waits for everything in flight.
+	m_worker.join();
+
+	for ( const auto fence : m_aFreeFences )
+	{
+		( **m_pDevice ).destroyFence( fence );
+	}
+	for ( const auto semaphore : m_aFreeSemaphores )
+	{
+		( **m_pDevice ).destroySemaphore( semaphore );
+	}
+	( **m_pDevice ).destroyCommandPool( m_transferCommandPool );
+	( **m_pDevice ).destroyCommandPool( m_graphicsCommandPool );
+	( **m_pDevice ).destroy( m_ringBuffer );
+	m_pDevice->getAllocator().free( m_ringAllocation );
+}
+
+std::shared_future< void > CatUploader::uploadBuffer( const vk::Buffer dstBuffer,
+	const void* pData,
+	const vk::DeviceSize nSize,
+	const vk::DeviceSize nDstOffset,
+	const vk::PipelineStageFlags dstStages,
+	const vk::AccessFlags dstAccess )
+{
+	Upload upload{};
+	upload.dstBuffer = dstBuffer;
+	upload.bufferCopy = vk::BufferCopy{ .srcOffset = 0, .dstOffset = nDstOffset, .size = nSize };
+	upload.dstStages = dstStages;
+	upload.dstAccess = dstAccess;
+
+	return enqueue( std::move( upload ), pData, nSize );
+}
+
+std::shared_future< void > CatUploader::uploadImage( const vk::Image dstImage,
+	const void* pData,
+	const vk::DeviceSize nSize,
+	std::vector< vk::BufferImageCopy > aRegions,
+	const vk::ImageSubresourceRange& subresourceRange,
+	const vk::ImageLayout finalLayout,
+	const vk::PipelineStageFlags dstStages )
+{
+	Upload upload{};
+	upload.dstImage = dstImage;
+	upload.aImageCopies = std::move( aRegions );
+	upload.subresourceRange = subresourceRange;
+	upload.finalLayout = finalLayout;
+	upload.dstStages = dstStages;
+	upload.dstAccess = vk::AccessFlagBits::eShaderRead;
+
+	return enqueue( std::move( upload ), pData, nSize );
+}
+
+void CatUploader::flush()
+{
+	{
+		const std::lock_guard lock( m_mutex );
+		m_bFlush = true;
+	}
+	m_cvWork.notify_one();
+}
+
+CatUploader::Stats CatUploader::getStats()
+{
+	const std::lock_guard lock( m_mutex );
+	auto stats = m_stats;
+	stats.nRingUsed = m_ring.getUsed();
+	stats.nPending = m_aPending.size();
+	stats.nInFlight = m_aInFlight.size();
+	return stats;
+}
+
+std::shared_future< void > CatUploader::enqueue( Upload&& upload, const void* pData, const vk::DeviceSize nSize )
+{
+	auto fUploaded = upload.promise.get_future().share();
+	if ( nSize == 0 )
+	{
+		upload.promise.set_value();
+		return fUploaded;
+	}
+
+	if ( nSize > MAX_RING_UPLOAD_SIZE )
+	{
+		upload.pOwnStaging = std::make_unique< CatBuffer >( m_pDevice, nSize, 1, vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent );
+		upload.pOwnStaging->map();
+		std::memcpy( upload.pOwnStaging->getMappedMemory(), pData, nSize );
+		upload.srcBuffer = upload.pOwnStaging->getBuffer();
+	}
+
+	std::unique_lock lock( m_mutex );
+
+	if ( !upload.pOwnStaging )
+	{
+		// The copy happens under the lock, ring space has to be handed back in the order it was reserved.
+		while ( !m_ring.reserve( nSize, upload.nSrcOffset ) )
+		{
+			m_bFlush = true;
+			m_cvWork.notify_one();
+			m_cvRingSpace.wait( lock );
+		}
+		std::memcpy( static_cast< std::byte* >( m_ringAllocation.pMapped ) + upload.nSrcOffset, pData, nSize );
+		upload.srcBuffer = m_ringBuffer;
+	}
+
+	upload.bufferCopy.srcOffset += upload.nSrcOffset;
+	for ( auto& region : upload.aImageCopies )
+	{
+		region.bufferOffset += upload.nSrcOffset;
+	}
+
+	if ( m_aPending.empty() )
+	{
+		m_tFirstPending = std::chrono::steady_clock::now();
+	}
+	m_aPending.push_back( std::move( upload ) );
+	m_nPendingBytes += nSize;
+	m_stats.nUploads++;
+	m_stats.nBytes += nSize;
+
+	lock.unlock();
+	m_cvWork.notify_one();
+	return fUploaded;
+}
+
+void CatUploader::run()
+{
+	std::unique_lock lock( m_mutex );
+	while ( true )
+	{
+		// Batches complete in submission order.
+		std::vector< std::unique_ptr< Batch > > aCompleted;
+		while ( !m_aInFlight.empty()
+				&& ( !m_aInFlight.front()->fence
+					 || ( **m_pDevice ).getFenceStatus( m_aInFlight.front()->fence ) == vk::Result::eSuccess ) )
+		{
+			m_ring.release( m_aInFlight.front()->ringRange );
+			aCompleted.push_back( std::move( m_aInFlight.front() ) );
+			m_aInFlight.pop_front();
+		}
+		if ( !aCompleted.empty() )
+		{
+			m_cvRingSpace.notify_all();
+			lock.unlock();
+			for ( auto& pBatch : aCompleted )
+			{
+				retire( *pBatch );
+			}
+			lock.lock();
+		}
+
+		if ( !m_aPending.empty() )
+		{
+			// Loader threads tend to upload together, give them a moment to join the batch.
+			m_cvWork.wait_until( lock, m_tFirstPending + BATCH_WINDOW,
+				[this] { return m_bFlush || m_bStop || m_nPendingBytes >= BATCH_SIZE; } );
+
+			auto pBatch = std::make_unique< Batch >();
+			pBatch->aUploads = std::move( m_aPending );
+			pBatch->ringRange = m_ring.submit();
+			m_aPending.clear();
+			m_nPendingBytes = 0;
+			m_bFlush = false;
+			m_stats.nBatches++;
+
+			lock.unlock();
+			try
+			{
+				submit( *pBatch );
+			}
+			catch ( const std::exception& e )
+			{
+				LOG_F( ERROR, "Failed to submit %zu uploads: %s", pBatch->aUploads.size(), e.what() );
+				for ( auto& upload : pBatch->aUploads )
+				{
+					upload.promise.set_exception( std::current_exception() );
+				}
+				pBatch->aUploads.clear();
+			}
+			lock.lock();
+
+			// A failed submit left nothing running, the batch is retired right away.
+			if ( !pBatch->bSubmitted && pBatch->fence )
+			{
+				m_aFreeFences.push_back( pBatch->fence );
+				pBatch->fence = nullptr;
+			}
+
+			m_aInFlight.push_back( std::move( pBatch ) );
+		}
+		else if ( !m_aInFlight.empty() )
+		{
+			const auto fence = m_aInFlight.front()->fence;
+			lock.unlock();
+			// Short timeout, new uploads may arrive in the meantime.
+			( **m_pDevice ).waitForFences( 1, &fence, true, 1'000'000 );
+			lock.lock();
+		}
+		else if ( m_bStop )
+		{
+			break;
+		}
+		else
+		{
+			m_cvWork.wait( lock, [this] { return m_bStop || !m_aPending.empty(); } );
+		}
+	}
+}
+
+void CatUploader::submit( Batch& batch )
+{
+	const auto device = **m_pDevice;
+	const bool bOwnershipTransfer = m_nTransferFamily != m_nGraphicsFamily;
+
+	vk::CommandBufferAllocateInfo allocInfo{
+		.commandPool = m_transferCommandPool,
+		.level = vk::CommandBufferLevel::ePrimary,
+		.commandBufferCount = 1,
+	};
+	device.allocateCommandBuffers( &allocInfo, &batch.transferCommandBuffer );
+
+	const vk::CommandBufferBeginInfo beginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
+	batch.transferCommandBuffer.begin( beginInfo );
+	record( batch.transferCommandBuffer, batch, bOwnershipTransfer, false );
+	batch.transferCommandBuffer.end();
+
+	vk::PipelineStageFlags acquireStages;
+	if ( bOwnershipTransfer )
+	{
+		allocInfo.commandPool = m_graphicsCommandPool;
+		device.allocateCommandBuffers( &allocInfo, &batch.graphicsCommandBuffer );
+
+		batch.graphicsCommandBuffer.begin( beginInfo );
+		record( batch.graphicsCommandBuffer, batch, false, true );
+		batch.graphicsCommandBuffer.end();
+
+		for ( const auto& upload : batch.aUploads )
+		{
+			acquireStages |= upload.dstStages;
+		}
+	}
+
+	{
+		const std::lock_guard lock( m_mutex );
+		if ( bOwnershipTransfer && !m_aFreeSemaphores.empty() )
+		{
+			batch.semaphore = m_aFreeSemaphores.back();
+			m_aFreeSemaphores.pop_back();
+		}
+		if ( !m_aFreeFences.empty() )
+		{
+			batch.fence = m_aFreeFences.back();
+			m_aFreeFences.pop_back();
+		}
+	}
+	if ( bOwnershipTransfer && !batch.semaphore )
+	{
+		const vk::SemaphoreCreateInfo semaphoreInfo{};
+		device.createSemaphore( &semaphoreInfo, nullptr, &batch.semaphore );
+	}
+	if ( !batch.fence )
+	{
+		const vk::FenceCreateInfo fenceInfo{};
+		device.createFence( &fenceInfo, nullptr, &batch.fence );
+	}
+
+	const vk::SubmitInfo transferSubmitInfo{
+		.commandBufferCount = 1,
+		.pCommandBuffers = &batch.transferCommandBuffer,
+		.signalSemaphoreCount = bOwnershipTransfer ? 1u : 0u,
+		.pSignalSemaphores = &batch.semaphore,
+	};
+	const vk::SubmitInfo graphicsSubmitInfo{
+		.waitSemaphoreCount = 1,
+		.pWaitSemaphores = &batch.semaphore,
+		.pWaitDstStageMask = &acquireStages,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &batch.graphicsCommandBuffer,
+	};
+
+	const std::lock_guard lock( CatDevice::m_mutex );
+	if ( m_pDevice->getTransferQueue().submit( 1, &transferSubmitInfo, bOwnershipTransfer ? nullptr : batch.fence )
+		 != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "failed to submit upload batch!" );
+	}
+	if ( bOwnershipTransfer
+		 && m_pDevice->getGraphicsQueue().submit( 1, &graphicsSubmitInfo, batch.fence ) != vk::Result::eSuccess )
+	{
+		// The copies are running without a fence, the command buffers can only be freed once they finished.
+		// Nothing waits on the semaphore they signal, so it can't be reused either.
+		m_pDevice->getTransferQueue().waitIdle();
+		device.destroySemaphore( batch.semaphore );
+		batch.semaphore = nullptr;
+		throw std::runtime_error( "failed to submit upload ownership acquire!" );
+	}
+	batch.bSubmitted = true;
+}
+
+// Without an ownership transfer the transfer queue is the graphics queue, and a single barrier makes the uploads visible.
+// With one, the transfer queue releases (bRelease) and the graphics queue acquires (bAcquire) the same ranges.
+void CatUploader::record( const vk::CommandBuffer commandBuffer,
+	const Batch& batch,
+	const bool bRelease,
+	const bool bAcquire ) const
+{
+	if ( !bAcquire )
+	{
+		std::vector< vk::ImageMemoryBarrier > aToTransfer;
+		for ( const auto& upload : batch.aUploads )
+		{
+			if ( !upload.dstImage ) continue;
+			aToTransfer.push_back( vk::ImageMemoryBarrier{
+				.srcAccessMask = {},
+				.dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+				.oldLayout = vk::ImageLayout::eUndefined,
+				.newLayout = vk::ImageLayout::eTransferDstOptimal,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = upload.dstImage,
+				.subresourceRange = upload.subresourceRange,
+			} );
+		}
+		if ( !aToTransfer.empty() )
+		{
+			commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, 0,
+				nullptr, 0, nullptr, static_cast< uint32_t >( aToTransfer.size() ), aToTransfer.data() );
+		}
+
+		for ( const auto& upload : batch.aUploads )
+		{
+			if ( upload.dstImage )
+			{
+				commandBuffer.copyBufferToImage( upload.srcBuffer, upload.dstImage, vk::ImageLayout::eTransferDstOptimal,
+					static_cast< uint32_t >( upload.aImageCopies.size() ), upload.aImageCopies.data() );
+			}
+			else
+			{
+				commandBuffer.copyBuffer( upload.srcBuffer, upload.dstBuffer, 1, &upload.bufferCopy );
+			}
+		}
+	}
+
+	const bool bTransfer = bRelease || bAcquire;
+	const auto nSrcFamily = bTransfer ? m_nTransferFamily : VK_QUEUE_FAMILY_IGNORED;
+	const auto nDstFamily = bTransfer ? m_nGraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+	const vk::AccessFlags srcAccess = bAcquire ? vk::AccessFlags{} : vk::AccessFlagBits::eTransferWrite;
+
+	std::vector< vk::BufferMemoryBarrier > aBufferBarriers;
+	std::vector< vk::ImageMemoryBarrier > aImageBarriers;
+	vk::PipelineStageFlags dstStages;
+	for ( const auto& upload : batch.aUploads )
+	{
+		const auto dstAccess = bRelease ? vk::AccessFlags{} : upload.dstAccess;
+		dstStages |= upload.dstStages;
+
+		if ( upload.dstImage )
+		{
+			aImageBarriers.push_back( vk::ImageMemoryBarrier{
+				.srcAccessMask = srcAccess,
+				.dstAccessMask = dstAccess,
+				.oldLayout = vk::ImageLayout::eTransferDstOptimal,
+				.newLayout = upload.finalLayout,
+				.srcQueueFamilyIndex = nSrcFamily,
+				.dstQueueFamilyIndex = nDstFamily,
+				.image = upload.dstImage,
+				.subresourceRange = upload.subresourceRange,
+			} );
+		}
+		else
+		{
+			aBufferBarriers.push_back( vk::BufferMemoryBarrier{
+				.srcAccessMask = srcAccess,
+				.dstAccessMask = dstAccess,
+				.srcQueueFamilyIndex = nSrcFamily,
+				.dstQueueFamilyIndex = nDstFamily,
+				.buffer = upload.dstBuffer,
+				.offset = upload.bufferCopy.dstOffset,
+				.size = upload.bufferCopy.size,
+			} );
+		}
+	}
+
+	const auto srcStage = bAcquire ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eTransfer;
+	const auto dstStage = bRelease ? vk::PipelineStageFlags( vk::PipelineStageFlagBits::eBottomOfPipe ) : dstStages;
+	commandBuffer.pipelineBarrier( srcStage, dstStage, {}, 0, nullptr, static_cast< uint32_t >( aBufferBarriers.size() ),
+		aBufferBarriers.data(), static_cast< uint32_t >( aImageBarriers.size() ), aImageBarriers.data() );
+}
+
+void CatUploader::retire( Batch& batch )
+{
+	const auto device = **m_pDevice;
+
+	if ( batch.transferCommandBuffer )
+	{
+		device.freeCommandBuffers( m_transferCommandPool, 1, &batch.transferCommandBuffer );
+	}
+	if ( batch.graphicsCommandBuffer )
+	{
+		device.freeCommandBuffers( m_graphicsCommandPool, 1, &batch.graphicsCommandBuffer );
+	}
+	if ( batch.fence )
+	{
+		device.resetFences( 1, &batch.fence );
+	}
+	{
+		const std::lock_guard lock( m_mutex );
+		if ( batch.semaphore )
+		{
+			m_aFreeSemaphores.push_back( batch.semaphore );
+		}
+		if ( batch.fence )
+		{
+			m_aFreeFences.push_back( batch.fence );
+		}
+	}
+
+	for ( auto& upload : batch.aUploads )
+	{
+		upload.pOwnStaging.reset();
+		upload.promise.set_value();
+	}
+}
+
+} // namespace cat
@@ -0,0 +1,147 @@
+#ifndef CATENGINE_CATUPLOADER_HPP
+#define CATENGINE_CATUPLOADER_HPP
+
+#include "Cat/VulkanRHI/CatAllocator.hpp"
+#include "Cat/VulkanRHI/CatStagingRing.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cat
+{
+class CatDevice;
+class CatBuffer;
+
+// Uploads buffers and images from any thread. The data is copied into a persistently mapped staging ring right away,
+// a worker thread records the copies of everyone who uploaded in the same window into one transfer submission,
+// releases the resources to the graphics queue family and resolves the returned futures once the fence signaled.
+class CatUploader
+{
+public:
+	static constexpr vk::DeviceSize RING_SIZE = vk::DeviceSize( 64 ) << 20;
+	// Larger uploads get their own staging buffer instead of blocking the ring.
+	static constexpr vk::DeviceSize MAX_RING_UPLOAD_SIZE = RING_SIZE / 4;
+	// A batch is submitted once its first upload waited this long, or once it holds this many bytes.
+	static constexpr auto BATCH_WINDOW = std::chrono::microseconds( 250 );
+	static constexpr vk::DeviceSize BATCH_SIZE = vk::DeviceSize( 16 ) << 20;
+
+	static constexpr vk::PipelineStageFlags VERTEX_INPUT_STAGES = vk::PipelineStageFlagBits::eVertexInput;
+	static constexpr vk::AccessFlags VERTEX_INPUT_ACCESS = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead;
+	static constexpr vk::PipelineStageFlags SHADER_STAGES = vk::PipelineStageFlagBits::eVertexShader
+		| vk::PipelineStageFlagBits::eTessellationControlShader | vk::PipelineStageFlagBits::eTessellationEvaluationShader
+		| vk::PipelineStageFlagBits::eFragmentShader;
+
+	struct Stats
+	{
+		uint64_t nUploads = 0;
+		uint64_t nBatches = 0;
+		uint64_t nBytes = 0;
+		vk::DeviceSize nRingUsed = 0;
+		size_t nPending = 0;
+		size_t nInFlight = 0;
+	};
+
+	explicit CatUploader( CatDevice* pDevice );
+	~CatUploader();
+
+	CatUploader( const CatUploader& ) = delete;
+	CatUploader& operator=( const CatUploader& ) = delete;
+
+	// pData can be freed once these return. The resource must not be used before the future is ready.
+	[[nodiscard]] std::shared_future< void > uploadBuffer( vk::Buffer dstBuffer,
+		const void* pData,
+		vk::DeviceSize nSize,
+		vk::DeviceSize nDstOffset = 0,
+		vk::PipelineStageFlags dstStages = VERTEX_INPUT_STAGES,
+		vk::AccessFlags dstAccess = VERTEX_INPUT_ACCESS );
+	// Region buffer offsets are relative to pData. The whole subresource range ends up in finalLayout.
+	[[nodiscard]] std::shared_future< void > uploadImage( vk::Image dstImage,
+		const void* pData,
+		vk::DeviceSize nSize,
+		std::vector< vk::BufferImageCopy > aRegions,
+		const vk::ImageSubresourceRange& subresourceRange,
+		vk::ImageLayout finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+		vk::PipelineStageFlags dstStages = SHADER_STAGES );
+
+	// Submits the pending uploads without waiting for the batch window.
+	void flush();
+
+	[[nodiscard]] Stats getStats();
+
+private:
+	struct Upload
+	{
+		vk::Buffer srcBuffer;
+		vk::DeviceSize nSrcOffset = 0;
+		// Staging memory of uploads too large for the ring.
+		std::unique_ptr< CatBuffer > pOwnStaging;
+
+		vk::Buffer dstBuffer;
+		vk::BufferCopy bufferCopy;
+
+		vk::Image dstImage;
+		std::vector< vk::BufferImageCopy > aImageCopies;
+		vk::ImageSubresourceRange subresourceRange;
+		vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined;
+
+		vk::PipelineStageFlags dstStages;
+		vk::AccessFlags dstAccess;
+		std::promise< void > promise;
+	};
+
+	struct Batch
+	{
+		std::vector< Upload > aUploads;
+		vk::CommandBuffer transferCommandBuffer;
+		vk::CommandBuffer graphicsCommandBuffer;
+		vk::Semaphore semaphore;
+		vk::Fence fence;
+		// Set once both submits went through, the fence is only signaled then.
+		bool bSubmitted = false;
+		// Ring space is returned in submission order.
+		CatStagingRing::Range ringRange;
+	};
+
+	void run();
+	// Copies pData into the ring, or its own staging buffer if it is too large, and queues the upload.
+	[[nodiscard]] std::shared_future< void > enqueue( Upload&& upload, const void* pData, vk::DeviceSize nSize );
+	// Worker thread only, it owns the command pools. The free fences and semaphores are taken and returned under m_mutex.
+	void submit( Batch& batch );
+	void record( vk::CommandBuffer commandBuffer, const Batch& batch, bool bRelease, bool bAcquire ) const;
+	void retire( Batch& batch );
+
+	CatDevice* m_pDevice;
+	uint32_t m_nTransferFamily;
+	uint32_t m_nGraphicsFamily;
+	vk::CommandPool m_transferCommandPool;
+	vk::CommandPool m_graphicsCommandPool;
+
+	vk::Buffer m_ringBuffer;
+	CatAllocation m_ringAllocation;
+	// Guarded by m_mutex.
+	CatStagingRing m_ring;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cvWork;
+	std::condition_variable m_cvRingSpace;
+	std::vector< Upload > m_aPending;
+	vk::DeviceSize m_nPendingBytes = 0;
+	std::chrono::steady_clock::time_point m_tFirstPending;
+	std::deque< std::unique_ptr< Batch > > m_aInFlight;
+	std::vector< vk::Fence > m_aFreeFences;
+	std::vector< vk::Semaphore > m_aFreeSemaphores;
+	bool m_bFlush = false;
+	bool m_bStop = false;
+	Stats m_stats;
+
+	std::thread m_worker;
+};
+} // namespace cat
+
+#endif // CATENGINE_CATUPLOADER_HPP
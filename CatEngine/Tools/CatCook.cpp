@@ -0,0 +1,40 @@
+#include "Cat/Objects/CatModel.hpp"
+#include "Cat/Objects/CatMeshCache.hpp"
+
+#include <loguru.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+// Cooks models into the mesh cache ahead of time, so even the first load of a level skips parsing.
+// Run it from the directory the engine runs in, with the model paths as the levels reference them:
+// CatCook assets/models/sponza.obj assets/models/cube.obj
+int main( int argc, char** argv )
+{
+	loguru::init( argc, argv );
+
+	int nFailed = 0;
+	for ( int i = 1; i < argc; ++i )
+	{
+		const std::string sPath( argv[i] );
+		try
+		{
+			cat::CatModel::Builder builder{};
+			builder.loadModel( sPath );
+			if ( !cat::CatMeshCache::cook( sPath, cat::CatMeshCache::hashFile( sPath ), builder ) )
+			{
+				++nFailed;
+				continue;
+			}
+			LOG_F( INFO, "Cooked %s: %zu vertices, %zu indices", sPath.c_str(), builder.aVertices.size(), builder.aIndices.size() );
+		}
+		catch ( const std::exception& e )
+		{
+			LOG_F( ERROR, "Failed to cook %s: %s", sPath.c_str(), e.what() );
+			++nFailed;
+		}
+	}
+
+	return nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
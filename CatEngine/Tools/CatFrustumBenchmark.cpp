@@ -0,0 +1,158 @@
+#include "Cat/Rendering/CatFrustum.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Compares CatFrustum::checkSphere/checkAABB called per bound with the batched scalar, SSE and AVX2 implementations.
+// CatFrustumBenchmark [iterations = 20]
+struct Bounds
+{
+	std::vector< float > aX, aY, aZ, aRadius, aExtentX, aExtentY, aExtentZ;
+};
+
+// Spread around the camera like the contents of the loaded chunks, mostly flat.
+static Bounds GenerateBounds( const size_t nCount )
+{
+	std::mt19937 rng( 1337 );
+	std::uniform_real_distribution< float > position( -500.0f, 500.0f );
+	std::uniform_real_distribution< float > size( 0.1f, 8.0f );
+
+	Bounds bounds;
+	for ( auto* pArray : { &bounds.aX, &bounds.aY, &bounds.aZ, &bounds.aRadius, &bounds.aExtentX, &bounds.aExtentY,
+			  &bounds.aExtentZ } )
+	{
+		pArray->resize( nCount );
+	}
+	for ( size_t i = 0; i < nCount; ++i )
+	{
+		bounds.aX[i] = position( rng );
+		bounds.aY[i] = position( rng ) * 0.1f;
+		bounds.aZ[i] = position( rng );
+		bounds.aExtentX[i] = size( rng );
+		bounds.aExtentY[i] = size( rng );
+		bounds.aExtentZ[i] = size( rng );
+		bounds.aRadius[i] =
+			std::sqrt( bounds.aExtentX[i] * bounds.aExtentX[i] + bounds.aExtentY[i] * bounds.aExtentY[i]
+					   + bounds.aExtentZ[i] * bounds.aExtentZ[i] );
+	}
+	return bounds;
+}
+
+// The batches evaluate the planes in a different order and with FMAs, so bounds touching a plane can land on either side.
+// Only differences that remain when the bound is grown and shrunk by this are counted.
+static constexpr float BOUNDARY_EPSILON = 1e-3f;
+
+static size_t CountMismatches( const cat::CatFrustum& frustum,
+	const Bounds& bounds,
+	const bool bBoxes,
+	const std::vector< uint8_t >& aVisible,
+	const std::vector< uint8_t >& aReference )
+{
+	size_t nMismatches = 0;
+	for ( size_t i = 0; i < aVisible.size(); ++i )
+	{
+		if ( aVisible[i] == aReference[i] ) continue;
+
+		const glm::vec3 vCenter{ bounds.aX[i], bounds.aY[i], bounds.aZ[i] };
+		const glm::vec3 vExtent{ bounds.aExtentX[i], bounds.aExtentY[i], bounds.aExtentZ[i] };
+		const auto vInner = vExtent - BOUNDARY_EPSILON;
+		const auto vOuter = vExtent + BOUNDARY_EPSILON;
+		const bool bInner = bBoxes ? frustum.checkAABB( vCenter - vInner, vCenter + vInner )
+								   : frustum.checkSphere( vCenter, bounds.aRadius[i] - BOUNDARY_EPSILON );
+		const bool bOuter = bBoxes ? frustum.checkAABB( vCenter - vOuter, vCenter + vOuter )
+								   : frustum.checkSphere( vCenter, bounds.aRadius[i] + BOUNDARY_EPSILON );
+		if ( bInner == bOuter ) ++nMismatches;
+	}
+	return nMismatches;
+}
+
+static double Measure( const int nIterations, const std::function< void() >& fnTest )
+{
+	double dMin = 1e30;
+	for ( int i = 0; i < nIterations; ++i )
+	{
+		const auto tStart = std::chrono::steady_clock::now();
+		fnTest();
+		dMin = std::min( dMin, std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - tStart ).count() );
+	}
+	return dMin;
+}
+
+int main( int argc, char** argv )
+{
+	const int nIterations = argc > 1 ? std::max( 1, std::atoi( argv[1] ) ) : 20;
+
+	using SimdLevel = cat::CatFrustum::SimdLevel;
+	static constexpr const char* LEVEL_NAMES[] = { "scalar", "sse", "avx2" };
+	const auto eSupported = cat::CatFrustum::getSupportedSimdLevel();
+	std::printf( "supported: %s\n", LEVEL_NAMES[static_cast< int >( eSupported )] );
+
+	cat::CatFrustum frustum;
+	const auto mxProjection = glm::perspective( glm::radians( 50.0f ), 1.5f, 0.1f, 1000.0f );
+	const auto mxView = glm::lookAt( glm::vec3( 0.0f, 2.0f, 0.0f ), glm::vec3( 1.0f, 2.0f, 1.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+	frustum.update( mxProjection * mxView );
+
+	std::printf( "%-8s %-7s %12s %12s %12s %12s %9s %s\n", "test", "count", "single (ms)", "scalar (ms)", "sse (ms)", "avx2 (ms)",
+		"speedup", "results" );
+
+	bool bAllSame = true;
+	for ( const size_t nCount : { size_t( 10'000 ), size_t( 100'000 ), size_t( 1'000'000 ) } )
+	{
+		const auto bounds = GenerateBounds( nCount );
+		std::vector< uint8_t > aReference( nCount );
+		std::vector< uint8_t > aVisible( nCount );
+
+		for ( const bool bBoxes : { false, true } )
+		{
+			// The existing per bound methods, the baseline the batches have to beat and match.
+			const double dSingle = Measure( nIterations,
+				[&]
+				{
+					for ( size_t i = 0; i < nCount; ++i )
+					{
+						const glm::vec3 vCenter{ bounds.aX[i], bounds.aY[i], bounds.aZ[i] };
+						const glm::vec3 vExtent{ bounds.aExtentX[i], bounds.aExtentY[i], bounds.aExtentZ[i] };
+						aReference[i] = bBoxes ? frustum.checkAABB( vCenter - vExtent, vCenter + vExtent )
+											   : frustum.checkSphere( vCenter, bounds.aRadius[i] );
+					}
+				} );
+
+			double aBatched[3] = {};
+			bool bSame = true;
+			for ( int nLevel = 0; nLevel <= static_cast< int >( eSupported ); ++nLevel )
+			{
+				frustum.setSimdLevel( static_cast< SimdLevel >( nLevel ) );
+				aBatched[nLevel] = Measure( nIterations,
+					[&]
+					{
+						if ( bBoxes )
+						{
+							frustum.checkAABBs( bounds.aX.data(), bounds.aY.data(), bounds.aZ.data(), bounds.aExtentX.data(),
+								bounds.aExtentY.data(), bounds.aExtentZ.data(), nCount, aVisible.data() );
+						}
+						else
+						{
+							frustum.checkSpheres( bounds.aX.data(), bounds.aY.data(), bounds.aZ.data(), bounds.aRadius.data(),
+								nCount, aVisible.data() );
+						}
+					} );
+				bSame &= CountMismatches( frustum, bounds, bBoxes, aVisible, aReference ) == 0;
+			}
+			bAllSame &= bSame;
+
+			const double dBest = aBatched[static_cast< int >( eSupported )];
+			std::printf( "%-8s %-7zu %12.3f %12.3f %12.3f %12.3f %8.2fx %s\n", bBoxes ? "aabb" : "sphere", nCount, dSingle,
+				aBatched[0], aBatched[1], aBatched[2], dSingle / std::max( dBest, 1e-6 ), bSame ? "same" : "DIFFERENT" );
+		}
+	}
+
+	return bAllSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+#include "Cat/Objects/CatModel.hpp"
+#include "Cat/Objects/CatObjParser.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Compares the tinyobj import path with CatObjParser on every OBJ in a directory.
+// CatObjBenchmark [directory = assets/models] [iterations = 5] [threads = 0 (all)]
+struct Timing
+{
+	double dMin = 0.0;
+	double dAverage = 0.0;
+	cat::CatModel::Builder builder{};
+};
+
+static Timing Measure( const int nIterations, const std::function< void( cat::CatModel::Builder& ) >& fnLoad )
+{
+	Timing timing{};
+	timing.dMin = 1e30;
+	for ( int i = 0; i < nIterations; ++i )
+	{
+		cat::CatModel::Builder builder{};
+		const auto tStart = std::chrono::steady_clock::now();
+		fnLoad( builder );
+		const auto dTime = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - tStart ).count();
+
+		timing.dMin = std::min( timing.dMin, dTime );
+		timing.dAverage += dTime / nIterations;
+		timing.builder = std::move( builder );
+	}
+	return timing;
+}
+
+// Both paths have to produce the same triangles, the vertex order and count differ.
+static bool IsSameMesh( const cat::CatModel::Builder& a, const cat::CatModel::Builder& b )
+{
+	if ( a.aIndices.size() != b.aIndices.size() ) return false;
+
+	for ( size_t i = 0; i < a.aIndices.size(); ++i )
+	{
+		if ( !( a.aVertices[a.aIndices[i]] == b.aVertices[b.aIndices[i]] ) ) return false;
+	}
+	return true;
+}
+
+int main( int argc, char** argv )
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	loguru::init( argc, argv );
+
+	const std::string sDirectory = argc > 1 ? argv[1] : "assets/models";
+	const int nIterations = argc > 2 ? std::max( 1, std::atoi( argv[2] ) ) : 5;
+	const unsigned nThreads = argc > 3 ? static_cast< unsigned >( std::atoi( argv[3] ) ) : 0;
+
+	std::vector< std::filesystem::path > aFiles;
+	for ( const auto& entry : std::filesystem::recursive_directory_iterator( sDirectory ) )
+	{
+		if ( entry.is_regular_file() && entry.path().extension() == ".obj" )
+		{
+			aFiles.push_back( entry.path() );
+		}
+	}
+	std::sort( aFiles.begin(), aFiles.end() );
+
+	std::printf( "%-40s %10s %12s %12s %12s %12s %8s %s\n", "model", "size (KB)", "tinyobj (ms)", "parallel (ms)", "tinyobj vtx",
+		"parallel vtx", "speedup", "triangles" );
+
+	bool bAllSame = true;
+	double dTotalTinyObj = 0.0;
+	double dTotalParallel = 0.0;
+	for ( const auto& path : aFiles )
+	{
+		const auto sPath = path.string();
+		try
+		{
+			const auto tinyObj = Measure( nIterations, [&sPath]( auto& builder ) { builder.loadModelTinyObj( sPath ); } );
+			std::string sError;
+			bool bParsed = true;
+			const auto parallel = Measure( nIterations,
+				[&]( auto& builder ) { bParsed &= cat::CatObjParser::parse( sPath, builder, sError, nThreads ); } );
+
+			if ( !bParsed )
+			{
+				std::printf( "%-40s not supported by the parallel parser: %s\n", path.filename().string().c_str(), sError.c_str() );
+				continue;
+			}
+
+			const bool bSame = IsSameMesh( tinyObj.builder, parallel.builder );
+			bAllSame &= bSame;
+			dTotalTinyObj += tinyObj.dMin;
+			dTotalParallel += parallel.dMin;
+
+			std::printf( "%-40s %10.0f %12.2f %12.2f %12zu %12zu %7.2fx %s\n", path.filename().string().c_str(),
+				double( std::filesystem::file_size( path ) ) / 1024.0, tinyObj.dMin, parallel.dMin, tinyObj.builder.aVertices.size(),
+				parallel.builder.aVertices.size(), tinyObj.dMin / std::max( parallel.dMin, 1e-6 ), bSame ? "same" : "DIFFERENT" );
+		}
+		catch ( const std::exception& e )
+		{
+			std::printf( "%-40s failed: %s\n", path.filename().string().c_str(), e.what() );
+		}
+	}
+
+	std::printf( "total (min of %d): tinyobj %.2f ms, parallel %.2f ms\n", nIterations, dTotalTinyObj, dTotalParallel );
+
+	return bAllSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
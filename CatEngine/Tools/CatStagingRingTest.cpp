@@ -0,0 +1,161 @@
+#include "Cat/VulkanRHI/CatStagingRing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+// Drives CatStagingRing like CatUploader does, with batches of ring uploads mixed with batches that only hold uploads
+// with their own staging buffer, and checks that no reservation overlaps memory a pending or in flight batch still reads.
+// CatStagingRingTest [steps = 1000000]
+namespace
+{
+constexpr uint64_t RING_SIZE = 1024;
+constexpr uint64_t ALIGNMENT = 16;
+
+struct Interval
+{
+	uint64_t nBegin;
+	uint64_t nEnd;
+};
+
+struct Batch
+{
+	cat::CatStagingRing::Range range;
+	std::vector< Interval > aIntervals;
+};
+
+class Simulation
+{
+public:
+	bool reserve( const uint64_t nSize )
+	{
+		uint64_t nOffset = 0;
+		if ( !m_ring.reserve( nSize, nOffset ) ) return false;
+
+		const Interval interval{ nOffset, nOffset + nSize };
+		if ( interval.nEnd > RING_SIZE || nOffset % ALIGNMENT != 0 )
+		{
+			fail( "reservation [%llu, %llu) is outside of the ring or misaligned", interval );
+		}
+		for ( const auto& batch : m_aInFlight )
+		{
+			check( interval, batch.aIntervals, "in flight" );
+		}
+		check( interval, m_pending.aIntervals, "pending" );
+		m_pending.aIntervals.push_back( interval );
+		return true;
+	}
+
+	void submit()
+	{
+		m_pending.range = m_ring.submit();
+		m_aInFlight.push_back( std::move( m_pending ) );
+		m_pending = {};
+	}
+
+	bool release()
+	{
+		if ( m_aInFlight.empty() ) return false;
+
+		m_ring.release( m_aInFlight.front().range );
+		m_aInFlight.pop_front();
+		return true;
+	}
+
+	[[nodiscard]] bool hasFailed() const { return m_bFailed; }
+
+private:
+	void check( const Interval& interval, const std::vector< Interval >& aLive, const char* sState )
+	{
+		for ( const auto& live : aLive )
+		{
+			if ( interval.nBegin < live.nEnd && live.nBegin < interval.nEnd )
+			{
+				fail( "reservation [%llu, %llu) overlaps a copy that is still %s", interval, sState );
+			}
+		}
+	}
+
+	void fail( const char* sFormat, const Interval& interval, const char* sState = "" )
+	{
+		if ( !m_bFailed )
+		{
+			std::printf( sFormat, static_cast< unsigned long long >( interval.nBegin ),
+				static_cast< unsigned long long >( interval.nEnd ), sState );
+			std::printf( "\n" );
+		}
+		m_bFailed = true;
+	}
+
+	cat::CatStagingRing m_ring{ RING_SIZE, ALIGNMENT };
+	Batch m_pending;
+	std::deque< Batch > m_aInFlight;
+	bool m_bFailed = false;
+};
+
+// A batch without ring space submitted before the ring drained used to move the tail back to its stale head once it
+// was released, the next wrapping reservation then landed on copies still in flight.
+bool TestStaleHead()
+{
+	Simulation simulation;
+	simulation.reserve( 200 );
+	simulation.submit();
+	// Only uploads with their own staging buffer, its head is 200.
+	simulation.submit();
+	simulation.release();
+	// The ring drained, this starts over at 0.
+	simulation.reserve( 700 );
+	simulation.submit();
+	simulation.release();
+	simulation.reserve( 300 );
+	// Doesn't fit at the end, wraps around to the copies of the 700 bytes.
+	simulation.reserve( 150 );
+	return !simulation.hasFailed();
+}
+
+bool TestRandom( const int nSteps )
+{
+	std::mt19937 rng( 1337 );
+	std::uniform_int_distribution< uint64_t > size( 1, RING_SIZE / 4 );
+	std::uniform_int_distribution< int > action( 0, 9 );
+
+	Simulation simulation;
+	for ( int i = 0; i < nSteps && !simulation.hasFailed(); ++i )
+	{
+		const int nAction = action( rng );
+		if ( nAction < 5 )
+		{
+			// Blocks like CatUploader::enqueue, the worker submits what is pending and retires the oldest batch.
+			const auto nSize = size( rng );
+			while ( !simulation.reserve( nSize ) )
+			{
+				if ( !simulation.release() ) simulation.submit();
+			}
+		}
+		else if ( nAction < 8 )
+		{
+			simulation.submit();
+		}
+		else
+		{
+			simulation.release();
+		}
+	}
+	return !simulation.hasFailed();
+}
+} // namespace
+
+int main( int argc, char** argv )
+{
+	const int nSteps = argc > 1 ? std::max( 1, std::atoi( argv[1] ) ) : 1'000'000;
+
+	const bool bStaleHead = TestStaleHead();
+	std::printf( "%-12s %s\n", "stale head", bStaleHead ? "ok" : "FAILED" );
+	const bool bRandom = TestRandom( nSteps );
+	std::printf( "%-12s %s\n", "random", bRandom ? "ok" : "FAILED" );
+
+	return bStaleHead && bRandom ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+#include "Cat/Objects/CatTransform.hpp"
+
+#include <BS_thread_pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Compares rebuilding the matrices with TransformComponent::mat4()/normalMatrix() per transform with the batched scalar,
+// SSE and AVX2 rebuilds of CatTransformSystem, on one thread and on the frame job threads.
+// CatTransformBenchmark [iterations = 20]
+static std::vector< cat::TransformComponent > GenerateTransforms( const size_t nCount )
+{
+	std::mt19937 rng( 1337 );
+	std::uniform_real_distribution< float > position( -500.0f, 500.0f );
+	std::uniform_real_distribution< float > angle( -180.0f, 180.0f );
+	std::uniform_real_distribution< float > scale( 0.1f, 8.0f );
+
+	std::vector< cat::TransformComponent > aTransforms( nCount );
+	for ( auto& transform : aTransforms )
+	{
+		transform.translation = { position( rng ), position( rng ) * 0.1f, position( rng ) };
+		transform.rotation = { angle( rng ), angle( rng ), angle( rng ) };
+		transform.scale = { scale( rng ), scale( rng ), scale( rng ) };
+	}
+	return aTransforms;
+}
+
+static double Measure( const int nIterations, const std::function< void() >& fnTest )
+{
+	double dMin = 1e30;
+	for ( int i = 0; i < nIterations; ++i )
+	{
+		const auto tStart = std::chrono::steady_clock::now();
+		fnTest();
+		dMin = std::min( dMin, std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - tStart ).count() );
+	}
+	return dMin;
+}
+
+// Largest difference relative to the magnitude, the batched sine and cosine aren't bit exact.
+static float Compare( const std::vector< cat::TransformComponent >& aReference,
+	const std::vector< cat::TransformComponent >& aTransforms )
+{
+	float fError = 0.0f;
+	for ( size_t i = 0; i < aReference.size(); ++i )
+	{
+		const auto& mxReference = aReference[i].mat4();
+		const auto& mxWorld = aTransforms[i].mat4();
+		const auto& mxReferenceNormal = aReference[i].normalMatrix();
+		const auto& mxNormal = aTransforms[i].normalMatrix();
+		for ( int c = 0; c < 4; ++c )
+		{
+			for ( int r = 0; r < 4; ++r )
+			{
+				fError = std::max(
+					fError, std::abs( mxWorld[c][r] - mxReference[c][r] ) / ( 1.0f + std::abs( mxReference[c][r] ) ) );
+				if ( c == 3 || r == 3 ) continue;
+				fError = std::max( fError,
+					std::abs( mxNormal[c][r] - mxReferenceNormal[c][r] ) / ( 1.0f + std::abs( mxReferenceNormal[c][r] ) ) );
+			}
+		}
+	}
+	return fError;
+}
+
+int main( int argc, char** argv )
+{
+	const int nIterations = argc > 1 ? std::max( 1, std::atoi( argv[1] ) ) : 20;
+
+	using cat::SimdLevel;
+	static constexpr const char* LEVEL_NAMES[] = { "scalar", "sse", "avx2" };
+	const auto eSupported = cat::GetSupportedSimdLevel();
+	std::printf( "supported: %s\n", LEVEL_NAMES[static_cast< int >( eSupported )] );
+
+	BS::thread_pool pool( 4 );
+
+	std::printf( "%-8s %12s %12s %12s %12s %12s %9s %s\n", "count", "mat4 (ms)", "scalar (ms)", "sse (ms)", "avx2 (ms)",
+		"threads (ms)", "speedup", "max error" );
+
+	bool bAllSame = true;
+	for ( const size_t nCount : { size_t( 10'000 ), size_t( 100'000 ), size_t( 1'000'000 ) } )
+	{
+		// The reference stays unregistered, its matrices are built by TransformComponent itself like before.
+		auto aReference = GenerateTransforms( nCount );
+		const double dSingle = Measure( nIterations,
+			[&]
+			{
+				for ( auto& transform : aReference )
+				{
+					transform.markDirty();
+					( void ) transform.mat4();
+					( void ) transform.normalMatrix();
+				}
+			} );
+
+		auto aTransforms = aReference;
+		cat::CatTransformSystem system;
+		for ( auto& transform : aTransforms )
+		{
+			system.add( transform );
+		}
+		// Marking is part of the cost, it copies the components into the blocks.
+		const auto fnRebuild = [&]( BS::thread_pool* pPool )
+		{
+			for ( auto& transform : aTransforms )
+			{
+				transform.markDirty();
+			}
+			system.update( pPool );
+		};
+
+		double aBatched[3] = {};
+		float fError = 0.0f;
+		for ( int nLevel = 0; nLevel <= static_cast< int >( eSupported ); ++nLevel )
+		{
+			system.setSimdLevel( static_cast< SimdLevel >( nLevel ) );
+			aBatched[nLevel] = Measure( nIterations, [&] { fnRebuild( nullptr ); } );
+			fError = std::max( fError, Compare( aReference, aTransforms ) );
+		}
+		system.setSimdLevel( eSupported );
+		const double dThreaded = Measure( nIterations, [&] { fnRebuild( &pool ); } );
+		fError = std::max( fError, Compare( aReference, aTransforms ) );
+
+		const bool bSame = fError < 1e-4f;
+		bAllSame &= bSame;
+		std::printf( "%-8zu %12.3f %12.3f %12.3f %12.3f %12.3f %8.2fx %g%s\n", nCount, dSingle, aBatched[0], aBatched[1],
+			aBatched[2], dThreaded, dSingle / std::max( dThreaded, 1e-6 ), fError, bSame ? "" : " DIFFERENT" );
+	}
+
+	return bAllSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,6 @@
+#version 460
+
+// Depth only, the color writes are masked off.
+void main()
+{
+}
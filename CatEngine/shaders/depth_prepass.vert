@@ -0,0 +1,27 @@
+#version 460
+
+layout( location = 0 ) in vec3 position;
+
+// Per instance, only the model matrix of CatModel::Instance.
+layout( location = 4 ) in mat4 instanceModelMatrix;
+
+layout( set = 0, binding = 0 ) uniform GlobalUbo
+{
+	mat4 projection;
+	mat4 view;
+	mat4 inverseView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterGrid;		// xyz is the number of clusters, w the number of lights
+	vec4 clusterDepth;		// near, far, depth slice log scale and bias
+	vec2 viewportSize;
+}
+ubo;
+
+// The opaque pass tests for equal depth, both have to compute the position the same way.
+invariant gl_Position;
+
+void main()
+{
+	vec4 positionWorld = instanceModelMatrix * vec4( position, 1.0 );
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+}
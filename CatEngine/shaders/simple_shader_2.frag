@@ -3,12 +3,13 @@
 layout( location = 0 ) in vec3 fragColor;
 layout( location = 1 ) in vec3 fragPosWorld;
 layout( location = 2 ) in vec3 fragNormalWorld;
+layout( location = 3 ) in float fragOpacity;
 
 layout( location = 0 ) out vec4 outColor;
 
 struct PointLight
 {
-	vec4 position; // ignore w
+	vec4 position; // w is the range
 	vec4 color;	   // w is intensity
 };
 
@@ -18,11 +19,29 @@ layout( set = 0, binding = 0 ) uniform GlobalUbo
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[16];
-	int numLights;
+	uvec4 clusterGrid;		// xyz is the number of clusters, w the number of lights
+	vec4 clusterDepth;		// near, far, depth slice log scale and bias
+	vec2 viewportSize;
 }
 ubo;
 
+// Filled by CatLightClusters every frame.
+layout( std430, set = 0, binding = 1 ) readonly buffer Lights
+{
+	PointLight lights[];
+};
+
+// Offset and count into the light indices per cluster.
+layout( std430, set = 0, binding = 2 ) readonly buffer Clusters
+{
+	uvec2 clusters[];
+};
+
+layout( std430, set = 0, binding = 3 ) readonly buffer LightIndices
+{
+	uint lightIndices[];
+};
+
 layout( push_constant ) uniform Push
 {
 	mat4 modelMatrix;
@@ -39,11 +58,21 @@ void main()
 	vec3 cameraPosWorld = ubo.invView[3].xyz;
 	vec3 viewDirection = normalize( cameraPosWorld - fragPosWorld );
 
-	for ( int i = 0; i < ubo.numLights; i++ )
+	// Same froxel the lights were binned into on the CPU, the depth is the clip space w.
+	float viewDepth = 1.0 / gl_FragCoord.w;
+	float slice = floor( log( viewDepth ) * ubo.clusterDepth.z + ubo.clusterDepth.w );
+	uvec3 cluster = uvec3( clamp( vec3( gl_FragCoord.xy / ubo.viewportSize * vec2( ubo.clusterGrid.xy ), slice ), vec3( 0.0 ),
+		vec3( ubo.clusterGrid.xyz - 1 ) ) );
+	uvec2 lightRange = clusters[cluster.x + ubo.clusterGrid.x * ( cluster.y + ubo.clusterGrid.y * cluster.z )];
+
+	for ( uint i = 0; i < lightRange.y; i++ )
 	{
-		PointLight light = ubo.pointLights[i];
+		PointLight light = lights[lightIndices[lightRange.x + i]];
 		vec3 directionToLight = light.position.xyz - fragPosWorld;
-		float attenuation = 1.0 / dot( directionToLight, directionToLight ); // distance squared
+		float distanceSquared = dot( directionToLight, directionToLight );
+		// Fades out towards the range, so the light doesn't end at the cluster borders.
+		float falloff = clamp( 1.0 - distanceSquared * distanceSquared / pow( light.position.w, 4.0 ), 0.0, 1.0 );
+		float attenuation = falloff * falloff / distanceSquared;
 		directionToLight = normalize( directionToLight );
 
 		float cosAngIncidence = max( dot( surfaceNormal, directionToLight ), 0.0 );
@@ -59,5 +88,5 @@ void main()
 		specularLight += intensity * blinnTerm;
 	}
 
-	outColor = vec4( diffuseLight * fragColor + specularLight * fragColor, 1.0 );
+	outColor = vec4( diffuseLight * fragColor + specularLight * fragColor, fragOpacity );
 }
@@ -8,12 +8,7 @@ layout( location = 3 ) in vec2 uv;
 layout( location = 0 ) out vec3 fragColor;
 layout( location = 1 ) out vec3 fragPosWorld;
 layout( location = 2 ) out vec3 fragNormalWorld;
-
-struct PointLight
-{
-	vec4 position; // ignore w
-	vec4 color;	   // w is intensity
-};
+layout( location = 3 ) out float fragOpacity;
 
 layout( set = 0, binding = 0 ) uniform GlobalUbo
 {
@@ -21,8 +16,9 @@ layout( set = 0, binding = 0 ) uniform GlobalUbo
 	mat4 view;
 	mat4 inverseView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
+	uvec4 clusterGrid;		// xyz is the number of clusters, w the number of lights
+	vec4 clusterDepth;		// near, far, depth slice log scale and bias
+	vec2 viewportSize;
 }
 ubo;
 
@@ -40,4 +36,5 @@ void main()
 	fragNormalWorld = normalize( mat3( push.normalMatrix ) * normal );
 	fragPosWorld = positionWorld.xyz;
 	fragColor = color;
+	fragOpacity = 1.0;
 }
@@ -0,0 +1,53 @@
+#version 460
+
+layout( location = 0 ) in vec3 position;
+layout( location = 1 ) in vec3 color;
+layout( location = 2 ) in vec3 normal;
+layout( location = 3 ) in vec2 uv;
+
+layout( location = 0 ) out vec3 fragColor;
+layout( location = 1 ) out vec3 fragPosWorld;
+layout( location = 2 ) out vec3 fragNormalWorld;
+layout( location = 3 ) out float fragOpacity;
+
+layout( set = 0, binding = 0 ) uniform GlobalUbo
+{
+	mat4 projection;
+	mat4 view;
+	mat4 inverseView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterGrid;		// xyz is the number of clusters, w the number of lights
+	vec4 clusterDepth;		// near, far, depth slice log scale and bias
+	vec2 viewportSize;
+}
+ubo;
+
+// CatGpuDrivenRenderSystem::ObjectData.
+struct ObjectData
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	vec4 sphere;
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint page;
+};
+
+layout( std430, set = 1, binding = 0 ) readonly buffer Objects
+{
+	ObjectData objects[];
+};
+
+void main()
+{
+	// gpu_cull.comp writes the object index as the first instance.
+	ObjectData object = objects[gl_InstanceIndex];
+
+	vec4 positionWorld = object.modelMatrix * vec4( position, 1.0 );
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+	fragNormalWorld = normalize( mat3( object.normalMatrix ) * normal );
+	fragPosWorld = positionWorld.xyz;
+	fragColor = color;
+	fragOpacity = 1.0;
+}
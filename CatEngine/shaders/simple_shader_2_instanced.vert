@@ -0,0 +1,41 @@
+#version 460
+
+layout( location = 0 ) in vec3 position;
+layout( location = 1 ) in vec3 color;
+layout( location = 2 ) in vec3 normal;
+layout( location = 3 ) in vec2 uv;
+
+// Per instance, CatModel::Instance.
+layout( location = 4 ) in mat4 instanceModelMatrix;
+layout( location = 8 ) in mat4 instanceNormalMatrix;
+layout( location = 12 ) in float instanceOpacity;
+
+layout( location = 0 ) out vec3 fragColor;
+layout( location = 1 ) out vec3 fragPosWorld;
+layout( location = 2 ) out vec3 fragNormalWorld;
+layout( location = 3 ) out float fragOpacity;
+
+layout( set = 0, binding = 0 ) uniform GlobalUbo
+{
+	mat4 projection;
+	mat4 view;
+	mat4 inverseView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterGrid;		// xyz is the number of clusters, w the number of lights
+	vec4 clusterDepth;		// near, far, depth slice log scale and bias
+	vec2 viewportSize;
+}
+ubo;
+
+// Has to match depth_prepass.vert for the equal depth test.
+invariant gl_Position;
+
+void main()
+{
+	vec4 positionWorld = instanceModelMatrix * vec4( position, 1.0 );
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+	fragNormalWorld = normalize( mat3( instanceNormalMatrix ) * normal );
+	fragPosWorld = positionWorld.xyz;
+	fragColor = color;
+	fragOpacity = instanceOpacity;
+}